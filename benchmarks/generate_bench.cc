@@ -0,0 +1,79 @@
+// Compares the ways of taking subtrees from the grammar, see `generate`:
+// mutation throughput without generation, for the types missing from the
+// library only, and mixed with the library entries, with the generated trees
+// per second and the valid mutants holding one.
+//
+// Usage: <dbms>_generate_bench <config.yml> <seed_dir> [rounds]
+
+#include <dirent.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "db.h"
+#include "yaml-cpp/yaml.h"
+
+namespace {
+std::vector<std::string> read_seeds(const std::string &dir) {
+  std::vector<std::string> seeds;
+  DIR *d = opendir(dir.c_str());
+  if (d == nullptr) return seeds;
+  while (struct dirent *entry = readdir(d)) {
+    if (entry->d_name[0] == '.') continue;
+    std::ifstream ifs(dir + "/" + entry->d_name);
+    std::stringstream buffer;
+    buffer << ifs.rdbuf();
+    seeds.push_back(buffer.str());
+  }
+  closedir(d);
+  return seeds;
+}
+
+void run(YAML::Node config, const char *mode,
+         const std::vector<std::string> &seeds, int rounds) {
+  config["generate"] = mode;
+  DataBase *db = create_database(config);
+  db->seed(1);
+
+  size_t test_cases = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    for (auto &seed : seeds) {
+      db->mutate(seed);
+      while (db->has_mutated_test_cases()) {
+        db->get_next_mutated_query();
+        ++test_cases;
+      }
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double seconds = std::chrono::duration<double>(elapsed).count();
+
+  std::printf("%-6s test cases: %8zu  cases/s: %10.1f\n", mode, test_cases,
+              seconds > 0 ? test_cases / seconds : 0.0);
+  std::printf("       %s\n", db->describe().c_str());
+  delete db;
+}
+};  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <config.yml> <seed_dir> [rounds]"
+              << std::endl;
+    return 1;
+  }
+  YAML::Node config = YAML::LoadFile(argv[1]);
+  std::vector<std::string> seeds = read_seeds(argv[2]);
+  int rounds = argc > 3 ? std::atoi(argv[3]) : 1;
+
+  for (const char *mode : {"off", "empty", "mixed"}) {
+    run(config, mode, seeds, rounds);
+  }
+  return 0;
+}
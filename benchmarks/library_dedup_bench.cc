@@ -0,0 +1,145 @@
+// Measures the membership checks on the mutation hot path: deduplicating
+// subtrees by hash when they enter the IR library, and testing node types
+// against the sets kept by the mutator. The former std::set plus std::find
+// versions are compared with absl::flat_hash_set and utils::DenseEnumSet.
+//
+// Usage: <dbms>_library_dedup_bench [seed]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "include/ast.h"
+#include "utils/enum_set.h"
+
+namespace {
+struct Entry {
+  IRTYPE type;
+  unsigned long hash;
+};
+
+// Roughly half of the entries repeat an earlier one, as happens when the
+// same seeds are parsed over and over.
+std::vector<Entry> make_entries(size_t count, std::mt19937_64 &rng) {
+  std::vector<Entry> entries(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (i > 0 && rng() % 2) {
+      entries[i] = entries[rng() % i];
+    } else {
+      entries[i] = {static_cast<IRTYPE>(rng() % kNodeTypeCount), rng()};
+    }
+  }
+  return entries;
+}
+
+template <typename F>
+double seconds_of(F &&f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+template <typename Library, typename Contains>
+size_t insert_all(const std::vector<Entry> &entries, Contains contains) {
+  Library library;
+  size_t inserted = 0;
+  for (auto &e : entries) {
+    auto &hashes = library[e.type];
+    if (contains(hashes, e.hash)) continue;
+    hashes.insert(e.hash);
+    ++inserted;
+  }
+  return inserted;
+}
+
+// The std::find version is quadratic; at a million entries it runs for
+// minutes, so it is only timed up to this size.
+constexpr size_t kMaxLinearEntries = 100000;
+
+void bench_library(size_t count, std::mt19937_64 &rng) {
+  auto entries = make_entries(count, rng);
+  size_t linear = 0, tree = 0, flat = 0;
+
+  double t_linear = -1;
+  if (count <= kMaxLinearEntries) {
+    t_linear = seconds_of([&] {
+      linear = insert_all<std::map<IRTYPE, std::set<unsigned long>>>(
+          entries, [](const std::set<unsigned long> &s, unsigned long h) {
+            return std::find(s.begin(), s.end(), h) != s.end();
+          });
+    });
+  }
+  double t_tree = seconds_of([&] {
+    tree = insert_all<std::map<IRTYPE, std::set<unsigned long>>>(
+        entries, [](const std::set<unsigned long> &s, unsigned long h) {
+          return s.count(h) != 0;
+        });
+  });
+  double t_flat = seconds_of([&] {
+    flat = insert_all<std::map<IRTYPE, absl::flat_hash_set<unsigned long>>>(
+        entries,
+        [](const absl::flat_hash_set<unsigned long> &s, unsigned long h) {
+          return s.contains(h);
+        });
+  });
+
+  if (t_linear < 0) linear = tree;
+  if (linear != tree || tree != flat) {
+    std::fprintf(stderr, "inserted counts differ: %zu %zu %zu\n", linear,
+                 tree, flat);
+    std::exit(1);
+  }
+  std::printf("%8zu entries (%7zu unique)  std::find: ", count, flat);
+  if (t_linear < 0) {
+    std::printf("%9s   ", "skipped");
+  } else {
+    std::printf("%9.2f ms", t_linear * 1e3);
+  }
+  std::printf("  set::count: %7.2f ms  flat_hash_set: %7.2f ms\n",
+              t_tree * 1e3, t_flat * 1e3);
+}
+
+void bench_type_sets(size_t lookups, std::mt19937_64 &rng) {
+  std::set<IRTYPE> tree;
+  utils::DenseEnumSet<IRTYPE, kNodeTypeCount> dense;
+  for (int i = 0; i < 16; ++i) {
+    auto type = static_cast<IRTYPE>(rng() % kNodeTypeCount);
+    tree.insert(type);
+    dense.insert(type);
+  }
+  std::vector<IRTYPE> probes(lookups);
+  for (auto &p : probes) p = static_cast<IRTYPE>(rng() % kNodeTypeCount);
+
+  size_t hits_linear = 0, hits_dense = 0;
+  double t_linear = seconds_of([&] {
+    for (auto p : probes)
+      hits_linear += std::find(tree.begin(), tree.end(), p) != tree.end();
+  });
+  double t_dense = seconds_of([&] {
+    for (auto p : probes) hits_dense += dense.count(p);
+  });
+
+  if (hits_linear != hits_dense) {
+    std::fprintf(stderr, "type lookups differ: %zu %zu\n", hits_linear,
+                 hits_dense);
+    std::exit(1);
+  }
+  std::printf("%8zu type lookups  std::find: %9.2f ms  DenseEnumSet: %7.2f ms\n",
+              lookups, t_linear * 1e3, t_dense * 1e3);
+}
+};  // namespace
+
+int main(int argc, char **argv) {
+  std::mt19937_64 rng(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 0);
+  for (size_t count : {10000, 100000, 1000000}) bench_library(count, rng);
+  bench_type_sets(10000000, rng);
+  return 0;
+}
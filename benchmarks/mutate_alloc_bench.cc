@@ -0,0 +1,91 @@
+// Counts heap allocations per generated test case with and without the
+// per-round IR arena.
+//
+// Usage: <dbms>_mutate_alloc_bench <config.yml> <seed_dir> [rounds]
+
+#include <dirent.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "db.h"
+#include "yaml-cpp/yaml.h"
+
+namespace {
+std::atomic<size_t> g_allocations{0};
+
+std::vector<std::string> read_seeds(const std::string &dir) {
+  std::vector<std::string> seeds;
+  DIR *d = opendir(dir.c_str());
+  if (d == nullptr) return seeds;
+  while (struct dirent *entry = readdir(d)) {
+    if (entry->d_name[0] == '.') continue;
+    std::ifstream ifs(dir + "/" + entry->d_name);
+    std::stringstream buffer;
+    buffer << ifs.rdbuf();
+    seeds.push_back(buffer.str());
+  }
+  closedir(d);
+  return seeds;
+}
+
+void run(YAML::Node config, bool use_arena,
+         const std::vector<std::string> &seeds, int rounds) {
+  config["ir_arena"] = use_arena;
+  DataBase *db = create_database(config);
+
+  size_t test_cases = 0;
+  size_t allocations_before = g_allocations.load();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    for (auto &seed : seeds) {
+      db->mutate(seed);
+      while (db->has_mutated_test_cases()) {
+        db->get_next_mutated_query();
+        ++test_cases;
+      }
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  size_t allocations = g_allocations.load() - allocations_before;
+  double seconds = std::chrono::duration<double>(elapsed).count();
+
+  std::printf("%-10s test cases: %8zu  allocations/case: %10.1f  cases/s: %10.1f\n",
+              use_arena ? "arena" : "heap", test_cases,
+              test_cases ? double(allocations) / test_cases : 0.0,
+              seconds > 0 ? test_cases / seconds : 0.0);
+  delete db;
+}
+};  // namespace
+
+void *operator new(size_t size) {
+  ++g_allocations;
+  if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <config.yml> <seed_dir> [rounds]"
+              << std::endl;
+    return 1;
+  }
+  YAML::Node config = YAML::LoadFile(argv[1]);
+  std::vector<std::string> seeds = read_seeds(argv[2]);
+  int rounds = argc > 3 ? std::atoi(argv[3]) : 1;
+
+  run(config, false, seeds, rounds);
+  run(config, true, seeds, rounds);
+  return 0;
+}
@@ -0,0 +1,143 @@
+// Compares IR::to_string against the former recursive serializer, which
+// built and trimmed a temporary string at every level of the tree. Every
+// subtree of every seed is serialized by both and must match byte for byte.
+//
+// Usage: <dbms>_serialize_bench <seed_dir> [rounds]
+
+#include <dirent.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "include/ast.h"
+#include "include/utils.h"
+
+namespace {
+#if defined(__SQUIRREL_SQLITE__)
+string legacy_to_string(IR *ir) {
+  string res;
+
+  if (ir->type_ == kColumnName && ir->str_val_ == "*") return ir->str_val_;
+  if (ir->type_ == kFilePath || ir->type_ == kPrepareTargetQuery ||
+      ir->type_ == kStringLiteral || ir->type_ == kIdentifier ||
+      ir->type_ == kOptOrderType || ir->type_ == kColumnType ||
+      ir->type_ == kSetType || ir->type_ == kOptJoinType ||
+      ir->type_ == kOptDistinct || ir->type_ == kNullLiteral)
+    return ir->str_val_;
+  if (ir->type_ == kIntLiteral) return std::to_string(ir->int_val_);
+  if (ir->type_ == kFloatLiteral || ir->type_ == kconst_float)
+    return std::to_string(ir->f_val_);
+  if (ir->type_ == kconst_str) return ir->str_val_;
+  if (ir->type_ == kconst_int) return std::to_string(ir->int_val_);
+
+  if (!ir->str_val_.empty()) return ir->str_val_;
+
+  if (ir->op_ != NULL) res += ir->op_->prefix_ + " ";
+  if (ir->left_ != NULL) res += legacy_to_string(ir->left_) + " ";
+  if (ir->op_ != NULL) res += ir->op_->middle_ + " ";
+  if (ir->right_ != NULL) res += legacy_to_string(ir->right_) + " ";
+  if (ir->op_ != NULL) res += ir->op_->suffix_;
+
+  trim_string(res);
+  return res;
+}
+#else
+string legacy_to_string_core(IR *ir) {
+  switch (ir->type_) {
+    case kIntLiteral:
+      return std::to_string(ir->int_val_);
+    case kFloatLiteral:
+      return std::to_string(ir->float_val_);
+    case kIdentifier:
+    case kStringLiteral:
+      return ir->str_val_;
+    default:
+      break;
+  }
+
+  string res;
+  if (ir->op_ != NULL) res += ir->op_->prefix_ + " ";
+  if (ir->left_ != NULL) res += legacy_to_string_core(ir->left_) + " ";
+  if (ir->op_ != NULL) res += ir->op_->middle_ + " ";
+  if (ir->right_ != NULL) res += legacy_to_string_core(ir->right_) + " ";
+  if (ir->op_ != NULL) res += ir->op_->suffix_;
+  return res;
+}
+
+string legacy_to_string(IR *ir) {
+  auto res = legacy_to_string_core(ir);
+  trim_string(res);
+  return res;
+}
+#endif
+
+std::vector<std::vector<IR *>> translate_seeds(const std::string &dir) {
+  std::vector<std::vector<IR *>> trees;
+  DIR *d = opendir(dir.c_str());
+  if (d == nullptr) return trees;
+  while (struct dirent *entry = readdir(d)) {
+    if (entry->d_name[0] == '.') continue;
+    std::ifstream ifs(dir + "/" + entry->d_name);
+    std::stringstream buffer;
+    buffer << ifs.rdbuf();
+    Program *program = parser(buffer.str());
+    if (program == NULL) continue;
+    std::vector<IR *> ir_set;
+    program->translate(ir_set);
+    program->deep_delete();
+    trees.push_back(std::move(ir_set));
+  }
+  closedir(d);
+  return trees;
+}
+
+template <typename Serializer>
+double time_roots(const std::vector<std::vector<IR *>> &trees, int rounds,
+                  Serializer serialize, size_t &bytes) {
+  bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    for (auto &ir_set : trees) bytes += serialize(ir_set.back()).size();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+};  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <seed_dir> [rounds]" << std::endl;
+    return 1;
+  }
+  auto trees = translate_seeds(argv[1]);
+  int rounds = argc > 2 ? std::atoi(argv[2]) : 100;
+
+  size_t subtrees = 0, mismatches = 0;
+  for (auto &ir_set : trees) {
+    for (IR *ir : ir_set) {
+      ++subtrees;
+      if (ir->to_string() != legacy_to_string(ir)) ++mismatches;
+    }
+  }
+  std::printf("trees: %zu  subtrees: %zu  mismatches: %zu\n", trees.size(),
+              subtrees, mismatches);
+
+  size_t legacy_bytes = 0, bytes = 0;
+  double legacy_seconds = time_roots(
+      trees, rounds, [](IR *ir) { return legacy_to_string(ir); },
+      legacy_bytes);
+  double seconds =
+      time_roots(trees, rounds, [](IR *ir) { return ir->to_string(); }, bytes);
+  std::printf("legacy:    %8.1f MB/s\n", legacy_bytes / legacy_seconds / 1e6);
+  std::printf("streaming: %8.1f MB/s\n", bytes / seconds / 1e6);
+
+  for (auto &ir_set : trees) deep_delete(ir_set.back());
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+// Compares the startup of a mutator that parses its `init_lib` with one that
+// loads the same libraries from a snapshot, and checks that the snapshot of
+// the loaded libraries is byte for byte the one that was loaded.
+//
+// Usage: <dbms>_startup_bench <config.yml> [rounds]
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "db.h"
+#include "yaml-cpp/yaml.h"
+
+namespace {
+template <typename F>
+double seconds_of(F &&f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+std::string read_file(const std::string &path) {
+  std::ifstream ifs(path, std::ios::binary);
+  std::stringstream buffer;
+  buffer << ifs.rdbuf();
+  return buffer.str();
+}
+};  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <config.yml> [rounds]" << std::endl;
+    return 1;
+  }
+  YAML::Node config = YAML::LoadFile(argv[1]);
+  config.remove("lib_snapshot");
+  int rounds = argc > 2 ? std::atoi(argv[2]) : 3;
+  std::string db_name = config["db"].as<std::string>();
+  std::string snapshot =
+      "/tmp/squirrel_startup_bench." + std::to_string(getpid());
+
+  double parse = 0, load = 0;
+  for (int i = 0; i < rounds; ++i) {
+    std::unique_ptr<DataBase> db;
+    parse += seconds_of([&] { db.reset(create_database(config)); });
+    if (i == 0 && !db->save_library(snapshot)) {
+      std::cerr << "Cannot write " << snapshot << std::endl;
+      return 1;
+    }
+  }
+  for (int i = 0; i < rounds; ++i) {
+    std::unique_ptr<DataBase> db(new_database(db_name));
+    bool loaded = false;
+    load += seconds_of([&] { loaded = db->load_library(snapshot); });
+    if (!loaded) {
+      std::cerr << "Cannot load " << snapshot << std::endl;
+      return 1;
+    }
+    if (i == 0) {
+      db->save_library(snapshot + ".copy");
+      if (read_file(snapshot) != read_file(snapshot + ".copy")) {
+        std::cerr << "The snapshot changed after a round trip" << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  std::printf("snapshot: %zu bytes\n", read_file(snapshot).size());
+  std::printf("parse init_lib: %8.2f ms\n", parse / rounds * 1e3);
+  std::printf("load snapshot:  %8.2f ms\n", load / rounds * 1e3);
+  std::remove(snapshot.c_str());
+  std::remove((snapshot + ".copy").c_str());
+  return 0;
+}
@@ -0,0 +1,67 @@
+// Measures Program::translate throughput on a directory of seeds.
+//
+// Usage: <dbms>_translate_bench <seed_dir> [rounds]
+
+#include <dirent.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "include/ast.h"
+#include "include/utils.h"
+
+namespace {
+std::vector<Program *> parse_seeds(const std::string &dir) {
+  std::vector<Program *> programs;
+  DIR *d = opendir(dir.c_str());
+  if (d == nullptr) return programs;
+  while (struct dirent *entry = readdir(d)) {
+    if (entry->d_name[0] == '.') continue;
+    std::ifstream ifs(dir + "/" + entry->d_name);
+    std::stringstream buffer;
+    buffer << ifs.rdbuf();
+    if (Program *program = parser(buffer.str())) programs.push_back(program);
+  }
+  closedir(d);
+  return programs;
+}
+};  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <seed_dir> [rounds]" << std::endl;
+    return 1;
+  }
+  std::vector<Program *> programs = parse_seeds(argv[1]);
+  int rounds = argc > 2 ? std::atoi(argv[2]) : 100;
+
+  size_t nodes = 0;
+  std::chrono::steady_clock::duration elapsed{};
+  std::vector<IR *> ir_set;
+  for (int i = 0; i < rounds; ++i) {
+    for (Program *program : programs) {
+      auto start = std::chrono::steady_clock::now();
+      program->translate(ir_set);
+      elapsed += std::chrono::steady_clock::now() - start;
+
+      nodes += ir_set.size();
+      deep_delete(ir_set.back());
+      ir_set.clear();
+    }
+  }
+  double seconds = std::chrono::duration<double>(elapsed).count();
+
+  std::printf("programs: %zu  rounds: %d  nodes: %zu\n", programs.size(),
+              rounds, nodes);
+  std::printf("translate: %.1f programs/s  %.1f nodes/s\n",
+              seconds > 0 ? programs.size() * rounds / seconds : 0.0,
+              seconds > 0 ? nodes / seconds : 0.0);
+  for (Program *program : programs) program->deep_delete();
+  return 0;
+}
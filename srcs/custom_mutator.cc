@@ -1,23 +1,60 @@
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <stack>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "afl-fuzz.h"
 #include "config_validate.h"
 #include "db.h"
 #include "env.h"
+#include "mutant_pipeline.h"
+#include "utils/batch.h"
 #include "yaml-cpp/yaml.h"
 
+// Queue entries slower than `slow_seed_ms` are fuzzed one time in this many.
+constexpr uint64_t kSlowSeedOdds = 10;
+
 struct SquirrelMutator {
   SquirrelMutator(DataBase *db) : database(db) {}
-  ~SquirrelMutator() { delete database; }
+  ~SquirrelMutator() {
+    if (slow_seed_us != 0) {
+      std::cerr << "slow seeds: " << slow_seeds_skipped << " of "
+                << slow_seeds_seen << " skipped" << std::endl;
+    }
+    if (pipeline) std::cerr << pipeline->describe() << std::endl;
+    // The producer thread uses the database until it is joined.
+    pipeline.reset();
+    std::string stats = database->describe();
+    if (!stats.empty()) std::cerr << stats << std::endl;
+    delete database;
+  }
   DataBase *database;
+  // Set when `mutant_pipeline` is configured; it then owns `database`.
+  std::unique_ptr<MutantPipeline> pipeline;
+  // Mutants packed into each input, for db_driver's batch mode.
+  size_t batch_size = 1;
+  afl_state_t *afl = nullptr;
+  // Set by `slow_seed_ms`; 0 fuzzes every queue entry alike.
+  uint64_t slow_seed_us = 0;
+  uint64_t slow_seeds_seen = 0;
+  uint64_t slow_seeds_skipped = 0;
   std::string current_input;
+  std::string introspection;
 };
 
+// Takes the next mutant into `mutant`; returns false if there is none.
+static bool next_mutant(SquirrelMutator *mutator, std::string &mutant) {
+  if (mutator->pipeline) return mutator->pipeline->next(mutant);
+  if (!mutator->database->has_mutated_test_cases()) return false;
+  mutant = mutator->database->get_next_mutated_query();
+  return true;
+}
+
 extern "C" {
 
 void *afl_custom_init(afl_state_t *afl, unsigned int seed) {
@@ -33,8 +70,34 @@ void *afl_custom_init(afl_state_t *afl, unsigned int seed) {
   if (!utils::validate_db_config(config)) {
     std::cerr << "Invalid config!" << std::endl;
   }
-  auto *mutator = create_database(config);
-  return new SquirrelMutator(mutator);
+  // The operator probabilities go next to fuzzer_stats unless set.
+  if (config["operator_schedule"] && !config["operator_stats"] &&
+      afl != nullptr && afl->out_dir != nullptr) {
+    config["operator_stats"] =
+        std::string(reinterpret_cast<const char *>(afl->out_dir)) +
+        "/operator_stats";
+  }
+  auto *mutator = new SquirrelMutator(create_database(config));
+  mutator->afl = afl;
+  // AFL++ draws `seed` from its own generator, which `-s` fixes.
+  mutator->database->seed(seed);
+  if (config["slow_seed_ms"]) {
+    mutator->slow_seed_us = config["slow_seed_ms"].as<uint64_t>() * 1000;
+  }
+  // Mutants are made on a background thread, up to this many ahead of the
+  // fuzzer.
+  if (config["mutant_pipeline"]) {
+    size_t capacity = config["mutant_pipeline"].as<size_t>();
+    if (capacity != 0) {
+      mutator->pipeline =
+          std::make_unique<MutantPipeline>(mutator->database, capacity);
+    }
+  }
+  if (config["batch_size"]) {
+    mutator->batch_size =
+        std::max<size_t>(1, config["batch_size"].as<size_t>());
+  }
+  return mutator;
 }
 
 void afl_custom_deinit(SquirrelMutator *data) { delete data; }
@@ -46,24 +109,80 @@ u8 afl_custom_queue_new_entry(SquirrelMutator *mutator,
   std::ifstream ifs((const char *)filename_new_queue);
   std::string content((std::istreambuf_iterator<char>(ifs)),
                       (std::istreambuf_iterator<char>()));
-  mutator->database->save_interesting_query(content);
+  for (std::string_view part : utils::split_batch(content)) {
+    std::string query(part);
+    if (mutator->pipeline) {
+      mutator->pipeline->save_interesting_query(std::move(query));
+    } else {
+      mutator->database->save_interesting_query(query);
+    }
+  }
+  return false;
+}
+
+// Test cases that run into the client's statement timeout, or close to it,
+// take that long on every execution. AFL++ asks before fuzzing each queue
+// entry, and the slow ones are skipped most of the time.
+u8 afl_custom_queue_get(SquirrelMutator *mutator,
+                        const unsigned char *filename) {
+  if (mutator->slow_seed_us == 0 || mutator->afl == nullptr ||
+      mutator->afl->queue_cur == nullptr ||
+      mutator->afl->queue_cur->exec_us < mutator->slow_seed_us) {
+    return true;
+  }
+  if (++mutator->slow_seeds_seen % kSlowSeedOdds == 0) return true;
+  ++mutator->slow_seeds_skipped;
   return false;
 }
 
 unsigned int afl_custom_fuzz_count(SquirrelMutator *mutator,
                                    const unsigned char *buf, size_t buf_size) {
   std::string sql((const char *)buf, buf_size);
-  return mutator->database->mutate(sql);
+  if (mutator->batch_size == 1) {
+    if (mutator->pipeline) return mutator->pipeline->submit(sql);
+    return mutator->database->mutate(sql);
+  }
+
+  // The seeds are batches too, whose test cases are mutated one by one.
+  // Both calls return the mutants ready so far.
+  size_t available = 0;
+  for (std::string_view part : utils::split_batch(sql)) {
+    std::string test_case(part);
+    available = std::max(available, mutator->pipeline
+                                        ? mutator->pipeline->submit(test_case)
+                                        : mutator->database->mutate(test_case));
+  }
+  return (available + mutator->batch_size - 1) / mutator->batch_size;
 }
 
 size_t afl_custom_fuzz(SquirrelMutator *mutator, uint8_t *buf, size_t buf_size,
                        u8 **out_buf, uint8_t *add_buf,
                        size_t add_buf_size,  // add_buf can be NULL
                        size_t max_size) {
-  DataBase *db = mutator->database;
-  assert(db->has_mutated_test_cases());
-  mutator->current_input = db->get_next_mutated_query();
+  if (mutator->batch_size > 1) {
+    std::vector<std::string> batch;
+    std::string mutant;
+    while (batch.size() < mutator->batch_size && next_mutant(mutator, mutant)) {
+      batch.push_back(std::move(mutant));
+    }
+    mutator->current_input = utils::join_batch(batch);
+  } else if (mutator->pipeline) {
+    // `afl_custom_fuzz_count` only counts mutants already in the ring, so
+    // this does not fail; an empty result would make AFL++ skip the call.
+    if (!mutator->pipeline->next(mutator->current_input)) return 0;
+  } else {
+    DataBase *db = mutator->database;
+    assert(db->has_mutated_test_cases());
+    mutator->current_input = db->get_next_mutated_query();
+  }
   *out_buf = (u8 *)mutator->current_input.c_str();
   return mutator->current_input.size();
 }
+
+const char *afl_custom_introspection(SquirrelMutator *mutator) {
+  // The database belongs to the producer thread while there is a pipeline.
+  mutator->introspection = mutator->pipeline ? mutator->pipeline->describe()
+                                             : mutator->database->describe();
+  return mutator->introspection.c_str();
+}
 }
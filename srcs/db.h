@@ -1,5 +1,7 @@
 #ifndef __DB_H__
 #define __DB_H__
+#include <cstdint>
+
 #include "yaml-cpp/yaml.h"
 
 class DataBase {
@@ -15,8 +17,26 @@ class DataBase {
   virtual bool save_interesting_query(const std::string &) = 0;
   // Clean up the enviroment, e.g., drop all the databases.
   virtual bool clean_up() { return true; }
+  // Write the mutator libraries to a binary snapshot.
+  virtual bool save_library(const std::string &) { return false; }
+  // Replace the mutator libraries with the ones of a snapshot. The libraries
+  // are left untouched if the snapshot cannot be used.
+  virtual bool load_library(const std::string &) { return false; }
+  // Seeds the random draws of the mutator, so that a fixed seed makes the
+  // same mutants.
+  virtual void seed(uint64_t) {}
+  // Makes again, on its own, the mutant of a seed that a trace describes,
+  // see utils::MutationTrace. Returns false if it cannot.
+  virtual bool replay(const std::string &, const std::string &,
+                      std::string *) {
+    return false;
+  }
+  // One line of statistics for the fuzzer's log, or "" if there are none.
+  virtual std::string describe() { return ""; }
   virtual ~DataBase(){};
 };
 
 DataBase *create_database(YAML::Node config);
+// Like `create_database`, but without calling `initialize`.
+DataBase *new_database(const std::string &db_name);
 #endif  // __DB_H__
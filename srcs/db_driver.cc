@@ -10,18 +10,28 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <dirent.h>
 #include <sys/shm.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "absl/strings/str_format.h"
 #include "client.h"
 #include "config.h"
 #include "env.h"
+#include "server_process.h"
 #include "types.h"
+#include "utils/batch.h"
 #include "yaml-cpp/yaml.h"
 
 u8 *__afl_area_ptr;
@@ -150,6 +160,106 @@ static u32 __afl_next_testcase(u8 *buf, u32 max_len) {
   return status;
 }
 
+// How often the driver reports the time spent resetting the environment.
+constexpr uint64_t kResetStatsInterval = 10000;
+// How long the server may take to start, see `startup_timeout_ms`.
+constexpr std::chrono::milliseconds kDefaultStartupTimeout(30000);
+
+// Where the driver puts the test cases of a batch that AFL++ should see on
+// their own: those with new coverage go to `queue`, those that crashed the
+// server to `crashes`. The directory is laid out like the output of another
+// AFL++ instance, so that a fuzzer started with -M or -S, whose -o directory
+// holds it, imports the queue when it syncs.
+class BatchOutput {
+ public:
+  explicit BatchOutput(std::string dir) : dir_(std::move(dir)) {
+    for (const char *sub : {"", "/queue", "/crashes"}) {
+      mkdir((dir_ + sub).c_str(), 0700);
+    }
+    // AFL++ only imports ids above the ones it synced already.
+    queued_ = count_entries(dir_ + "/queue");
+    crashes_ = count_entries(dir_ + "/crashes");
+  }
+
+  void save(std::string_view test_case, bool crash) {
+    uint64_t id = crash ? crashes_++ : queued_++;
+    std::string path = absl::StrFormat("%s/%s/id:%06d", dir_,
+                                       crash ? "crashes" : "queue", id);
+    // Written aside and renamed, so that AFL++ never reads half a file.
+    std::string temporary = dir_ + "/.cur_input";
+    std::ofstream(temporary, std::ios::binary | std::ios::trunc)
+        .write(test_case.data(), test_case.size());
+    rename(temporary.c_str(), path.c_str());
+  }
+
+  uint64_t queued() const { return queued_; }
+  uint64_t crashes() const { return crashes_; }
+
+ private:
+  static uint64_t count_entries(const std::string &dir) {
+    uint64_t count = 0;
+    if (DIR *d = opendir(dir.c_str())) {
+      while (dirent *entry = readdir(d)) {
+        if (strncmp(entry->d_name, "id:", 3) == 0) ++count;
+      }
+      closedir(d);
+    }
+    return count;
+  }
+
+  std::string dir_;
+  uint64_t queued_ = 0;
+  uint64_t crashes_ = 0;
+};
+
+// Test cases the client stopped at `statement_timeout_ms`.
+static uint64_t timeouts = 0;
+
+static client::ExecutionStatus run_test_case(client::DBClient *database,
+                                             client::ServerProcess &server,
+                                             std::string_view test_case) {
+  database->timed_prepare_env();
+
+  client::ExecutionStatus status =
+      database->execute(test_case.data(), test_case.size());
+  if (status == client::kTimeout) ++timeouts;
+
+  if (status == client::kServerCrash) {
+    std::chrono::milliseconds downtime = server.recover();
+    std::cerr << absl::StrFormat("driver: server back after %d ms",
+                                 downtime.count())
+              << std::endl;
+  }
+  database->timed_clean_up_env();
+  return status;
+}
+
+// Runs the test cases of a batch one after the other, each in its own
+// environment, until one crashes the server. The map of each one is taken
+// apart to find those with new coverage, and AFL++ gets the union.
+static client::ExecutionStatus run_batch(
+    client::DBClient *database, client::ServerProcess &server,
+    const std::vector<std::string_view> &test_cases,
+    utils::BatchCoverage &coverage, BatchOutput *output) {
+  bool has_map = __afl_area_ptr != nullptr;
+  coverage.begin();
+  client::ExecutionStatus result = client::kNormal;
+  for (std::string_view test_case : test_cases) {
+    if (has_map) memset(__afl_area_ptr, 0, __afl_map_size);
+    client::ExecutionStatus status = run_test_case(database, server, test_case);
+    bool found = has_map && coverage.add(__afl_area_ptr);
+    if (output != nullptr && (found || status == client::kServerCrash)) {
+      output->save(test_case, status == client::kServerCrash);
+    }
+    if (status == client::kServerCrash) {
+      result = status;
+      break;
+    }
+  }
+  if (has_map) coverage.finish(__afl_area_ptr);
+  return result;
+}
+
 static void __afl_end_testcase(client::ExecutionStatus status) {
   int waitpid_status = 0xffffff;
   if (status == client::kServerCrash) {
@@ -187,30 +297,65 @@ int main(int argc, char *argv[]) {
   // Start the database server. In case that the driver
   // is stopped and restarted, we should not start another server.
   __afl_map_shm();
-  if (!database->check_alive()) {
-    system(startup_cmd.c_str());
-    sleep(5);
+  std::chrono::milliseconds startup_timeout = kDefaultStartupTimeout;
+  if (config["startup_timeout_ms"]) {
+    startup_timeout =
+        std::chrono::milliseconds(config["startup_timeout_ms"].as<int>());
+  }
+  client::ServerProcess server(
+      startup_cmd, [database] { return database->check_alive(); },
+      startup_timeout);
+  if (!server.start()) {
+    std::cerr << absl::StrFormat("The server is not up after %d ms.\n",
+                                 startup_timeout.count());
+    exit(-1);
   }
 
+  // Inputs that hold several test cases, see utils/batch.h, are run as a
+  // batch.
+  std::unique_ptr<utils::BatchCoverage> batch_coverage;
+  std::unique_ptr<BatchOutput> batch_output;
+  if (config["batch_sync_dir"]) {
+    batch_output = std::make_unique<BatchOutput>(
+        config["batch_sync_dir"].as<std::string>());
+  }
+  uint64_t batches = 0;
+  uint64_t next_report = kResetStatsInterval;
+
   __afl_start_forkserver();
 
   while ((len = __afl_next_testcase(buf, kMaxInputSize)) > 0) {
-    std::string query((const char *)buf, len);
-    database->prepare_env();
-
-    client::ExecutionStatus status = database->execute((const char *)buf, len);
+    std::vector<std::string_view> test_cases =
+        utils::split_batch(std::string_view((const char *)buf, len));
+    client::ExecutionStatus status;
+    if (test_cases.size() == 1) {
+      status = run_test_case(database, server, test_cases[0]);
+    } else {
+      if (batch_coverage == nullptr) {
+        batch_coverage = std::make_unique<utils::BatchCoverage>(__afl_map_size);
+      }
+      status = run_batch(database, server, test_cases, *batch_coverage,
+                         batch_output.get());
+      ++batches;
+    }
 
     __afl_area_ptr[0] = 1;
     /* report the test case is done and wait for the next */
+    __afl_end_testcase(status);
 
-    if (status == client::kServerCrash) {
-      while (!database->check_alive()) {
-        // Wait for the server to be restart.
-        sleep(5);
+    if (database->reset_stats().test_cases >= next_report) {
+      next_report += kResetStatsInterval;
+      std::cerr << database->describe_reset() << std::endl;
+      std::cerr << server.describe() << std::endl;
+      std::cerr << absl::StrFormat("driver: %d timeouts", timeouts);
+      if (batches != 0) {
+        std::cerr << absl::StrFormat(
+            ", %d batches, %d test cases queued %d crashes saved", batches,
+            batch_output ? batch_output->queued() : 0,
+            batch_output ? batch_output->crashes() : 0);
       }
+      std::cerr << std::endl;
     }
-    database->clean_up_env();
-    __afl_end_testcase(status);
   }
   assert(false && "Crash on parent?");
 
@@ -14,8 +14,7 @@
 
 //#include "db.h"
 
-DataBase* create_database(YAML::Node config) {
-  const std::string db_name = config["db"].as<std::string>();
+DataBase* new_database(const std::string& db_name) {
   DataBase* result = nullptr;
   if (db_name == "sqlite") {
 #ifdef __SQUIRREL_SQLITE__
@@ -33,6 +32,11 @@ DataBase* create_database(YAML::Node config) {
     assert(false && "Unreachable");
   }
   assert(result && "Unreachable");
+  return result;
+}
+
+DataBase* create_database(YAML::Node config) {
+  DataBase* result = new_database(config["db"].as<std::string>());
   result->initialize(config);
   return result;
 }
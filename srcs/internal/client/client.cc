@@ -1,8 +1,12 @@
 #include "client.h"
 
+#include <algorithm>
 #include <cassert>
+#include <iostream>
 #include <string>
 
+#include "absl/strings/str_format.h"
+
 #ifdef __SQUIRREL_MYSQL__
 #include "client_mysql.h"
 #endif
@@ -12,6 +16,79 @@
 #endif
 
 namespace client {
+bool parse_reset_strategy(const std::string &name, ResetStrategy *strategy) {
+  if (name == "recreate") {
+    *strategy = ResetStrategy::kRecreate;
+  } else if (name == "template") {
+    *strategy = ResetStrategy::kTemplate;
+  } else if (name == "pool") {
+    *strategy = ResetStrategy::kPool;
+  } else if (name == "rollback") {
+    *strategy = ResetStrategy::kRollback;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char *reset_strategy_name(ResetStrategy strategy) {
+  switch (strategy) {
+    case ResetStrategy::kRecreate:
+      return "recreate";
+    case ResetStrategy::kTemplate:
+      return "template";
+    case ResetStrategy::kPool:
+      return "pool";
+    case ResetStrategy::kRollback:
+      return "rollback";
+  }
+  return "unknown";
+}
+
+void DBClient::timed_prepare_env() {
+  auto start = std::chrono::steady_clock::now();
+  prepare_env();
+  reset_stats_.prepare += std::chrono::steady_clock::now() - start;
+  ++reset_stats_.test_cases;
+}
+
+void DBClient::timed_clean_up_env() {
+  auto start = std::chrono::steady_clock::now();
+  clean_up_env();
+  reset_stats_.clean_up += std::chrono::steady_clock::now() - start;
+}
+
+std::string DBClient::describe_reset() const {
+  const ResetStats &stats = reset_stats_;
+  auto average_us = [&stats](std::chrono::nanoseconds total) {
+    return stats.test_cases ? total.count() / 1000.0 / stats.test_cases : 0;
+  };
+  return absl::StrFormat(
+      "reset strategy %s: %d test cases, %.1f us to prepare and %.1f us to "
+      "clean up on average, %d fallbacks",
+      reset_strategy_name(reset_strategy_), stats.test_cases,
+      average_us(stats.prepare), average_us(stats.clean_up), stats.fallbacks);
+}
+
+void DBClient::read_reset_strategy(
+    const YAML::Node &config, std::initializer_list<ResetStrategy> supported) {
+  if (!config["reset_strategy"]) return;
+  std::string name = config["reset_strategy"].as<std::string>();
+  ResetStrategy strategy;
+  if (!parse_reset_strategy(name, &strategy)) {
+    std::cerr << "Unknown reset_strategy " << name << std::endl;
+    return;
+  }
+  if (strategy != ResetStrategy::kRecreate &&
+      std::find(supported.begin(), supported.end(), strategy) ==
+          supported.end()) {
+    std::cerr << "This client does not support reset_strategy " << name
+              << ", using recreate." << std::endl;
+    return;
+  }
+  reset_strategy_ = strategy;
+}
+
 DBClient *create_client(const std::string &db_name, const YAML::Node &config) {
   DBClient *result = nullptr;
   if (db_name == "mysql") {
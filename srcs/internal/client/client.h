@@ -1,7 +1,10 @@
 #ifndef __CLIENT_H__
 #define __CLIENT_H__
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <string>
 
 #include "yaml-cpp/yaml.h"
@@ -18,14 +21,62 @@ enum ExecutionStatus {
   kSemanticError
 };
 
+// How a client gives each test case a clean environment, selected by the
+// `reset_strategy` option. Each client supports kRecreate and some of the
+// others.
+enum class ResetStrategy {
+  // Create a database (MySQL) or schema (PostgreSQL) for every test case and
+  // drop it afterwards.
+  kRecreate,
+  // PostgreSQL: clone every database from the `reset_template` database.
+  kTemplate,
+  // MySQL: take the databases from a pool, which a background thread drops
+  // and creates again once they are used.
+  kPool,
+  // PostgreSQL: run the test case in a transaction and roll it back, unless
+  // it has statements that cannot run in one.
+  kRollback,
+};
+
+// Parses the `reset_strategy` option. Returns false for an unknown name.
+bool parse_reset_strategy(const std::string &name, ResetStrategy *strategy);
+const char *reset_strategy_name(ResetStrategy strategy);
+
+// The time a client spends resetting the environment around test cases.
+struct ResetStats {
+  uint64_t test_cases = 0;
+  std::chrono::nanoseconds prepare{0};
+  std::chrono::nanoseconds clean_up{0};
+  // Test cases the strategy could not handle, which were reset with
+  // kRecreate instead.
+  uint64_t fallbacks = 0;
+};
+
 class DBClient {
  public:
+  virtual ~DBClient() = default;
   virtual void initialize(YAML::Node) = 0;
   virtual bool check_alive() = 0;
   // Set up a clean environment for execution.
   virtual void prepare_env() = 0;
   virtual ExecutionStatus execute(const char *query, size_t size) = 0;
   virtual void clean_up_env() {}
+
+  // prepare_env and clean_up_env, timed in `reset_stats`.
+  void timed_prepare_env();
+  void timed_clean_up_env();
+  const ResetStats &reset_stats() const { return reset_stats_; }
+  virtual std::string describe_reset() const;
+
+ protected:
+  // Reads `reset_strategy` from the config. Strategies the client does not
+  // support, i.e. those but kRecreate missing from `supported`, are reported
+  // and replaced by kRecreate.
+  void read_reset_strategy(const YAML::Node &config,
+                           std::initializer_list<ResetStrategy> supported);
+
+  ResetStrategy reset_strategy_ = ResetStrategy::kRecreate;
+  ResetStats reset_stats_;
 };
 
 DBClient *create_client(const std::string &db_name, const YAML::Node &config);
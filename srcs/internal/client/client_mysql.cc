@@ -2,21 +2,32 @@
 
 #include <unistd.h>
 
+#include <chrono>
 #include <cstring>
 #include <deque>
 #include <iostream>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "mysql.h"
+#include "mysql_status.h"
 #include "mysqld_error.h"
 
 using namespace std;
+static_assert(client::kMySQLServerGoneError == CR_SERVER_GONE_ERROR);
+static_assert(client::kMySQLServerLost == CR_SERVER_LOST);
+static_assert(client::kMySQLParseError == ER_PARSE_ERROR);
+
 namespace {
-bool is_crash_response(int response) {
-  return response == CR_SERVER_LOST || response == CR_SERVER_GONE_ERROR;
-}
+// How long the server has to honour its own statement time limit before the
+// client kills the query.
+constexpr auto kKillGrace = std::chrono::milliseconds(100);
+
+// How long a test case waits for the pool before it creates a database of
+// its own.
+constexpr auto kPoolTimeout = std::chrono::seconds(1);
 };  // namespace
 
 namespace client {
@@ -27,12 +38,59 @@ void MySQLClient::initialize(YAML::Node config) {
   passwd_ = config["passwd"].as<std::string>();
   sock_path_ = config["sock_path"].as<std::string>();
   db_prefix_ = config["db_prefix"].as<std::string>();
+  if (config["reuse_connection"]) {
+    reuse_connection_ = config["reuse_connection"].as<bool>();
+  }
+  read_reset_strategy(config, {ResetStrategy::kPool});
+  if (config["reset_pool_size"]) {
+    pool_size_ = config["reset_pool_size"].as<size_t>();
+  }
+  if (config["statement_timeout_ms"]) {
+    statement_timeout_ = std::chrono::milliseconds(
+        config["statement_timeout_ms"].as<unsigned int>());
+  }
+  if (statement_timeout_.count() != 0 && watchdog_ == nullptr) {
+    watchdog_ = std::make_unique<Watchdog>([this] { kill_query(); });
+  }
+}
+
+MySQLClient::~MySQLClient() {
+  // Stop the threads before closing their connections.
+  pool_.reset();
+  disconnect(recycler_);
+  watchdog_.reset();
+  disconnect(killer_);
+  disconnect(session_);
+  disconnect(admin_);
 }
 
 void MySQLClient::prepare_env() {
+  pooled_ = false;
+  if (reset_strategy_ == ResetStrategy::kPool) {
+    if (pool_ == nullptr) start_pool();
+    std::optional<std::string> name = pool_->acquire(kPoolTimeout);
+    if (name.has_value()) {
+      current_database_ = std::move(*name);
+      pooled_ = true;
+      if (reuse_connection_ && !reset_session(current_database_)) {
+        std::cerr << "Failed to reset the session." << std::endl;
+      }
+      return;
+    }
+    ++reset_stats_.fallbacks;
+  }
+
   ++database_id_;
-  std::string database_name = db_prefix_ + std::to_string(database_id_);
-  if (!create_database(database_name)) {
+  current_database_ = db_prefix_ + std::to_string(database_id_);
+  if (reuse_connection_) {
+    if (!admin_query("CREATE DATABASE IF NOT EXISTS " + current_database_ +
+                     ";") ||
+        !reset_session(current_database_)) {
+      std::cerr << "Failed to create database." << std::endl;
+    }
+    return;
+  }
+  if (!create_database(current_database_)) {
     std::cerr << "Failed to create database." << std::endl;
   }
 }
@@ -41,26 +99,87 @@ ExecutionStatus MySQLClient::execute(const char *query, size_t size) {
   // Create a connection for executing the query
   // Check the response.
   // Return status accordingly.
-  std::string database_name = db_prefix_ + std::to_string(database_id_);
-  std::optional<MYSQL> connection = create_connection(database_name);
+  if (reuse_connection_) {
+    if (session_ == nullptr) {
+      if ((session_ = connect(current_database_.c_str())) == nullptr) {
+        std::cerr << "Cannot creat connection at execute " << std::endl;
+        return kServerCrash;
+      }
+      limit_statement_time(*session_);
+    }
+    ExecutionStatus server_status = run_test_case(*session_, query, size);
+    if (server_status == kServerCrash) disconnect(session_);
+    return server_status;
+  }
+  std::optional<MYSQL> connection = create_connection(current_database_);
   if (!connection.has_value()) {
     std::cerr << "Cannot creat connection at execute " << std::endl;
     return kServerCrash;
   }
+  limit_statement_time(*connection);
 
-  int server_response = mysql_real_query(&(*connection), query, size);
-  if (is_crash_response(server_response)) {
+  ExecutionStatus server_status = run_test_case(*connection, query, size);
+  if (server_status == kServerCrash) {
     std::cerr << "Cannot mySQL_QUERY " << std::endl;
-    return kServerCrash;
   }
-  ExecutionStatus server_status = clean_up_connection(*connection);
   mysql_close(&(*connection));
   return server_status;
 }
 
+ExecutionStatus MySQLClient::run_test_case(MYSQL &connection,
+                                           const char *query, size_t size) {
+  if (watchdog_ != nullptr) {
+    killed_thread_id_ = mysql_thread_id(&connection);
+    watchdog_->arm(statement_timeout_ + kKillGrace);
+  }
+  int error = mysql_real_query(&connection, query, size) != 0
+                  ? mysql_errno(&connection)
+                  : 0;
+  ExecutionStatus results = is_crash_response(error)
+                                ? kServerCrash
+                                : clean_up_connection(connection);
+  bool killed = watchdog_ != nullptr && watchdog_->disarm();
+  return mysql_test_case_status(error, results, killed);
+}
+
+void MySQLClient::limit_statement_time(MYSQL &connection) {
+  if (statement_timeout_.count() == 0) return;
+  // MySQL limits SELECT statements only, MariaDB all of them.
+  std::string query =
+      strstr(mysql_get_server_info(&connection), "MariaDB") != nullptr
+          ? "SET SESSION max_statement_time = " +
+                std::to_string(statement_timeout_.count() / 1000.0)
+          : "SET SESSION max_execution_time = " +
+                std::to_string(statement_timeout_.count());
+  if (mysql_real_query(&connection, query.c_str(), query.size()) == 0) {
+    clean_up_connection(connection);
+  }
+}
+
+void MySQLClient::kill_query() {
+  // Runs on the watchdog's thread, which alone uses `killer_`.
+  std::string query = "KILL QUERY " + std::to_string(killed_thread_id_.load());
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    if (killer_ == nullptr && (killer_ = connect(nullptr)) == nullptr) return;
+    if (mysql_real_query(killer_, query.c_str(), query.size()) == 0) {
+      clean_up_connection(*killer_);
+      return;
+    }
+    if (!is_crash_response(mysql_errno(killer_))) return;
+    disconnect(killer_);
+  }
+}
+
 void MySQLClient::clean_up_env() {
-  std::string database_name = db_prefix_ + std::to_string(database_id_);
-  string reset_query = "DROP DATABASE IF EXISTS " + database_name + ";";
+  if (pooled_) {
+    pool_->release(current_database_);
+    return;
+  }
+  string reset_query = "DROP DATABASE IF EXISTS " + current_database_ + ";";
+  if (reuse_connection_) {
+    admin_query(reset_query);
+    return;
+  }
   std::optional<MYSQL> connection = create_connection("");
   if (!connection.has_value()) {
     return;
@@ -88,6 +207,12 @@ std::optional<MYSQL> MySQLClient::create_connection(std::string_view db_name) {
 }
 
 bool MySQLClient::check_alive() {
+  if (reuse_connection_) {
+    if (admin_ != nullptr && mysql_ping(admin_) == 0) return true;
+    disconnect(admin_);
+    admin_ = connect(nullptr);
+    return admin_ != nullptr;
+  }
   std::optional<MYSQL> connection = create_connection("");
   if (!connection.has_value()) {
     return false;
@@ -122,6 +247,86 @@ bool MySQLClient::create_database(const std::string &database) {
   return true;
 }
 
+MYSQL *MySQLClient::connect(const char *db_name) {
+  MYSQL *connection = mysql_init(nullptr);
+  if (connection == nullptr) return nullptr;
+
+  if (mysql_real_connect(connection, host_.c_str(), user_name_.c_str(),
+                         passwd_.c_str(), db_name, 0, sock_path_.c_str(),
+                         CLIENT_MULTI_STATEMENTS) == NULL) {
+    std::cerr << "Create connection failed: " << mysql_errno(connection)
+              << mysql_error(connection) << std::endl;
+    mysql_close(connection);
+    return nullptr;
+  }
+  return connection;
+}
+
+void MySQLClient::disconnect(MYSQL *&connection) {
+  if (connection != nullptr) mysql_close(connection);
+  connection = nullptr;
+}
+
+bool MySQLClient::admin_query(const std::string &query) {
+  // The first attempt may find the connection closed by a server restart.
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    if (admin_ == nullptr && (admin_ = connect(nullptr)) == nullptr) {
+      return false;
+    }
+    if (mysql_real_query(admin_, query.c_str(), query.size()) == 0) {
+      clean_up_connection(*admin_);
+      return true;
+    }
+    if (!is_crash_response(mysql_errno(admin_))) return false;
+    disconnect(admin_);
+  }
+  return false;
+}
+
+bool MySQLClient::reset_session(const std::string &database) {
+  // COM_RESET_CONNECTION drops what the last test case left in the session:
+  // variables, temporary tables, open transactions and locks.
+  if (session_ != nullptr && (mysql_reset_connection(session_) != 0 ||
+                              mysql_select_db(session_, database.c_str()))) {
+    disconnect(session_);
+  }
+  if (session_ == nullptr) session_ = connect(database.c_str());
+  if (session_ == nullptr) return false;
+  // The reset dropped the session's time limit too.
+  limit_statement_time(*session_);
+  return true;
+}
+
+std::string MySQLClient::describe_reset() const {
+  std::string result = DBClient::describe_reset();
+  if (pool_ != nullptr) result += "; " + pool_->describe();
+  return result;
+}
+
+void MySQLClient::start_pool() {
+  std::vector<std::string> names;
+  for (size_t i = 0; i < pool_size_; ++i) {
+    names.push_back(db_prefix_ + "pool" + std::to_string(i));
+  }
+  pool_ = std::make_unique<DatabasePool>(
+      std::move(names),
+      [this](const std::string &name) { return recycle_database(name); });
+}
+
+bool MySQLClient::recycle_database(const std::string &database) {
+  if (recycler_ == nullptr && (recycler_ = connect(nullptr)) == nullptr) {
+    return false;
+  }
+  std::string query = "DROP DATABASE IF EXISTS " + database +
+                      "; CREATE DATABASE " + database + ";";
+  if (mysql_real_query(recycler_, query.c_str(), query.size()) == 0 &&
+      clean_up_connection(*recycler_) == kNormal) {
+    return true;
+  }
+  if (is_crash_response(mysql_errno(recycler_))) disconnect(recycler_);
+  return false;
+}
+
 ExecutionStatus MySQLClient::clean_up_connection(MYSQL &mm) {
   int res = -1;
   do {
@@ -129,21 +334,6 @@ ExecutionStatus MySQLClient::clean_up_connection(MYSQL &mm) {
     if (q_result) mysql_free_result(q_result);
   } while ((res = mysql_next_result(&mm)) == 0);
 
-  if (res != -1) {
-    res = mysql_errno(&mm);
-    if (is_crash_response(res)) {
-      // std::cerr << "Found a crash!" << std::endl;
-      return kServerCrash;
-    }
-    if (res == ER_PARSE_ERROR) {
-      // std::cerr << "Syntax error" << std::endl;
-      return kSyntaxError;
-    } else {
-      // std::cerr << "Semantic error" << std::endl;
-      return kSemanticError;
-    }
-  }
-  // std::cerr << "Normal" << std::endl;
-  return kNormal;
+  return res != -1 ? mysql_error_status(mysql_errno(&mm)) : kNormal;
 }
 };  // namespace client
@@ -1,11 +1,16 @@
 #ifndef __CLIENT_MYSQL_H__
 #define __CLIENT_MYSQL_H__
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <memory>
 #include <optional>
 #include <string>
 
 #include "client.h"
+#include "database_pool.h"
+#include "watchdog.h"
 #include "mysql.h"
 #include "yaml-cpp/yaml.h"
 
@@ -13,18 +18,63 @@ namespace client {
 
 class MySQLClient : public DBClient {
  public:
+  virtual ~MySQLClient();
   virtual void initialize(YAML::Node);
   // Set up a clean environment for execution.
   virtual void prepare_env();
   virtual ExecutionStatus execute(const char *query, size_t size);
   virtual void clean_up_env();
   virtual bool check_alive();
+  virtual std::string describe_reset() const;
 
  private:
   ExecutionStatus clean_up_connection(MYSQL &);
   bool create_database(const std::string &database);
   std::optional<MYSQL> create_connection(const std::string_view db_name);
 
+  // With `reuse_connection`, the client keeps two connections open across
+  // test cases instead of connecting for every call: `admin_` creates and
+  // drops the databases, and `session_` runs the test cases. Both are null
+  // until needed, and after the server went away.
+  MYSQL *connect(const char *db_name);
+  void disconnect(MYSQL *&connection);
+  // Runs an administrative query, reconnecting once if `admin_` went stale.
+  bool admin_query(const std::string &query);
+  // Points `session_` to a fresh session on `database`.
+  bool reset_session(const std::string &database);
+
+  bool reuse_connection_ = false;
+  MYSQL *admin_ = nullptr;
+  MYSQL *session_ = nullptr;
+
+  // ResetStrategy::kPool: `pool_size_` databases named `db_prefix_` + "pool"
+  // + a number, recycled on the pool's thread through `recycler_`.
+  void start_pool();
+  bool recycle_database(const std::string &database);
+
+  size_t pool_size_ = 8;
+  std::unique_ptr<DatabasePool> pool_;
+  MYSQL *recycler_ = nullptr;
+  // Whether `current_database_` comes from the pool.
+  bool pooled_ = false;
+
+  // The database of the current test case.
+  std::string current_database_;
+
+  // Runs a test case on `connection`, within `statement_timeout_` if set.
+  ExecutionStatus run_test_case(MYSQL &connection, const char *query,
+                                size_t size);
+  // With `statement_timeout_ms`, the server is asked to stop statements that
+  // run longer, and `watchdog_` kills the query from `killer_`, a connection
+  // of its own, if the server did not.
+  void limit_statement_time(MYSQL &connection);
+  void kill_query();
+
+  std::chrono::milliseconds statement_timeout_{0};
+  std::unique_ptr<Watchdog> watchdog_;
+  MYSQL *killer_ = nullptr;
+  std::atomic<unsigned long> killed_thread_id_{0};
+
   unsigned int database_id_ = 0;
   std::string host_;
   std::string user_name_;
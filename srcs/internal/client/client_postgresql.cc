@@ -1,26 +1,29 @@
 #include "client_postgresql.h"
 
+#include <poll.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cstdint>
 #include <cstring>
 #include <deque>
 #include <iostream>
 #include <optional>
+#include <set>
 #include <string>
 #include <string_view>
 
 #include "absl/strings/str_format.h"
 #include "client.h"
 #include "libpq-fe.h"
+#include "postgresql_conninfo.h"
 
 using namespace std;
 namespace {
-PGconn *create_connection(std::string_view db_name) {
-  std::string conninfo =
-      absl::StrFormat("hostaddr=%s port=%d dbname=%s connect_timeout=4",
-                      "127.0.0.1", 5432, db_name);
-
-  std::cerr << "Connection info: " << conninfo << std::endl;
+PGconn *create_connection(const std::string &conninfo) {
   PGconn *result = PQconnectdb(conninfo.c_str());
   if (PQstatus(result) == CONNECTION_BAD) {
     fprintf(stderr, "Error1: %s\n", PQerrorMessage(result));
@@ -33,6 +36,98 @@ void reset_database(PGconn *conn) {
   auto res = PQexec(conn, "DROP SCHEMA public CASCADE; CREATE SCHEMA public;");
   PQclear(res);
 }
+
+// Runs a statement that returns no rows. Returns false if it failed.
+bool run_command(PGconn *conn, const char *command) {
+  auto res = PQexec(conn, command);
+  bool result = PQresultStatus(res) == PGRES_COMMAND_OK;
+  PQclear(res);
+  return result;
+}
+
+// How long the server has to honour statement_timeout before the client
+// cancels the query, and to honour the cancel before the client gives up on
+// the connection.
+constexpr auto kCancelGrace = std::chrono::milliseconds(100);
+constexpr auto kAbandonGrace = std::chrono::seconds(1);
+
+// Waits until a result can be read from `conn` without blocking. Once
+// `deadline` passes, cancels the query and waits some more. Returns false
+// if the query is still running after that.
+bool wait_for_result(PGconn *conn,
+                     std::chrono::steady_clock::time_point deadline,
+                     bool *cancelled) {
+  while (PQisBusy(conn)) {
+    // No deadline means no timeout.
+    int wait_ms = -1;
+    if (deadline != std::chrono::steady_clock::time_point::max()) {
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now());
+      wait_ms = std::clamp<int64_t>(left.count(), 0, INT_MAX);
+    }
+    pollfd socket = {PQsocket(conn), POLLIN, 0};
+    if (wait_ms != 0 && poll(&socket, 1, wait_ms) != 0) {
+      // Ready, or failed: either way PQgetResult will tell.
+      if (!PQconsumeInput(conn)) return true;
+      continue;
+    }
+    if (*cancelled) return false;
+    char error[256] = "";
+    PGcancel *cancel = PQgetCancel(conn);
+    if (cancel == nullptr || !PQcancel(cancel, error, sizeof(error))) {
+      fprintf(stderr, "Cannot cancel the query: %s\n", error);
+    }
+    if (cancel != nullptr) PQfreeCancel(cancel);
+    *cancelled = true;
+    deadline = std::chrono::steady_clock::now() + kAbandonGrace;
+  }
+  return true;
+}
+
+bool is_cancelled(const PGresult *res) {
+  const char *state = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+  // query_canceled, for statement_timeout and PQcancel alike.
+  return state != nullptr && strcmp(state, "57014") == 0;
+}
+
+// Whether `query` can run in a transaction that is rolled back afterwards:
+// none of its statements may end the transaction or refuse to run in one.
+// Statements are told apart by splitting at every ';', so a ';' in a string
+// literal only makes the check stricter.
+bool can_roll_back(const char *query, size_t size) {
+  static const std::set<std::string> kEndsTransaction = {
+      "COMMIT", "END", "ROLLBACK", "ABORT", "VACUUM", "DISCARD"};
+  // CREATE INDEX CONCURRENTLY, CREATE DATABASE, ALTER SYSTEM and so on.
+  static const std::set<std::string> kOutsideTransaction = {
+      "CONCURRENTLY", "DATABASE", "TABLESPACE", "SYSTEM", "SUBSCRIPTION"};
+
+  std::vector<std::string> words;
+  auto end_statement = [&] {
+    bool allowed =
+        words.empty() ||
+        (!kEndsTransaction.count(words[0]) &&
+         !(words[0] == "PREPARE" && words.size() > 1 &&
+           words[1] == "TRANSACTION"));
+    for (auto &word : words) {
+      if (kOutsideTransaction.count(word)) allowed = false;
+    }
+    words.clear();
+    return allowed;
+  };
+
+  std::string word;
+  for (size_t i = 0; i <= size; ++i) {
+    char c = i < size ? query[i] : ';';
+    if (isalnum(static_cast<unsigned char>(c)) || c == '_') {
+      word += toupper(static_cast<unsigned char>(c));
+      continue;
+    }
+    if (!word.empty()) words.push_back(std::move(word));
+    word.clear();
+    if (c == ';' && !end_statement()) return false;
+  }
+  return true;
+}
 };  // namespace
 
 namespace client {
@@ -43,17 +138,91 @@ void PostgreSQLClient::initialize(YAML::Node config) {
   user_name_ = config["user_name"].as<std::string>();
   passwd_ = config["passwd"].as<std::string>();
   db_name_ = config["db_name"].as<std::string>();
+  if (config["reuse_connection"]) {
+    reuse_connection_ = config["reuse_connection"].as<bool>();
+  }
+  read_reset_strategy(config,
+                      {ResetStrategy::kTemplate, ResetStrategy::kRollback});
+  if (config["reset_template"]) {
+    template_ = config["reset_template"].as<std::string>();
+  }
+  if (config["statement_timeout_ms"]) {
+    statement_timeout_ = std::chrono::milliseconds(
+        config["statement_timeout_ms"].as<unsigned int>());
+  }
+  // Both strategies keep a connection to `db_name_`: the template one to
+  // create and drop the databases, the rollback one to run the test cases.
+  if (reset_strategy_ != ResetStrategy::kRecreate) reuse_connection_ = true;
   std::cerr << "Sock path: " << sock_path_ << std::endl;
 }
 
+PostgreSQLClient::~PostgreSQLClient() {
+  if (test_case_connection_ != nullptr) PQfinish(test_case_connection_);
+  if (!schema_.empty()) stale_schemas_.push_back(std::move(schema_));
+  if (!stale_schemas_.empty() && connection_ != nullptr &&
+      PQstatus(connection_) == CONNECTION_OK) {
+    if (PQtransactionStatus(connection_) != PQTRANS_IDLE) {
+      run_command(connection_, "ROLLBACK");
+    }
+    drop_stale_schemas();
+  }
+  disconnect();
+}
+
 void PostgreSQLClient::prepare_env() {
-  PGconn *conn = create_connection(db_name_);
+  if (reset_strategy_ == ResetStrategy::kTemplate && prepare_template()) {
+    return;
+  }
+  if (reuse_connection_) {
+    // After a test case that was rolled back, there is nothing to reset.
+    if (reset_strategy_ == ResetStrategy::kRollback && connect() && !dirty_) {
+      return;
+    }
+    // A fresh backend needs no DISCARD, so a failure is retried once on a
+    // new connection.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+      if (connect() && reset_session()) {
+        dirty_ = false;
+        return;
+      }
+      disconnect();
+    }
+    std::cerr << "Failed to reset the session." << std::endl;
+    return;
+  }
+  PGconn *conn = create_connection(conninfo(db_name_));
   reset_database(conn);
   PQfinish(conn);
 }
 
 ExecutionStatus PostgreSQLClient::execute(const char *query, size_t size) {
-  auto conn = create_connection(db_name_);
+  if (test_case_connection_ != nullptr) {
+    return execute_on(test_case_connection_, query, size);
+  }
+  if (reuse_connection_) {
+    if (!connect()) {
+      fprintf(stderr, "Error2: %s\n", PQerrorMessage(connection_));
+      disconnect();
+      return kServerCrash;
+    }
+    if (reset_strategy_ == ResetStrategy::kRollback) {
+      in_transaction_ =
+          can_roll_back(query, size) && run_command(connection_, "BEGIN");
+      if (!in_transaction_) {
+        ++reset_stats_.fallbacks;
+        dirty_ = true;
+      }
+    }
+    ExecutionStatus status = execute_on(connection_, query, size);
+    // A query that outlived its cancel leaves the connection unusable.
+    if (status == kServerCrash ||
+        PQtransactionStatus(connection_) == PQTRANS_ACTIVE) {
+      disconnect();
+    }
+    return status;
+  }
+
+  auto conn = create_connection(conninfo(db_name_));
 
   if (PQstatus(conn) != CONNECTION_OK) {
     fprintf(stderr, "Error2: %s\n", PQerrorMessage(conn));
@@ -61,33 +230,197 @@ ExecutionStatus PostgreSQLClient::execute(const char *query, size_t size) {
     return kServerCrash;
   }
 
+  ExecutionStatus status = execute_on(conn, query, size);
+  PQfinish(conn);
+  return status;
+}
+
+void PostgreSQLClient::clean_up_env() {
+  if (test_case_connection_ != nullptr) {
+    clean_up_template();
+    return;
+  }
+  if (!in_transaction_) return;
+  in_transaction_ = false;
+  // A transaction that is no longer open was ended by the test case. Besides,
+  // prepared statements and the like outlive a rollback, hence DISCARD.
+  if (connection_ == nullptr ||
+      PQtransactionStatus(connection_) == PQTRANS_IDLE ||
+      !run_command(connection_, "ROLLBACK") ||
+      !run_command(connection_, "DISCARD ALL") || !use_schema()) {
+    dirty_ = true;
+  }
+}
+
+bool PostgreSQLClient::check_alive() {
+  PGPing res = PQping(conninfo("").c_str());
+  return res == PQPING_OK;
+}
+
+std::string PostgreSQLClient::conninfo(std::string_view db_name) const {
+  std::string result;
+  append_conninfo(&result, "host", host_);
+  append_conninfo(&result, "port", port_);
+  append_conninfo(&result, "connect_timeout", "4");
+  if (!db_name.empty()) append_conninfo(&result, "dbname", db_name);
+  if (!user_name_.empty()) append_conninfo(&result, "user", user_name_);
+  if (!passwd_.empty()) append_conninfo(&result, "password", passwd_);
+  return result;
+}
+
+ExecutionStatus PostgreSQLClient::execute_on(PGconn *conn, const char *query,
+                                             size_t size) {
+  auto deadline = std::chrono::steady_clock::time_point::max();
+  if (statement_timeout_.count() != 0) {
+    // A session setting, which the next reset drops again.
+    std::string limit = absl::StrFormat("SET statement_timeout = %d",
+                                        statement_timeout_.count());
+    run_command(conn, limit.c_str());
+    deadline = std::chrono::steady_clock::now() + statement_timeout_ +
+               kCancelGrace;
+  }
+
   std::string cmd(query, size);
+  if (!PQsendQuery(conn, cmd.c_str())) {
+    fprintf(stderr, "Error3: %s\n", PQerrorMessage(conn));
+    return PQstatus(conn) != CONNECTION_OK ? kServerCrash : kExecuteError;
+  }
+
+  // Keeps the last result, like PQexec.
+  PGresult *res = nullptr;
+  bool cancelled = false;
+  bool timed_out = false;
+  while (true) {
+    if (!wait_for_result(conn, deadline, &cancelled)) {
+      fprintf(stderr, "The query ignores the cancel.\n");
+      timed_out = true;
+      break;
+    }
+    PGresult *next = PQgetResult(conn);
+    if (next == nullptr) break;
+    if (PQresultStatus(next) == PGRES_COPY_IN) {
+      PQputCopyEnd(conn, "No COPY data from the fuzzer");
+    } else if (PQresultStatus(next) == PGRES_COPY_OUT) {
+      char *row;
+      while (PQgetCopyData(conn, &row, 0) > 0) PQfreemem(row);
+    }
+    timed_out |= is_cancelled(next);
+    PQclear(res);
+    res = next;
+  }
 
-  auto res = PQexec(conn, cmd.c_str());
   if (PQstatus(conn) != CONNECTION_OK) {
     fprintf(stderr, "Error3: %s\n", PQerrorMessage(conn));
     PQclear(res);
     return kServerCrash;
   }
+  if (timed_out) {
+    PQclear(res);
+    return kTimeout;
+  }
 
   if (PQresultStatus(res) != PGRES_COMMAND_OK &&
       PQresultStatus(res) != PGRES_TUPLES_OK) {
     fprintf(stderr, "Error4: %s\n", PQerrorMessage(conn));
     PQclear(res);
-    PQfinish(conn);
     return kExecuteError;
   }
   PQclear(res);
-  PQfinish(conn);
   return kNormal;
 }
 
-void PostgreSQLClient::clean_up_env() {}
+bool PostgreSQLClient::connect() {
+  if (connection_ != nullptr && PQstatus(connection_) == CONNECTION_OK) {
+    return true;
+  }
+  disconnect();
+  connection_ = create_connection(conninfo(db_name_));
+  return PQstatus(connection_) == CONNECTION_OK;
+}
 
-bool PostgreSQLClient::check_alive() {
-  std::string conninfo = absl::StrFormat(
-      "hostaddr=%s port=%d connect_timeout=4", "127.0.0.1", 5432);
-  PGPing res = PQping(conninfo.c_str());
-  return res == PQPING_OK;
+void PostgreSQLClient::disconnect() {
+  if (connection_ != nullptr) PQfinish(connection_);
+  connection_ = nullptr;
+  in_transaction_ = false;
+  dirty_ = true;
+}
+
+bool PostgreSQLClient::reset_session() {
+  // The last test case may have left a transaction open, in which DISCARD
+  // cannot run. DISCARD also refuses to share a query string with other
+  // statements.
+  if (PQtransactionStatus(connection_) != PQTRANS_IDLE &&
+      !run_command(connection_, "ROLLBACK")) {
+    return false;
+  }
+  // DISCARD ALL drops the temporary tables, prepared statements, session
+  // settings such as search_path, and the locks and plans of the session.
+  if (!run_command(connection_, "DISCARD ALL")) return false;
+  // Rather than emptying a schema, which takes as long as the test case took
+  // to fill it, each test case gets a new one. The old ones are dropped in
+  // batches.
+  if (!schema_.empty()) stale_schemas_.push_back(std::move(schema_));
+  if (stale_schemas_.size() >= kStaleSchemaBatch) drop_stale_schemas();
+  std::string schema =
+      absl::StrFormat("squirrel_%d_%d", getpid(), ++schema_id_);
+  std::string command = "CREATE SCHEMA " + schema;
+  if (!run_command(connection_, command.c_str())) return false;
+  schema_ = std::move(schema);
+  return use_schema();
+}
+
+bool PostgreSQLClient::use_schema() {
+  // Unqualified names resolve to, and new objects go to, the first schema.
+  std::string command = "SET search_path TO " + schema_;
+  return run_command(connection_, command.c_str());
+}
+
+void PostgreSQLClient::drop_stale_schemas() {
+  // The test case may have renamed or dropped its schema, hence IF EXISTS.
+  std::string command = "DROP SCHEMA IF EXISTS ";
+  for (size_t i = 0; i < stale_schemas_.size(); ++i) {
+    if (i != 0) command += ", ";
+    command += stale_schemas_[i];
+  }
+  command += " CASCADE";
+  // They are kept for the next batch if they cannot be dropped now, e.g.
+  // because another backend still holds a lock on them.
+  if (run_command(connection_, command.c_str())) {
+    stale_schemas_.clear();
+  } else {
+    fprintf(stderr, "Cannot drop the old schemas: %s\n",
+            PQerrorMessage(connection_));
+  }
+}
+
+bool PostgreSQLClient::prepare_template() {
+  ++database_id_;
+  test_case_database_ =
+      absl::StrFormat("%s_%d_%d", db_name_, getpid(), database_id_);
+  std::string command = absl::StrFormat("CREATE DATABASE %s TEMPLATE %s",
+                                        test_case_database_, template_);
+  if (connect() && run_command(connection_, command.c_str())) {
+    test_case_connection_ =
+        create_connection(conninfo(test_case_database_));
+    if (PQstatus(test_case_connection_) == CONNECTION_OK) return true;
+    clean_up_template();
+  } else {
+    fprintf(stderr, "Cannot clone %s: %s\n", template_.c_str(),
+            PQerrorMessage(connection_));
+  }
+  // The caller resets the session on `db_name_` instead.
+  ++reset_stats_.fallbacks;
+  return false;
+}
+
+void PostgreSQLClient::clean_up_template() {
+  // The database cannot be dropped while someone is connected to it.
+  PQfinish(test_case_connection_);
+  test_case_connection_ = nullptr;
+  std::string command = "DROP DATABASE IF EXISTS " + test_case_database_;
+  if (!connect() || !run_command(connection_, command.c_str())) {
+    fprintf(stderr, "Cannot drop %s: %s\n", test_case_database_.c_str(),
+            PQerrorMessage(connection_));
+  }
 }
 }  // namespace client
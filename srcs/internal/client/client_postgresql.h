@@ -1,17 +1,22 @@
 #ifndef __CLIENT_POSTGRESQL_H__
 #define __CLIENT_POSTGRESQL_H__
 
+#include <chrono>
 #include <cstddef>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "client.h"
+#include "libpq-fe.h"
 #include "yaml-cpp/yaml.h"
 
 namespace client {
 
 class PostgreSQLClient : public DBClient {
  public:
+  virtual ~PostgreSQLClient();
   virtual void initialize(YAML::Node);
   // Set up a clean environment for execution.
   virtual void prepare_env();
@@ -20,6 +25,49 @@ class PostgreSQLClient : public DBClient {
   virtual bool check_alive();
 
  private:
+  // The libpq connection string for `db_name`, or for no database.
+  std::string conninfo(std::string_view db_name) const;
+  // Runs a test case on `conn`. With `statement_timeout_ms`, the server stops
+  // the statements that run longer, and the client cancels the query if it
+  // did not. Timeouts are reported as kTimeout.
+  ExecutionStatus execute_on(PGconn *conn, const char *query, size_t size);
+
+  std::chrono::milliseconds statement_timeout_{0};
+
+  // With `reuse_connection`, the client keeps one backend across test cases
+  // instead of starting one for every call. It is reset between test cases
+  // and replaced once it went bad.
+  bool connect();
+  void disconnect();
+  bool reset_session();
+
+  // Each reset moves the session to a new schema, `schema_`. The previous
+  // ones are dropped once there are `kStaleSchemaBatch` of them.
+  bool use_schema();
+  void drop_stale_schemas();
+
+  static constexpr size_t kStaleSchemaBatch = 64;
+  std::string schema_;
+  std::vector<std::string> stale_schemas_;
+  unsigned int schema_id_ = 0;
+
+  bool reuse_connection_ = false;
+  PGconn *connection_ = nullptr;
+
+  // ResetStrategy::kRollback: whether the test case runs in a transaction,
+  // and whether the session must be reset before the next one.
+  bool in_transaction_ = false;
+  bool dirty_ = true;
+
+  // ResetStrategy::kTemplate: each test case runs in a database cloned from
+  // `template_`, created and dropped through `connection_`. Returns false if
+  // it could not be cloned.
+  bool prepare_template();
+  void clean_up_template();
+
+  std::string template_ = "template1";
+  std::string test_case_database_;
+  PGconn *test_case_connection_ = nullptr;
   unsigned int database_id_ = 0;
   std::string host_;
   std::string port_;
@@ -0,0 +1,111 @@
+#include "database_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/strings/str_format.h"
+
+namespace client {
+
+DatabasePool::DatabasePool(std::vector<std::string> names, Recycle recycle)
+    : recycle_(std::move(recycle)), dirty_(names.begin(), names.end()) {
+  stats_.backlog_max = dirty_.size();
+  recycler_ = std::thread([this] { recycle_loop(); });
+}
+
+DatabasePool::~DatabasePool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  dirty_added_.notify_one();
+  recycler_.join();
+}
+
+std::optional<std::string> DatabasePool::acquire(
+    std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  stats_.depth_sum += ready_.size();
+  if (ready_.empty()) {
+    ++stats_.waits;
+    auto has_ready = [this] { return !ready_.empty(); };
+    if (!ready_added_.wait_for(lock, timeout, has_ready)) {
+      ++stats_.timeouts;
+      return std::nullopt;
+    }
+  }
+  std::string name = std::move(ready_.front());
+  ready_.pop_front();
+  ++stats_.acquired;
+  ++in_use_;
+  return name;
+}
+
+void DatabasePool::release(std::string name) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    dirty_.push_back(std::move(name));
+    --in_use_;
+    stats_.backlog_max =
+        std::max<uint64_t>(stats_.backlog_max, dirty_.size());
+  }
+  dirty_added_.notify_one();
+}
+
+size_t DatabasePool::ready() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return ready_.size();
+}
+
+size_t DatabasePool::backlog() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dirty_.size();
+}
+
+DatabasePool::Stats DatabasePool::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+std::string DatabasePool::describe() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Stats &s = stats_;
+  double mean_depth = s.acquired + s.timeouts
+                          ? double(s.depth_sum) / (s.acquired + s.timeouts)
+                          : 0;
+  return absl::StrFormat(
+      "pool: %d ready %d in use %d to recycle (max %d), depth mean %.1f, "
+      "%d acquired %d waits %d timeouts, %d recycled %d failed",
+      ready_.size(), in_use_, dirty_.size(), s.backlog_max, mean_depth,
+      s.acquired, s.waits, s.timeouts, s.recycled, s.failures);
+}
+
+void DatabasePool::recycle_loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    dirty_added_.wait(lock, [this] { return stop_ || !dirty_.empty(); });
+    if (stop_) return;
+    std::string name = std::move(dirty_.front());
+    dirty_.pop_front();
+
+    lock.unlock();
+    bool recycled = recycle_(name);
+    lock.lock();
+
+    if (recycled) {
+      ++stats_.recycled;
+      ready_.push_back(std::move(name));
+      ready_added_.notify_one();
+    } else {
+      // Put it back at the end, and give the server some time.
+      ++stats_.failures;
+      dirty_.push_back(std::move(name));
+      if (dirty_added_.wait_for(lock, kRetryInterval,
+                                [this] { return stop_; })) {
+        return;
+      }
+    }
+  }
+}
+
+};  // namespace client
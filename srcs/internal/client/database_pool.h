@@ -0,0 +1,86 @@
+#ifndef __DATABASE_POOL_H__
+#define __DATABASE_POOL_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace client {
+
+// A fixed set of databases, each either ready for a test case or waiting to
+// be recycled, i.e. dropped and created again. A background thread recycles
+// the used ones while the test cases run on the others, which takes CREATE
+// and DROP DATABASE off the path of every test case.
+//
+// The databases start out waiting, so the thread creates them all first.
+class DatabasePool {
+ public:
+  struct Stats {
+    // Databases handed out, and the calls to `acquire` that found none ready
+    // and had to wait, or gave up.
+    uint64_t acquired = 0;
+    uint64_t waits = 0;
+    uint64_t timeouts = 0;
+    // Databases ready, summed over the calls to `acquire`: the mean depth of
+    // the pool as the test cases see it.
+    uint64_t depth_sum = 0;
+    // Recycles done and failed, and the most databases ever waiting for one.
+    uint64_t recycled = 0;
+    uint64_t failures = 0;
+    uint64_t backlog_max = 0;
+  };
+
+  // Recycles one database, on the pool's thread. Returns false if it failed,
+  // e.g. because the server is down, in which case it is tried again later.
+  using Recycle = std::function<bool(const std::string &)>;
+
+  DatabasePool(std::vector<std::string> names, Recycle recycle);
+  DatabasePool(const DatabasePool &) = delete;
+  DatabasePool &operator=(const DatabasePool &) = delete;
+  ~DatabasePool();
+
+  // Takes a ready database, waiting up to `timeout` for one.
+  std::optional<std::string> acquire(std::chrono::milliseconds timeout);
+  // Gives back a database taken by `acquire`, to be recycled.
+  void release(std::string name);
+
+  // The number of databases ready right now, and waiting to be recycled.
+  size_t ready() const;
+  size_t backlog() const;
+
+  Stats stats() const;
+  // The stats as one line of text.
+  std::string describe() const;
+
+ private:
+  // How long the thread waits after a failed recycle.
+  static constexpr auto kRetryInterval = std::chrono::milliseconds(100);
+
+  void recycle_loop();
+
+  Recycle recycle_;
+  std::thread recycler_;
+
+  mutable std::mutex mutex_;
+  // Signals the thread that there is work, and `acquire` that a database is
+  // ready.
+  std::condition_variable dirty_added_;
+  std::condition_variable ready_added_;
+  std::deque<std::string> dirty_;
+  std::deque<std::string> ready_;
+  // The databases taken by `acquire` and not released yet.
+  size_t in_use_ = 0;
+  bool stop_ = false;
+  Stats stats_;
+};
+
+};  // namespace client
+
+#endif
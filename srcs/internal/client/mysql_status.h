@@ -0,0 +1,56 @@
+#ifndef __MYSQL_STATUS_H__
+#define __MYSQL_STATUS_H__
+
+#include "client.h"
+
+namespace client {
+
+// The mysql_errno codes the MySQL client tells apart, as numbers so that
+// the classification builds without the MySQL headers.
+inline constexpr int kMySQLServerGoneError = 2006;  // CR_SERVER_GONE_ERROR
+inline constexpr int kMySQLServerLost = 2013;       // CR_SERVER_LOST
+inline constexpr int kMySQLParseError = 1064;       // ER_PARSE_ERROR
+// ER_QUERY_INTERRUPTED after KILL QUERY, ER_QUERY_TIMEOUT after MySQL's
+// max_execution_time, and MariaDB's ER_STATEMENT_TIMEOUT. The names are not
+// in every mysqld_error.h.
+inline constexpr int kMySQLQueryInterrupted = 1317;
+inline constexpr int kMySQLQueryTimeout = 3024;
+inline constexpr int kMariaDBStatementTimeout = 1969;
+
+inline bool is_crash_response(int error) {
+  return error == kMySQLServerLost || error == kMySQLServerGoneError;
+}
+
+inline bool is_timeout_response(int error) {
+  return error == kMySQLQueryInterrupted || error == kMySQLQueryTimeout ||
+         error == kMariaDBStatementTimeout;
+}
+
+// The status of a test case whose statements stopped at `error`, 0 if they
+// all ran.
+inline ExecutionStatus mysql_error_status(int error) {
+  if (error == 0) return kNormal;
+  if (is_crash_response(error)) return kServerCrash;
+  if (is_timeout_response(error)) return kTimeout;
+  return error == kMySQLParseError ? kSyntaxError : kSemanticError;
+}
+
+// The status of a test case. `query_error` is the mysql_errno of
+// mysql_real_query, 0 if its first statement ran, and `results` the status
+// of the statements after it, if the connection survived. Those never run
+// after a failed first statement, so its error decides. A lost connection
+// is a crash even if the watchdog `killed` the query, since KILL QUERY
+// leaves the connection alive.
+inline ExecutionStatus mysql_test_case_status(int query_error,
+                                              ExecutionStatus results,
+                                              bool killed) {
+  if (is_crash_response(query_error) || results == kServerCrash) {
+    return kServerCrash;
+  }
+  if (killed) return kTimeout;
+  return query_error != 0 ? mysql_error_status(query_error) : results;
+}
+
+};  // namespace client
+
+#endif  // __MYSQL_STATUS_H__
@@ -0,0 +1,26 @@
+#ifndef __POSTGRESQL_CONNINFO_H__
+#define __POSTGRESQL_CONNINFO_H__
+
+#include <string>
+#include <string_view>
+
+namespace client {
+
+// Appends `key='value'` to the libpq connection string `conninfo`. The value
+// is quoted, with its backslashes and single quotes escaped, so that spaces,
+// quotes and '=' in a host, user name or password stay part of it.
+inline void append_conninfo(std::string *conninfo, std::string_view key,
+                            std::string_view value) {
+  if (!conninfo->empty()) *conninfo += ' ';
+  *conninfo += key;
+  *conninfo += "='";
+  for (char c : value) {
+    if (c == '\\' || c == '\'') *conninfo += '\\';
+    *conninfo += c;
+  }
+  *conninfo += '\'';
+}
+
+};  // namespace client
+
+#endif  // __POSTGRESQL_CONNINFO_H__
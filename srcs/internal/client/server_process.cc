@@ -0,0 +1,244 @@
+#include "server_process.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+
+extern char **environ;
+
+namespace client {
+
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace {
+
+// The descriptors the server would inherit. The ones of the forkserver must
+// not reach it: an instrumented server would take them for its own.
+std::vector<int> inherited_descriptors() {
+  std::vector<int> result;
+  if (DIR *dir = opendir("/proc/self/fd")) {
+    while (dirent *entry = readdir(dir)) {
+      int fd = atoi(entry->d_name);
+      if (fd > STDERR_FILENO && fd != dirfd(dir)) result.push_back(fd);
+    }
+    closedir(dir);
+  }
+  result.erase(std::remove_if(result.begin(), result.end(),
+                              [](int fd) {
+                                int flags = fcntl(fd, F_GETFD);
+                                return flags == -1 || (flags & FD_CLOEXEC);
+                              }),
+               result.end());
+  return result;
+}
+
+int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+  return syscall(SYS_pidfd_open, pid, 0);
+#else
+  return -1;
+#endif
+}
+
+}  // namespace
+
+ServerProcess::ServerProcess(std::string startup_cmd, Probe probe,
+                             milliseconds startup_timeout)
+    : startup_cmd_(std::move(startup_cmd)),
+      probe_(std::move(probe)),
+      startup_timeout_(startup_timeout) {
+  while (!startup_cmd_.empty() &&
+         (startup_cmd_.back() == '&' || isspace(startup_cmd_.back()))) {
+    startup_cmd_.pop_back();
+  }
+}
+
+ServerProcess::~ServerProcess() {
+  if (pidfd_ != -1) close(pidfd_);
+}
+
+bool ServerProcess::start() {
+  if (probe_()) return true;
+  auto deadline = steady_clock::now() + startup_timeout_;
+  milliseconds backoff = kFirstBackoff;
+  while (steady_clock::now() < deadline) {
+    if (pid_ == -1 && !spawn()) return false;
+    if (wait_ready(deadline)) return true;
+    // It failed before it was up, e.g. as the previous one still held the
+    // port.
+    if (pid_ == -1) {
+      std::this_thread::sleep_for(backoff);
+      backoff = std::min(backoff * 2, kMaxBackoff);
+    }
+  }
+  kill_server();
+  return false;
+}
+
+milliseconds ServerProcess::recover() {
+  auto start = steady_clock::now();
+  milliseconds backoff(0);
+  while (true) {
+    if (owned_ && pid_ == -1) {
+      // Not right away if it exited before it was up.
+      std::this_thread::sleep_for(backoff);
+      backoff = std::clamp(backoff * 2, kFirstBackoff, kMaxBackoff);
+      spawn();
+    }
+    if (wait_ready(steady_clock::now() + startup_timeout_)) break;
+    if (pid_ != -1) {
+      std::cerr << absl::StrFormat(
+                       "server: pid %d is not up after %d ms, killing it",
+                       pid_, startup_timeout_.count())
+                << std::endl;
+      kill_server();
+    }
+    owned_ = true;
+  }
+  auto downtime = duration_cast<milliseconds>(steady_clock::now() - start);
+  ++stats_.recoveries;
+  stats_.downtime_ms += downtime.count();
+  stats_.max_downtime_ms =
+      std::max<uint64_t>(stats_.max_downtime_ms, downtime.count());
+  return downtime;
+}
+
+bool ServerProcess::exited() {
+  if (pid_ == -1) return false;
+  int status = 0;
+  pid_t res = waitpid(pid_, &status, WNOHANG);
+  if (res == 0) return false;
+  if (res == pid_) {
+    if (WIFSIGNALED(status)) {
+      std::cerr << absl::StrFormat("server: pid %d killed by signal %d", pid_,
+                                   WTERMSIG(status))
+                << std::endl;
+    } else if (WEXITSTATUS(status) == 0 && !up_) {
+      // pg_ctl start and the like, which leave the server running in the
+      // background. After the server was up, it is a clean shutdown.
+      std::cerr << absl::StrFormat(
+                       "server: pid %d exited with 0, probing the server it "
+                       "started",
+                       pid_)
+                << std::endl;
+      detached_ = true;
+    } else {
+      std::cerr << absl::StrFormat("server: pid %d exited with %d", pid_,
+                                   WEXITSTATUS(status))
+                << std::endl;
+    }
+  }
+  // Otherwise it was reaped already, e.g. as SIGCHLD is ignored.
+  forget();
+  return true;
+}
+
+std::string ServerProcess::describe() const {
+  return absl::StrFormat(
+      "server: %d recoveries %d starts, %d ms down in total, %d ms at most",
+      stats_.recoveries, stats_.spawns, stats_.downtime_ms,
+      stats_.max_downtime_ms);
+}
+
+bool ServerProcess::spawn() {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  // The standard input of the driver is the test case.
+  posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null",
+                                   O_RDONLY, 0);
+  for (int fd : inherited_descriptors()) {
+    posix_spawn_file_actions_addclose(&actions, fd);
+  }
+  // In a group of its own, the server does not get the signals meant for
+  // the fuzzer, like a background job of the shell.
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  sigset_t no_signals;
+  sigemptyset(&no_signals);
+  posix_spawnattr_setsigmask(&attributes, &no_signals);
+  posix_spawnattr_setpgroup(&attributes, 0);
+  posix_spawnattr_setflags(&attributes,
+                           POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK);
+
+  const char *argv[] = {"/bin/sh", "-c", startup_cmd_.c_str(), nullptr};
+  pid_t pid;
+  int res = posix_spawn(&pid, argv[0], &actions, &attributes,
+                        const_cast<char *const *>(argv), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attributes);
+  if (res != 0) {
+    std::cerr << absl::StrFormat("server: cannot run %s: %s", startup_cmd_,
+                                 strerror(res))
+              << std::endl;
+    return false;
+  }
+  pid_ = pid;
+  pidfd_ = open_pidfd(pid);
+  owned_ = true;
+  up_ = false;
+  detached_ = false;
+  ++stats_.spawns;
+  std::cerr << absl::StrFormat("server: started pid %d", pid_) << std::endl;
+  return true;
+}
+
+void ServerProcess::kill_server() {
+  if (pid_ == -1) return;
+  // The whole group, as the shell may not have replaced itself with the
+  // server.
+  kill(-pid_, SIGKILL);
+  waitpid(pid_, nullptr, 0);
+  forget();
+}
+
+bool ServerProcess::wait_ready(steady_clock::time_point deadline) {
+  milliseconds backoff = kFirstBackoff;
+  while (true) {
+    if (probe_()) {
+      up_ = true;
+      return true;
+    }
+    // A server that daemonized is only known through the probe.
+    if (exited() && !detached_) return false;
+    auto now = steady_clock::now();
+    if (now >= deadline) return false;
+    wait_exit(std::min(backoff, duration_cast<milliseconds>(deadline - now) +
+                                    milliseconds(1)));
+    backoff = std::min(backoff * 2, kMaxBackoff);
+  }
+}
+
+void ServerProcess::wait_exit(milliseconds timeout) {
+  if (pidfd_ != -1) {
+    pollfd fd = {pidfd_, POLLIN, 0};
+    poll(&fd, 1, timeout.count());
+  } else {
+    std::this_thread::sleep_for(timeout);
+  }
+}
+
+void ServerProcess::forget() {
+  if (pidfd_ != -1) close(pidfd_);
+  pidfd_ = -1;
+  pid_ = -1;
+}
+
+};  // namespace client
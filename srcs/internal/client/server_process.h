@@ -0,0 +1,96 @@
+#ifndef __SERVER_PROCESS_H__
+#define __SERVER_PROCESS_H__
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace client {
+
+// The database server the driver runs the test cases against. The driver
+// starts it from `startup_cmd` unless one is up already, and brings it back
+// after a test case crashes it. It waits for a server that is coming up by
+// probing it, with a backoff that starts short and doubles, and notices at
+// once when the one it started exits, through a pidfd, rather than sleeping
+// a fixed time.
+//
+// The command should run the server in the foreground, so that its exit
+// tells a crash. One that daemonizes the server and exits with 0, like
+// pg_ctl start, is taken to have started it; the driver then only probes,
+// and runs the command again once the server is down.
+class ServerProcess {
+ public:
+  // Tells whether the server accepts connections, e.g.
+  // DBClient::check_alive.
+  using Probe = std::function<bool()>;
+
+  struct Stats {
+    // Times the server was found down after a crash, times the driver
+    // started it again, and how long it took to come back, in ms.
+    uint64_t recoveries = 0;
+    uint64_t spawns = 0;
+    uint64_t downtime_ms = 0;
+    uint64_t max_downtime_ms = 0;
+  };
+
+  static constexpr std::chrono::milliseconds kFirstBackoff{10};
+  static constexpr std::chrono::milliseconds kMaxBackoff{500};
+
+  // `startup_cmd` is a shell command. A trailing `&` is ignored, as the
+  // server is started in the background anyway.
+  ServerProcess(std::string startup_cmd, Probe probe,
+                std::chrono::milliseconds startup_timeout);
+  ServerProcess(const ServerProcess &) = delete;
+  ServerProcess &operator=(const ServerProcess &) = delete;
+  // Leaves the server running, for the next driver to use.
+  ~ServerProcess();
+
+  // Starts the server unless it is up already, and waits until it is.
+  // Returns false, and kills what it started, if it is not up after the
+  // startup timeout.
+  bool start();
+  // Waits for the server to be up again after a crash, starting it again if
+  // it exited. A server that the driver did not start is given the startup
+  // timeout to come back on its own before the driver starts one; one the
+  // driver started is killed and started again if it is still not up after
+  // that long. Returns how long the server was down.
+  std::chrono::milliseconds recover();
+
+  // The pid of the server the driver started, or -1.
+  pid_t pid() const { return pid_; }
+  // Reaps the server the driver started if it exited, and returns true if
+  // it did.
+  bool exited();
+  const Stats &stats() const { return stats_; }
+  std::string describe() const;
+
+ private:
+  bool spawn();
+  void kill_server();
+  // Probes the server until it is up or `deadline` passes. Stops early and
+  // returns false if the server exits, unless with 0.
+  bool wait_ready(std::chrono::steady_clock::time_point deadline);
+  // Sleeps for `timeout`, waking up early if the server exits.
+  void wait_exit(std::chrono::milliseconds timeout);
+  void forget();
+
+  std::string startup_cmd_;
+  Probe probe_;
+  std::chrono::milliseconds startup_timeout_;
+  // Whether the driver started the server, even if it exited since.
+  bool owned_ = false;
+  pid_t pid_ = -1;
+  int pidfd_ = -1;
+  // Whether the server was up since the command ran, and whether the
+  // command exited with 0 before that.
+  bool up_ = false;
+  bool detached_ = false;
+  Stats stats_;
+};
+
+};  // namespace client
+
+#endif
@@ -1,4 +1,6 @@
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <string>
@@ -21,11 +23,20 @@ int main(int argc, char **argv) {
   }
   */
 
+  // The number of test cases can be given after the config, to compare the
+  // throughput of the client options, e.g. `reuse_connection`.
+  int test_cases = argc > 2 ? atoi(argv[2]) : 0x100;
   const char *query = "select 1;";
-  for (int i = 0; i < 0x100; ++i) {
-    test_client->prepare_env();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < test_cases; ++i) {
+    test_client->timed_prepare_env();
     client::ExecutionStatus result = test_client->execute(query, strlen(query));
     assert(result == client::kNormal);
-    test_client->clean_up_env();
+    test_client->timed_clean_up_env();
   }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << test_cases << " test cases in " << elapsed.count() << "s, "
+            << test_cases / elapsed.count() << " execs/s" << std::endl;
+  std::cout << test_client->describe_reset() << std::endl;
 }
@@ -0,0 +1,63 @@
+#include "watchdog.h"
+
+#include <utility>
+
+namespace client {
+
+Watchdog::Watchdog(std::function<void()> on_expiry)
+    : on_expiry_(std::move(on_expiry)) {
+  watcher_ = std::thread([this] { watch(); });
+}
+
+Watchdog::~Watchdog() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  changed_.notify_all();
+  watcher_.join();
+}
+
+void Watchdog::arm(std::chrono::milliseconds timeout) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    armed_ = true;
+    expired_ = false;
+    ++generation_;
+    deadline_ = std::chrono::steady_clock::now() + timeout;
+  }
+  changed_.notify_all();
+}
+
+bool Watchdog::disarm() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  armed_ = false;
+  changed_.notify_all();
+  changed_.wait(lock, [this] { return !running_; });
+  return expired_;
+}
+
+void Watchdog::watch() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    changed_.wait(lock, [this] { return stop_ || armed_; });
+    if (stop_) return;
+    uint64_t generation = generation_;
+    auto deadline = deadline_;
+    bool rearmed = changed_.wait_until(lock, deadline, [&] {
+      return stop_ || !armed_ || generation_ != generation;
+    });
+    if (rearmed) continue;
+
+    expired_ = true;
+    armed_ = false;
+    running_ = true;
+    lock.unlock();
+    on_expiry_();
+    lock.lock();
+    running_ = false;
+    changed_.notify_all();
+  }
+}
+
+};  // namespace client
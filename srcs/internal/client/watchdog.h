@@ -0,0 +1,49 @@
+#ifndef __WATCHDOG_H__
+#define __WATCHDOG_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace client {
+
+// Runs a callback on a thread of its own once a deadline passes, e.g. to
+// cancel a query that a blocking call is waiting for. The countdown is
+// armed before the blocking call and disarmed after it.
+class Watchdog {
+ public:
+  explicit Watchdog(std::function<void()> on_expiry);
+  Watchdog(const Watchdog &) = delete;
+  Watchdog &operator=(const Watchdog &) = delete;
+  ~Watchdog();
+
+  // Starts the countdown.
+  void arm(std::chrono::milliseconds timeout);
+  // Stops the countdown, waiting for the callback if it is running. Returns
+  // true if the deadline passed.
+  bool disarm();
+
+ private:
+  void watch();
+
+  std::function<void()> on_expiry_;
+  std::thread watcher_;
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  bool armed_ = false;
+  // Bumped by every `arm`, so the watcher tells a new countdown from the
+  // one it waited for.
+  uint64_t generation_ = 0;
+  std::chrono::steady_clock::time_point deadline_;
+  bool expired_ = false;
+  bool running_ = false;
+  bool stop_ = false;
+};
+
+};  // namespace client
+
+#endif
@@ -1,6 +1,7 @@
 #include "mysql.h"
 
 #include <cassert>
+#include <iostream>
 #include <string>
 #include <vector>
 
@@ -9,6 +10,7 @@
 #include "define.h"
 #include "mutator.h"
 #include "utils.h"
+#include "utils/file_lock.h"
 
 MySQLDB *create_mysql() { return new MySQLDB; }
 
@@ -17,17 +19,174 @@ MySQLDB::MySQLDB() { mutator_ = std::make_unique<Mutator>(); }
 bool MySQLDB::initialize(YAML::Node config) {
   const std::string init_lib_path = config["init_lib"].as<std::string>();
   std::string data_lib = config["data_lib"].as<std::string>();
+  if (config["ir_arena"]) {
+    use_round_arena_ = config["ir_arena"].as<bool>();
+  }
+  if (config["mutation_trace"]) {
+    trace_mutations_ = config["mutation_trace"].as<bool>();
+  }
+  if (config["dedup_filter_mb"]) {
+    mutant_filter_bytes_ = config["dedup_filter_mb"].as<size_t>() << 20;
+    mutator_->set_mutant_filter_budget(mutant_filter_bytes_);
+  }
+  if (config["validate_mode"]) {
+    std::string mode = config["validate_mode"].as<std::string>();
+    if (!utils::parse_validate_mode(mode, &validate_mode_)) {
+      std::cerr << absl::StrFormat("Unknown validate_mode %s.\n", mode);
+    }
+    mutator_->set_validate_mode(validate_mode_);
+  }
+  if (config["generate"]) {
+    std::string mode = config["generate"].as<std::string>();
+    if (!utils::parse_generate_mode(mode, &generate_options_.mode)) {
+      std::cerr << absl::StrFormat("Unknown generate mode %s.\n", mode);
+    }
+    if (config["generate_probability"]) {
+      generate_options_.probability =
+          config["generate_probability"].as<double>();
+    }
+    if (config["generate_max_depth"]) {
+      generate_options_.max_depth = config["generate_max_depth"].as<uint32_t>();
+    }
+    if (config["generate_max_nodes"]) {
+      generate_options_.max_nodes = config["generate_max_nodes"].as<uint32_t>();
+    }
+    if (config["generate_memo"]) {
+      generate_options_.memo_size = config["generate_memo"].as<uint32_t>();
+    }
+    for (const auto &weight : config["generate_weights"]) {
+      generate_options_.weights.emplace_back(weight.first.as<std::string>(),
+                                             weight.second.as<double>());
+    }
+    mutator_->set_generate_options(generate_options_);
+  }
+  if (config["operator_schedule"] && config["operator_schedule"].as<bool>()) {
+    utils::ScheduleOptions options;
+    if (config["operator_schedule_period"]) {
+      options.period = config["operator_schedule_period"].as<uint32_t>();
+    }
+    if (config["operator_stats"]) {
+      operator_stats_ = config["operator_stats"].as<std::string>();
+    }
+    scheduler_ = std::make_unique<utils::OperatorScheduler>(kNodeTypeCount,
+                                                            options, 0);
+    mutator_->set_operator_scheduler(scheduler_.get());
+  }
+  if (config["library_weights"] && config["library_weights"].as<bool>()) {
+    library_weights_ = true;
+    if (config["library_rare_boost"]) {
+      library_weight_options_.rare_boost =
+          config["library_rare_boost"].as<double>();
+    }
+    mutator_->set_library_weights(library_weight_options_);
+  }
+  if (config["mutate_threads"]) {
+    size_t threads = config["mutate_threads"].as<size_t>();
+    if (threads > 1) pool_ = std::make_unique<utils::ThreadPool>(threads);
+  }
+  if (config["lib_snapshot"]) {
+    lib_snapshot_ = config["lib_snapshot"].as<std::string>();
+    if (config["lib_snapshot_interval"]) {
+      lib_snapshot_interval_ = config["lib_snapshot_interval"].as<size_t>();
+    }
+    if (config["lib_shared_log"]) {
+      lib_shared_log_ = config["lib_shared_log"].as<std::string>();
+      if (config["lib_shared_log_capacity"]) {
+        lib_shared_log_capacity_ =
+            config["lib_shared_log_capacity"].as<size_t>();
+      }
+      // The first instance to take the lock builds the snapshot while the
+      // others wait, then all of them attach to it.
+      utils::FileLock lock(lib_snapshot_ + ".lock");
+      if (!attach_library()) {
+        init_library(init_lib_path, data_lib);
+        // The private library is kept if the shared one cannot be used.
+        if (save_library(lib_snapshot_)) attach_library();
+      }
+      return true;
+    }
+    if (load_library(lib_snapshot_)) return true;
+  }
+  init_library(init_lib_path, data_lib);
+  if (!lib_snapshot_.empty()) save_library(lib_snapshot_);
+  return true;
+}
+
+void MySQLDB::init_library(const std::string &init_lib_path,
+                           const std::string &data_lib) {
   std::vector<std::string> file_list =
       get_all_files_in_dir(init_lib_path.c_str());
   for (auto &f : file_list) {
     mutator_->init(absl::StrFormat("%s/%s", init_lib_path, f));
   }
   mutator_->init_data_library(data_lib);
+}
+
+bool MySQLDB::save_library(const std::string &path) {
+  return mutator_->save_snapshot(path);
+}
+
+bool MySQLDB::load_library(const std::string &path) {
+  auto mutator = new_mutator();
+  mutator->init();
+  if (!mutator->load_snapshot(path)) return false;
+  mutator_ = std::move(mutator);
+  return true;
+}
+
+bool MySQLDB::attach_library() {
+  auto mutator = new_mutator();
+  mutator->init();
+  if (!mutator->attach_shared_library(lib_snapshot_, lib_shared_log_,
+                                      lib_shared_log_capacity_)) {
+    return false;
+  }
+  mutator_ = std::move(mutator);
   return true;
 }
 
+std::unique_ptr<Mutator> MySQLDB::new_mutator() {
+  auto mutator = std::make_unique<Mutator>();
+  mutator->set_mutant_filter_budget(mutant_filter_bytes_);
+  mutator->set_validate_mode(validate_mode_);
+  mutator->set_generate_options(generate_options_);
+  if (library_weights_) mutator->set_library_weights(library_weight_options_);
+  mutator->set_operator_scheduler(scheduler_.get());
+  return mutator;
+}
+
+void MySQLDB::seed(uint64_t seed) {
+  mutator_->rng().seed(seed);
+  if (scheduler_ != nullptr) scheduler_->seed(seed);
+}
+
+std::string MySQLDB::describe() {
+  const auto &filter = mutator_->mutant_filter();
+  const auto &stats = filter.stats();
+  std::string filter_stats = absl::StrFormat(
+      "mutant filter: %d new %d repeated, %d agings of %d, "
+      "false positives %.3f%% (%d of %d sampled), %d MB",
+      stats.inserted, stats.duplicates, stats.agings,
+      filter.generation_capacity(), 100 * stats.false_positive_rate(),
+      stats.sampled_false_positives, stats.sampled_new, filter.memory() >> 20);
+  std::string result = filter_stats + "; " + mutator_->describe_validation();
+  if (generate_options_.mode != utils::GenerateMode::kOff) {
+    result += "; " + mutator_->describe_generation();
+  }
+  if (scheduler_ != nullptr) result += "; " + scheduler_->describe();
+  if (library_weights_) result += "; " + mutator_->describe_library_weights();
+  return result;
+}
+
 bool MySQLDB::save_interesting_query(const std::string &query) {
-  if (Program *program = parser(query)) {
+  utils::MutantOrigin origin;
+  if (recent_mutants_.take(utils::hash_bytes(query.data(), query.size()),
+                           &origin)) {
+    if (scheduler_ != nullptr) scheduler_->found(origin.node_type, origin.op);
+    mutator_->library_found(origin.library);
+  }
+  utils::RngScope rng_scope(&mutator_->rng());
+  if (Program *program = parser(std::string(utils::strip_trace(query)))) {
     std::vector<IR *> ir_set;
     IR *ir = program->translate(ir_set);
     ir_set.clear();
@@ -40,30 +199,86 @@ bool MySQLDB::save_interesting_query(const std::string &query) {
       mutator_->add_ir_to_library(root_ir);
       deep_delete(root_ir);
     }
+    if (lib_snapshot_interval_ &&
+        ++interesting_queries_ % lib_snapshot_interval_ == 0) {
+      save_library(lib_snapshot_);
+    }
     return true;
   }
   return false;
 }
 
+// Each mutant is validated with a generator of its own, see
+// utils::MutationTrace.
 size_t MySQLDB::validate_all(std::vector<IR *> &ir_set) {
-  for (IR *&ir : ir_set) {
-    bool result = mutator_->validate(ir);
+  auto &traces = mutator_->mutation_traces();
+  if (pool_ != nullptr) {
+    // Seeding the workers must not draw from the Mutator's generator.
+    utils::Rng workers_rng(seed_hash_);
+    utils::RngScope workers_scope(&workers_rng);
+    std::vector<std::string> validated(ir_set.size());
+    std::vector<char> valid(ir_set.size(), false);
+    pool_->run(ir_set.size(), [&](size_t i) {
+      utils::Rng rng(traces[i].validate_seed());
+      utils::RngScope rng_scope(&rng);
+      if (!mutator_->validate(ir_set[i], &traces[i])) return;
+      validated[i] = test_case(ir_set[i], traces[i]);
+      valid[i] = true;
+    });
+    for (size_t i = 0; i < ir_set.size(); i++) {
+      if (!valid[i]) continue;
+      validated_test_cases_.push(std::move(validated[i]));
+      validated_origins_.push(utils::MutantOrigin::of(traces[i]));
+    }
+    return validated_test_cases_.size();
+  }
+  for (size_t i = 0; i < ir_set.size(); i++) {
+    utils::Rng rng(traces[i].validate_seed());
+    utils::RngScope rng_scope(&rng);
+    bool result = mutator_->validate(ir_set[i], &traces[i]);
     if (!result) {
       continue;
     }
-    std::string validated_ir = ir->to_string();
+    std::string validated_ir = test_case(ir_set[i], traces[i]);
     validated_test_cases_.push(std::move(validated_ir));
+    validated_origins_.push(utils::MutantOrigin::of(traces[i]));
   }
   return validated_test_cases_.size();
 }
 
+void MySQLDB::save_schedule() {
+  if (operator_stats_.empty()) return;
+  auto type_name = [](uint32_t type) {
+    std::string name = get_string_by_nodetype(static_cast<NODETYPE>(type));
+    return name.empty() ? absl::StrFormat("type%d", type) : name;
+  };
+  if (!scheduler_->save(operator_stats_, type_name)) {
+    std::cerr << "Cannot write " << operator_stats_ << std::endl;
+  }
+}
+
+std::string MySQLDB::test_case(IR *ir, utils::MutationTrace &trace) const {
+  if (!trace_mutations_) return ir->to_string();
+  trace.seed_hash = seed_hash_;
+  return utils::add_trace(trace, ir->to_string());
+}
+
 bool MySQLDB::has_mutated_test_cases() {
   return !validated_test_cases_.empty();
 }
 
 size_t MySQLDB::mutate(const std::string &query) {
+  // The trees of the previous round are gone by now, so its arena can be
+  // recycled as a whole.
+  round_arena_.reset();
+  if (pool_ != nullptr) pool_->reset_arenas();
+  utils::ArenaScope round_scope(use_round_arena_ ? &round_arena_ : nullptr);
+  utils::RngScope rng_scope(&mutator_->rng());
+
   std::vector<IR *> ir_set, mutated_tree;
-  Program *program_root = parser(query.c_str());
+  std::string sql(utils::strip_trace(query));
+  seed_hash_ = utils::seed_hash(sql);
+  Program *program_root = parser(sql.c_str());
   if (program_root == nullptr) {
     return 0;
   }
@@ -79,8 +294,11 @@ size_t MySQLDB::mutate(const std::string &query) {
     program_root->deep_delete();
   }
   program_root->deep_delete();
+  // The seed was just parsed, so its productions are valid ones.
+  mutator_->learn_productions(ir_set[ir_set.size() - 1]);
 
-  mutated_tree = mutator_->mutate_all(ir_set);
+  mutated_tree = pool_ != nullptr ? mutator_->mutate_all(ir_set, *pool_)
+                                  : mutator_->mutate_all(ir_set);
   deep_delete(ir_set[ir_set.size() - 1]);
 
   size_t validated_ir_size = validate_all(mutated_tree);
@@ -93,9 +311,64 @@ size_t MySQLDB::mutate(const std::string &query) {
   return validated_ir_size;
 }
 
+bool MySQLDB::replay(const std::string &seed, const std::string &trace_text,
+                     std::string *mutant) {
+  utils::MutationTrace trace;
+  if (!utils::MutationTrace::decode(trace_text, &trace)) {
+    std::cerr << "Malformed trace: " << trace_text << std::endl;
+    return false;
+  }
+  std::string sql(utils::strip_trace(seed));
+  Program *program_root = parser(sql.c_str());
+  if (program_root == nullptr) {
+    std::cerr << "The seed does not parse." << std::endl;
+    return false;
+  }
+  std::vector<IR *> ir_set;
+  program_root->translate(ir_set);
+  program_root->deep_delete();
+  mutator_->learn_productions(ir_set[ir_set.size() - 1]);
+
+  std::vector<utils::LibraryPick> library;
+  IR *tree = mutator_->replay_mutation(ir_set, trace, &library);
+  deep_delete(ir_set[ir_set.size() - 1]);
+  if (tree == nullptr) {
+    std::cerr << absl::StrFormat(
+        "Node %d of the seed has no %s variant.\n", trace.node,
+        utils::MutationTrace::strategy_name(trace.strategy));
+    return false;
+  }
+  if (!trace.same_entries(library)) {
+    std::cerr << "The library no longer holds the entries of the run."
+              << std::endl;
+    deep_delete(tree);
+    return false;
+  }
+  utils::Rng rng(trace.validate_seed());
+  utils::RngScope rng_scope(&rng);
+  bool valid = mutator_->validate(tree, &trace);
+  if (valid) {
+    *mutant = tree->to_string();
+  } else {
+    std::cerr << "The mutant does not validate." << std::endl;
+  }
+  deep_delete(tree);
+  return valid;
+}
+
 std::string MySQLDB::get_next_mutated_query() {
   assert(has_mutated_test_cases());
   auto result = validated_test_cases_.top();
   validated_test_cases_.pop();
+  utils::MutantOrigin origin = std::move(validated_origins_.top());
+  validated_origins_.pop();
+  if (scheduler_ != nullptr || library_weights_) {
+    if (scheduler_ != nullptr && scheduler_->ran(origin.node_type, origin.op)) {
+      save_schedule();
+    }
+    mutator_->library_ran(origin.library);
+    recent_mutants_.add(utils::hash_bytes(result.data(), result.size()),
+                        std::move(origin));
+  }
   return result;
 }
@@ -1,12 +1,33 @@
 #include "../include/ast.h"
 
 #include <cassert>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 #include "../include/define.h"
 #include "../include/utils.h"
+#include "utils/generate.h"
 
 static string s_table_name;
 
+const IROperator *IROperator::get(const string &prefix, const string &middle,
+                                  const string &suffix) {
+  // Never destroyed, so that operators outlive every static IR.
+  static auto *table =
+      new map<std::tuple<string, string, string>, const IROperator *>();
+  static std::mutex table_mutex;
+
+  std::lock_guard<std::mutex> lock(table_mutex);
+  auto key = std::make_tuple(prefix, middle, suffix);
+  auto iter = table->find(key);
+  if (iter != table->end()) return iter->second;
+
+  auto *op = new IROperator(prefix, middle, suffix, table->size());
+  table->emplace(std::move(key), op);
+  return op;
+}
+
 Node *generate_ast_node_by_type(IRTYPE type) {
 #define DECLARE_CASE(classname) \
   if (type == k##classname) return new classname();
@@ -60,8 +81,6 @@ void deep_delete(IR *root) {
   if (root->left_) deep_delete(root->left_);
   if (root->right_) deep_delete(root->right_);
 
-  if (root->op_) delete root->op_;
-
   delete root;
 }
 
@@ -80,48 +99,91 @@ IR *deep_copy(const IR *root) {
 }
 
 string IR::to_string() {
-  auto res = to_string_core();
-  trim_string(res);
-  return res;
+  // The whole tree is written into one buffer that keeps its capacity between
+  // calls, and trimmed once.
+  static thread_local string buffer;
+  buffer.clear();
+  to_string_core(buffer);
+  trim_string(buffer);
+  return buffer;
 }
 
-string IR::to_string_core() {
-  // cout << get_string_by_nodetype(this->type_) << endl;
+void IR::to_string_core(string &res) {
   switch (type_) {
     case kIntLiteral:
-      return std::to_string(int_val_);
+      res += std::to_string(int_val_);
+      return;
     case kFloatLiteral:
-      return std::to_string(float_val_);
+      res += std::to_string(float_val_);
+      return;
     case kIdentifier:
-      return str_val_;
     case kStringLiteral:
-      return str_val_;
+      res += str_val_;
+      return;
   }
 
-  string res;
-
   if (op_ != NULL) {
-    // if(op_->prefix_ == NULL)
-    /// cout << "duck NULL prefix" << endl;
-    // cout << "OP_Prex: " << op_->prefix_ << endl;
-    res += op_->prefix_ + " ";
+    res += op_->prefix_;
+    res += ' ';
+  }
+  if (left_ != NULL) {
+    left_->to_string_core(res);
+    res += ' ';
+  }
+  if (op_ != NULL) {
+    res += op_->middle_;
+    res += ' ';
+  }
+  if (right_ != NULL) {
+    right_->to_string_core(res);
+    res += ' ';
   }
-  // cout << "OP_1_" << op_ << endl;
-  if (left_ != NULL)
-    // res += left_->to_string() + " ";
-    res += left_->to_string_core() + " ";
-  // cout << "OP_2_" << op_ << endl;
-  if (op_ != NULL) res += op_->middle_ + " ";
-  // cout << "OP_3_" << op_ << endl;
-  if (right_ != NULL)
-    // res += right_->to_string() + " ";
-    res += right_->to_string_core() + " ";
-  // cout << "OP_4_" << op_ << endl;
   if (op_ != NULL) res += op_->suffix_;
+}
+
+unsigned long IR::update_hash() {
+  // Follows to_string_core piece by piece, so that trees printing the same
+  // SQL share a hash no matter how they are shaped.
+  utils::TokenHash h;
+  switch (type_) {
+    case kIntLiteral:
+      h.append(std::to_string(int_val_));
+      break;
+    case kFloatLiteral:
+      h.append(std::to_string(float_val_));
+      break;
+    case kIdentifier:
+    case kStringLiteral:
+      h.append(str_val_);
+      break;
+    default:
+      if (op_ != NULL) {
+        h.append(op_->prefix_hash_);
+        h.append_space();
+      }
+      if (left_ != NULL) {
+        h.append(left_->hash_);
+        h.append_space();
+      }
+      if (op_ != NULL) {
+        h.append(op_->middle_hash_);
+        h.append_space();
+      }
+      if (right_ != NULL) {
+        h.append(right_->hash_);
+        h.append_space();
+      }
+      if (op_ != NULL) h.append(op_->suffix_hash_);
+      break;
+  }
+  hash_ = h;
+  return h.digest();
+}
 
-  // cout << "duck" << endl;
-  // cout << "RETURN" << endl;
-  return res;
+unsigned long IR::structural_hash() {
+  if (left_ != NULL) left_->structural_hash();
+  if (right_ != NULL) right_->structural_hash();
+  return update_hash();
 }
 
 IR *Node::translate(vector<IR *> &v_ir_collector) { return NULL; }
@@ -140,7 +202,7 @@ void Program::deep_delete() {
 };
 
 void Program::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   stmtlist_ = new Stmtlist();
   stmtlist_->generate();
@@ -173,7 +235,7 @@ void Stmtlist::deep_delete() {
 };
 
 void Stmtlist::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -188,7 +250,7 @@ void Stmtlist::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       stmt_ = new Stmt();
@@ -246,7 +308,7 @@ void Stmt::deep_delete() {
 };
 
 void Stmt::generate() {
-  GENERATESTART(6)
+  GENERATESTART(6, 4)
 
   SWITCHSTART
   CASESTART(0)
@@ -312,7 +374,7 @@ void CreateStmt::deep_delete() {
 };
 
 void CreateStmt::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -370,7 +432,7 @@ void DropStmt::deep_delete() {
 };
 
 void DropStmt::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -411,7 +473,7 @@ void AlterStmt::deep_delete() {
 };
 
 void AlterStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   table_name_ = new TableName();
   table_name_->generate();
@@ -445,7 +507,7 @@ void SelectStmt::deep_delete() {
 };
 
 void SelectStmt::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -485,7 +547,7 @@ void SelectWithParens::deep_delete() {
 };
 
 void SelectWithParens::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -498,7 +560,7 @@ void SelectWithParens::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       select_no_parens_ = new SelectNoParens();
@@ -537,7 +599,7 @@ void SelectNoParens::deep_delete() {
 };
 
 void SelectNoParens::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_with_clause_ = new OptWithClause();
   opt_with_clause_->generate();
@@ -580,7 +642,7 @@ void SelectClauseList::deep_delete() {
 };
 
 void SelectClauseList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -597,7 +659,7 @@ void SelectClauseList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       select_clause_ = new SelectClause();
@@ -644,7 +706,7 @@ void SelectClause::deep_delete() {
 };
 
 void SelectClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_all_or_distinct_ = new OptAllOrDistinct();
   opt_all_or_distinct_->generate();
@@ -682,7 +744,7 @@ IR *CombineClause::translate(vector<IR *> &v_ir_collector) {
 
 void CombineClause::deep_delete() { delete this; };
 
-void CombineClause::generate(){GENERATESTART(3)
+void CombineClause::generate(){GENERATESTART(3, 0)
 
                                    SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                        CASEEND CASESTART(2) CASEEND SWITCHEND
@@ -711,7 +773,7 @@ void OptFromClause::deep_delete() {
 };
 
 void OptFromClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -741,7 +803,7 @@ void SelectTarget::deep_delete() {
 };
 
 void SelectTarget::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_list_ = new ExprList();
   expr_list_->generate();
@@ -771,7 +833,7 @@ void OptWindowClause::deep_delete() {
 };
 
 void OptWindowClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -801,7 +863,7 @@ void WindowClause::deep_delete() {
 };
 
 void WindowClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   window_def_list_ = new WindowDefList();
   window_def_list_->generate();
@@ -834,7 +896,7 @@ void WindowDefList::deep_delete() {
 };
 
 void WindowDefList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -849,7 +911,7 @@ void WindowDefList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       window_def_ = new WindowDef();
@@ -880,7 +942,7 @@ void WindowDef::deep_delete() {
 };
 
 void WindowDef::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   window_name_ = new WindowName();
   window_name_->generate();
@@ -905,7 +967,7 @@ void WindowName::deep_delete() {
 };
 
 void WindowName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -938,7 +1000,7 @@ void Window::deep_delete() {
 };
 
 void Window::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_exist_window_name_ = new OptExistWindowName();
   opt_exist_window_name_->generate();
@@ -974,7 +1036,7 @@ void OptPartition::deep_delete() {
 };
 
 void OptPartition::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1022,7 +1084,7 @@ void OptFrameClause::deep_delete() {
 };
 
 void OptFrameClause::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -1067,7 +1129,7 @@ IR *RangeOrRows::translate(vector<IR *> &v_ir_collector) {
 
 void RangeOrRows::deep_delete() { delete this; };
 
-void RangeOrRows::generate(){GENERATESTART(3)
+void RangeOrRows::generate(){GENERATESTART(3, 0)
 
                                  SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                      CASEEND CASESTART(2) CASEEND SWITCHEND
@@ -1096,7 +1158,7 @@ void FrameBoundStart::deep_delete() {
 };
 
 void FrameBoundStart::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1132,7 +1194,7 @@ void FrameBoundEnd::deep_delete() {
 };
 
 void FrameBoundEnd::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1172,7 +1234,7 @@ void FrameBound::deep_delete() {
 };
 
 void FrameBound::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -1212,7 +1274,7 @@ void OptExistWindowName::deep_delete() {
 };
 
 void OptExistWindowName::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1251,7 +1313,7 @@ void OptGroupClause::deep_delete() {
 };
 
 void OptGroupClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1290,7 +1352,7 @@ void OptHavingClause::deep_delete() {
 };
 
 void OptHavingClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1327,7 +1389,7 @@ void OptWhereClause::deep_delete() {
 };
 
 void OptWhereClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1357,7 +1419,7 @@ void WhereClause::deep_delete() {
 };
 
 void WhereClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_ = new Expr();
   expr_->generate();
@@ -1380,7 +1442,7 @@ void FromClause::deep_delete() {
 };
 
 void FromClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   table_ref_ = new TableRef();
   table_ref_->generate();
@@ -1474,7 +1536,7 @@ void TableRef::deep_delete() {
 };
 
 void TableRef::generate() {
-  GENERATESTART(400)
+  GENERATESTART(400, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -1531,7 +1593,7 @@ void TableRef::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 3;
+    int tmp_case_idx = get_rand_int(3);
     switch (tmp_case_idx) {
       CASESTART(0)
       opt_table_prefix_ = new OptTablePrefix();
@@ -1608,7 +1670,7 @@ void OptIndex::deep_delete() {
 };
 
 void OptIndex::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1647,7 +1709,7 @@ void OptOn::deep_delete() {
 };
 
 void OptOn::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1684,7 +1746,7 @@ void OptUsing::deep_delete() {
 };
 
 void OptUsing::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1724,7 +1786,7 @@ void ColumnNameList::deep_delete() {
 };
 
 void ColumnNameList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -1739,7 +1801,7 @@ void ColumnNameList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       column_name_ = new ColumnName();
@@ -1777,7 +1839,7 @@ void OptTablePrefix::deep_delete() {
 };
 
 void OptTablePrefix::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1819,7 +1881,7 @@ void JoinOp::deep_delete() {
 };
 
 void JoinOp::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -1861,7 +1923,7 @@ IR *OptJoinType::translate(vector<IR *> &v_ir_collector) {
 
 void OptJoinType::deep_delete() { delete this; };
 
-void OptJoinType::generate(){GENERATESTART(5)
+void OptJoinType::generate(){GENERATESTART(5, 0)
 
                                  SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                      CASEEND CASESTART(2) CASEEND CASESTART(3)
@@ -1901,7 +1963,7 @@ void ExprList::deep_delete() {
 };
 
 void ExprList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1920,7 +1982,7 @@ void ExprList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       expr_ = new Expr();
@@ -1958,7 +2020,7 @@ void OptLimitClause::deep_delete() {
 };
 
 void OptLimitClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -2003,7 +2065,7 @@ void LimitClause::deep_delete() {
 };
 
 void LimitClause::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -2049,7 +2111,7 @@ void OptLimitRowCount::deep_delete() {
 };
 
 void OptLimitRowCount::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -2086,7 +2148,7 @@ void OptOrderClause::deep_delete() {
 };
 
 void OptOrderClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -2121,7 +2183,7 @@ IR *OptOrderNulls::translate(vector<IR *> &v_ir_collector) {
 
 void OptOrderNulls::deep_delete() { delete this; };
 
-void OptOrderNulls::generate(){GENERATESTART(3)
+void OptOrderNulls::generate(){GENERATESTART(3, 0)
 
                                    SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                        CASEEND CASESTART(2)
@@ -2155,7 +2217,7 @@ void OrderItemList::deep_delete() {
 };
 
 void OrderItemList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -2170,7 +2232,7 @@ void OrderItemList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       order_item_ = new OrderItem();
@@ -2205,7 +2267,7 @@ void OrderItem::deep_delete() {
 };
 
 void OrderItem::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_ = new Expr();
   expr_->generate();
@@ -2238,7 +2300,7 @@ IR *OptOrderBehavior::translate(vector<IR *> &v_ir_collector) {
 void OptOrderBehavior::deep_delete() { delete this; };
 
 void OptOrderBehavior::generate(){
-    GENERATESTART(3)
+    GENERATESTART(3, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
 
@@ -2272,7 +2334,7 @@ void OptWithClause::deep_delete() {
 };
 
 void OptWithClause::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -2316,7 +2378,7 @@ void CteTableList::deep_delete() {
 };
 
 void CteTableList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -2331,7 +2393,7 @@ void CteTableList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       cte_table_ = new CteTable();
@@ -2362,7 +2424,7 @@ void CteTable::deep_delete() {
 };
 
 void CteTable::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   cte_table_name_ = new CteTableName();
   cte_table_name_->generate();
@@ -2389,7 +2451,7 @@ void CteTableName::deep_delete() {
 };
 
 void CteTableName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   table_name_ = new TableName();
   table_name_->generate();
@@ -2420,7 +2482,7 @@ IR *OptAllOrDistinct::translate(vector<IR *> &v_ir_collector) {
 void OptAllOrDistinct::deep_delete() { delete this; };
 
 void OptAllOrDistinct::generate(){
-    GENERATESTART(3)
+    GENERATESTART(3, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
 
@@ -2484,7 +2546,7 @@ void CreateTableStmt::deep_delete() {
 };
 
 void CreateTableStmt::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -2553,7 +2615,7 @@ void CreateIndexStmt::deep_delete() {
 };
 
 void CreateIndexStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_index_keyword_ = new OptIndexKeyword();
   opt_index_keyword_->generate();
@@ -2600,7 +2662,7 @@ void CreateTriggerStmt::deep_delete() {
 };
 
 void CreateTriggerStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   trigger_name_ = new TriggerName();
   trigger_name_->generate();
@@ -2671,7 +2733,7 @@ void CreateViewStmt::deep_delete() {
 };
 
 void CreateViewStmt::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -2729,7 +2791,7 @@ void OptTableOptionList::deep_delete() {
 };
 
 void OptTableOptionList::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -2773,7 +2835,7 @@ void TableOptionList::deep_delete() {
 };
 
 void TableOptionList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -2790,7 +2852,7 @@ void TableOptionList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       table_option_ = new TableOption();
@@ -2855,7 +2917,7 @@ void TableOption::deep_delete() {
 };
 
 void TableOption::generate() {
-  GENERATESTART(9)
+  GENERATESTART(9, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -2916,7 +2978,7 @@ IR *OptOpComma::translate(vector<IR *> &v_ir_collector) {
 
 void OptOpComma::deep_delete() { delete this; };
 
-void OptOpComma::generate(){GENERATESTART(2)
+void OptOpComma::generate(){GENERATESTART(2, 0)
 
                                 SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -2945,7 +3007,7 @@ IR *OptIgnoreOrReplace::translate(vector<IR *> &v_ir_collector) {
 void OptIgnoreOrReplace::deep_delete() { delete this; };
 
 void OptIgnoreOrReplace::generate(){
-    GENERATESTART(3)
+    GENERATESTART(3, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
 
@@ -2977,7 +3039,7 @@ IR *OptViewAlgorithm::translate(vector<IR *> &v_ir_collector) {
 void OptViewAlgorithm::deep_delete() { delete this; };
 
 void OptViewAlgorithm::generate(){
-    GENERATESTART(4)
+    GENERATESTART(4, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
             CASEEND CASESTART(3)
@@ -3007,7 +3069,7 @@ IR *OptSqlSecurity::translate(vector<IR *> &v_ir_collector) {
 void OptSqlSecurity::deep_delete() { delete this; };
 
 void OptSqlSecurity::generate(){
-    GENERATESTART(3)
+    GENERATESTART(3, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
 
@@ -3036,7 +3098,7 @@ IR *OptIndexOption::translate(vector<IR *> &v_ir_collector) {
 void OptIndexOption::deep_delete() { delete this; };
 
 void OptIndexOption::generate(){
-    GENERATESTART(3)
+    GENERATESTART(3, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
 
@@ -3071,7 +3133,7 @@ void OptExtraOption::deep_delete() {
 };
 
 void OptExtraOption::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -3117,7 +3179,7 @@ void IndexAlgorithmOption::deep_delete() {
 };
 
 void IndexAlgorithmOption::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3168,7 +3230,7 @@ void LockOption::deep_delete() {
 };
 
 void LockOption::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3209,7 +3271,7 @@ IR *OptOpEqual::translate(vector<IR *> &v_ir_collector) {
 
 void OptOpEqual::deep_delete() { delete this; };
 
-void OptOpEqual::generate(){GENERATESTART(2)
+void OptOpEqual::generate(){GENERATESTART(2, 0)
 
                                 SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -3237,7 +3299,7 @@ IR *TriggerEvents::translate(vector<IR *> &v_ir_collector) {
 
 void TriggerEvents::deep_delete() { delete this; };
 
-void TriggerEvents::generate(){GENERATESTART(3)
+void TriggerEvents::generate(){GENERATESTART(3, 0)
 
                                    SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                        CASEEND CASESTART(2) CASEEND SWITCHEND
@@ -3259,7 +3321,7 @@ void TriggerName::deep_delete() {
 };
 
 void TriggerName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -3285,7 +3347,7 @@ IR *TriggerActionTime::translate(vector<IR *> &v_ir_collector) {
 void TriggerActionTime::deep_delete() { delete this; };
 
 void TriggerActionTime::generate(){
-    GENERATESTART(2)
+    GENERATESTART(2, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND SWITCHEND
 
@@ -3308,7 +3370,7 @@ void DropIndexStmt::deep_delete() {
 };
 
 void DropIndexStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   table_name_ = new TableName();
   table_name_->generate();
@@ -3343,7 +3405,7 @@ void DropTableStmt::deep_delete() {
 };
 
 void DropTableStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_temp_ = new OptTemp();
   opt_temp_->generate();
@@ -3378,7 +3440,7 @@ IR *OptRestrictOrCascade::translate(vector<IR *> &v_ir_collector) {
 void OptRestrictOrCascade::deep_delete() { delete this; };
 
 void OptRestrictOrCascade::generate(){
-    GENERATESTART(3)
+    GENERATESTART(3, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
 
@@ -3403,7 +3465,7 @@ void DropTriggerStmt::deep_delete() {
 };
 
 void DropTriggerStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_if_exist_ = new OptIfExist();
   opt_if_exist_->generate();
@@ -3434,7 +3496,7 @@ void DropViewStmt::deep_delete() {
 };
 
 void DropViewStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_if_exist_ = new OptIfExist();
   opt_if_exist_->generate();
@@ -3475,7 +3537,7 @@ void InsertStmt::deep_delete() {
 };
 
 void InsertStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_with_clause_ = new OptWithClause();
   opt_with_clause_->generate();
@@ -3522,7 +3584,7 @@ void InsertRest::deep_delete() {
 };
 
 void InsertRest::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -3571,7 +3633,7 @@ void SuperValuesList::deep_delete() {
 };
 
 void SuperValuesList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3586,7 +3648,7 @@ void SuperValuesList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       values_list_ = new ValuesList();
@@ -3615,7 +3677,7 @@ void ValuesList::deep_delete() {
 };
 
 void ValuesList::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_list_ = new ExprList();
   expr_list_->generate();
@@ -3655,7 +3717,7 @@ void OptOnConflict::deep_delete() {
 };
 
 void OptOnConflict::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -3702,7 +3764,7 @@ void OptConflictExpr::deep_delete() {
 };
 
 void OptConflictExpr::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -3744,7 +3806,7 @@ void IndexedColumnList::deep_delete() {
 };
 
 void IndexedColumnList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3759,7 +3821,7 @@ void IndexedColumnList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       indexed_column_ = new IndexedColumn();
@@ -3790,7 +3852,7 @@ void IndexedColumn::deep_delete() {
 };
 
 void IndexedColumn::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_ = new Expr();
   expr_->generate();
@@ -3854,7 +3916,7 @@ void UpdateStmt::deep_delete() {
 };
 
 void UpdateStmt::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3936,7 +3998,7 @@ void AlterAction::deep_delete() {
 };
 
 void AlterAction::generate() {
-  GENERATESTART(5)
+  GENERATESTART(5, 4)
 
   SWITCHSTART
   CASESTART(0)
@@ -4009,7 +4071,7 @@ void AlterConstantAction::deep_delete() {
 };
 
 void AlterConstantAction::generate() {
-  GENERATESTART(7)
+  GENERATESTART(7, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4058,7 +4120,7 @@ void ColumnDefList::deep_delete() {
 };
 
 void ColumnDefList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4073,7 +4135,7 @@ void ColumnDefList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       column_def_ = new ColumnDef();
@@ -4108,7 +4170,7 @@ void ColumnDef::deep_delete() {
 };
 
 void ColumnDef::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -4148,7 +4210,7 @@ void OptColumnConstraintList::deep_delete() {
 };
 
 void OptColumnConstraintList::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -4192,7 +4254,7 @@ void ColumnConstraintList::deep_delete() {
 };
 
 void ColumnConstraintList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4207,7 +4269,7 @@ void ColumnConstraintList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       column_constraint_ = new ColumnConstraint();
@@ -4236,7 +4298,7 @@ void ColumnConstraint::deep_delete() {
 };
 
 void ColumnConstraint::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   constraint_type_ = new ConstraintType();
   constraint_type_->generate();
@@ -4268,7 +4330,7 @@ void OptReferenceClause::deep_delete() {
 };
 
 void OptReferenceClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -4309,7 +4371,7 @@ void OptCheck::deep_delete() {
 };
 
 void OptCheck::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -4347,7 +4409,7 @@ IR *ConstraintType::translate(vector<IR *> &v_ir_collector) {
 void ConstraintType::deep_delete() { delete this; };
 
 void ConstraintType::generate(){
-    GENERATESTART(3)
+    GENERATESTART(3, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
             CASEEND SWITCHEND
@@ -4379,7 +4441,7 @@ void ReferenceClause::deep_delete() {
 };
 
 void ReferenceClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   table_name_ = new TableName();
   table_name_->generate();
@@ -4410,7 +4472,7 @@ IR *OptForeignKey::translate(vector<IR *> &v_ir_collector) {
 
 void OptForeignKey::deep_delete() { delete this; };
 
-void OptForeignKey::generate(){GENERATESTART(2)
+void OptForeignKey::generate(){GENERATESTART(2, 0)
 
                                    SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -4440,7 +4502,7 @@ void OptForeignKeyActions::deep_delete() {
 };
 
 void OptForeignKeyActions::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -4487,7 +4549,7 @@ void ForeignKeyActions::deep_delete() {
 };
 
 void ForeignKeyActions::generate() {
-  GENERATESTART(5)
+  GENERATESTART(5, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4535,7 +4597,7 @@ IR *KeyActions::translate(vector<IR *> &v_ir_collector) {
 
 void KeyActions::deep_delete() { delete this; };
 
-void KeyActions::generate(){GENERATESTART(5)
+void KeyActions::generate(){GENERATESTART(5, 0)
 
                                 SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                     CASEEND CASESTART(2) CASEEND CASESTART(3)
@@ -4570,7 +4632,7 @@ void OptConstraintAttributeSpec::deep_delete() {
 };
 
 void OptConstraintAttributeSpec::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -4610,7 +4672,7 @@ IR *OptInitialTime::translate(vector<IR *> &v_ir_collector) {
 void OptInitialTime::deep_delete() { delete this; };
 
 void OptInitialTime::generate(){
-    GENERATESTART(3)
+    GENERATESTART(3, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
 
@@ -4633,7 +4695,7 @@ void ConstraintName::deep_delete() {
 };
 
 void ConstraintName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   name_ = new Name();
   name_->generate();
@@ -4658,7 +4720,7 @@ IR *OptTemp::translate(vector<IR *> &v_ir_collector) {
 
 void OptTemp::deep_delete() { delete this; };
 
-void OptTemp::generate(){GENERATESTART(2)
+void OptTemp::generate(){GENERATESTART(2, 0)
 
                              SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -4690,7 +4752,7 @@ IR *OptCheckOption::translate(vector<IR *> &v_ir_collector) {
 void OptCheckOption::deep_delete() { delete this; };
 
 void OptCheckOption::generate(){
-    GENERATESTART(4)
+    GENERATESTART(4, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
             CASEEND CASESTART(3)
@@ -4721,7 +4783,7 @@ void OptColumnNameListP::deep_delete() {
 };
 
 void OptColumnNameListP::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -4761,7 +4823,7 @@ void SetClauseList::deep_delete() {
 };
 
 void SetClauseList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4776,7 +4838,7 @@ void SetClauseList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       set_clause_ = new SetClause();
@@ -4817,7 +4879,7 @@ void SetClause::deep_delete() {
 };
 
 void SetClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4859,7 +4921,7 @@ void OptAsAlias::deep_delete() {
 };
 
 void OptAsAlias::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -4918,7 +4980,7 @@ void Expr::deep_delete() {
 };
 
 void Expr::generate() {
-  GENERATESTART(6)
+  GENERATESTART(6, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -5014,7 +5076,7 @@ void Operand::deep_delete() {
 };
 
 void Operand::generate() {
-  GENERATESTART(10)
+  GENERATESTART(10, 3)
 
   SWITCHSTART
   CASESTART(0)
@@ -5079,7 +5141,7 @@ void CastExpr::deep_delete() {
 };
 
 void CastExpr::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_ = new Expr();
   expr_->generate();
@@ -5113,7 +5175,7 @@ void ScalarExpr::deep_delete() {
 };
 
 void ScalarExpr::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -5170,7 +5232,7 @@ void UnaryExpr::deep_delete() {
 };
 
 void UnaryExpr::generate() {
-  GENERATESTART(7)
+  GENERATESTART(7, 5)
 
   SWITCHSTART
   CASESTART(0)
@@ -5242,7 +5304,7 @@ void BinaryExpr::deep_delete() {
 };
 
 void BinaryExpr::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -5300,7 +5362,7 @@ void LogicExpr::deep_delete() {
 };
 
 void LogicExpr::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -5363,7 +5425,7 @@ void InExpr::deep_delete() {
 };
 
 void InExpr::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -5434,7 +5496,7 @@ void CaseExpr::deep_delete() {
 };
 
 void CaseExpr::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -5499,7 +5561,7 @@ void BetweenExpr::deep_delete() {
 };
 
 void BetweenExpr::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -5540,7 +5602,7 @@ void ExistsExpr::deep_delete() {
 };
 
 void ExistsExpr::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_not_ = new OptNot();
   opt_not_->generate();
@@ -5591,7 +5653,7 @@ void FunctionExpr::deep_delete() {
 };
 
 void FunctionExpr::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -5636,7 +5698,7 @@ IR *OptDistinct::translate(vector<IR *> &v_ir_collector) {
 
 void OptDistinct::deep_delete() { delete this; };
 
-void OptDistinct::generate(){GENERATESTART(2)
+void OptDistinct::generate(){GENERATESTART(2, 0)
 
                                  SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -5666,7 +5728,7 @@ void OptFilterClause::deep_delete() {
 };
 
 void OptFilterClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -5708,7 +5770,7 @@ void OptOverClause::deep_delete() {
 };
 
 void OptOverClause::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -5752,7 +5814,7 @@ void CaseList::deep_delete() {
 };
 
 void CaseList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -5767,7 +5829,7 @@ void CaseList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       case_clause_ = new CaseClause();
@@ -5798,7 +5860,7 @@ void CaseClause::deep_delete() {
 };
 
 void CaseClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_1_ = new Expr();
   expr_1_->generate();
@@ -5854,7 +5916,7 @@ void CompExpr::deep_delete() {
 };
 
 void CompExpr::generate() {
-  GENERATESTART(6)
+  GENERATESTART(6, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -5915,7 +5977,7 @@ void ExtractExpr::deep_delete() {
 };
 
 void ExtractExpr::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   datetime_field_ = new DatetimeField();
   datetime_field_->generate();
@@ -5955,7 +6017,7 @@ IR *DatetimeField::translate(vector<IR *> &v_ir_collector) {
 void DatetimeField::deep_delete() { delete this; };
 
 void DatetimeField::generate(){
-    GENERATESTART(6)
+    GENERATESTART(6, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
             CASEEND CASESTART(3) CASEEND CASESTART(4) CASEEND CASESTART(5)
@@ -5978,7 +6040,7 @@ void ArrayExpr::deep_delete() {
 };
 
 void ArrayExpr::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_list_ = new ExprList();
   expr_list_->generate();
@@ -6003,7 +6065,7 @@ void ArrayIndex::deep_delete() {
 };
 
 void ArrayIndex::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   operand_ = new Operand();
   operand_->generate();
@@ -6042,7 +6104,7 @@ void Literal::deep_delete() {
 };
 
 void Literal::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -6073,7 +6135,7 @@ IR *StringLiteral::translate(vector<IR *> &v_ir_collector) {
 void StringLiteral::deep_delete() { delete this; };
 
 void StringLiteral::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   string_val_ = gen_string();
 
@@ -6097,7 +6159,7 @@ IR *BoolLiteral::translate(vector<IR *> &v_ir_collector) {
 
 void BoolLiteral::deep_delete() { delete this; };
 
-void BoolLiteral::generate(){GENERATESTART(2)
+void BoolLiteral::generate(){GENERATESTART(2, 0)
 
                                  SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                      CASEEND SWITCHEND
@@ -6128,7 +6190,7 @@ void NumLiteral::deep_delete() {
 };
 
 void NumLiteral::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -6155,7 +6217,7 @@ IR *IntLiteral::translate(vector<IR *> &v_ir_collector) {
 void IntLiteral::deep_delete() { delete this; };
 
 void IntLiteral::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   int_val_ = gen_int();
 
@@ -6173,7 +6235,7 @@ IR *FloatLiteral::translate(vector<IR *> &v_ir_collector) {
 void FloatLiteral::deep_delete() { delete this; };
 
 void FloatLiteral::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   float_val_ = gen_float();
 
@@ -6197,7 +6259,7 @@ IR *OptColumn::translate(vector<IR *> &v_ir_collector) {
 
 void OptColumn::deep_delete() { delete this; };
 
-void OptColumn::generate(){GENERATESTART(2)
+void OptColumn::generate(){GENERATESTART(2, 0)
 
                                SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -6239,7 +6301,7 @@ void TriggerBody::deep_delete() {
 };
 
 void TriggerBody::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -6280,7 +6342,7 @@ IR *OptIfNotExist::translate(vector<IR *> &v_ir_collector) {
 
 void OptIfNotExist::deep_delete() { delete this; };
 
-void OptIfNotExist::generate(){GENERATESTART(2)
+void OptIfNotExist::generate(){GENERATESTART(2, 0)
 
                                    SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -6305,7 +6367,7 @@ IR *OptIfExist::translate(vector<IR *> &v_ir_collector) {
 
 void OptIfExist::deep_delete() { delete this; };
 
-void OptIfExist::generate(){GENERATESTART(2)
+void OptIfExist::generate(){GENERATESTART(2, 0)
 
                                 SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -6324,7 +6386,7 @@ IR *Identifier::translate(vector<IR *> &v_ir_collector) {
 void Identifier::deep_delete() { delete this; };
 
 void Identifier::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   string_val_ = gen_string();
 
@@ -6346,7 +6408,7 @@ void AsAlias::deep_delete() {
 };
 
 void AsAlias::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -6369,7 +6431,7 @@ void TableName::deep_delete() {
 };
 
 void TableName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -6392,7 +6454,7 @@ void ColumnName::deep_delete() {
 };
 
 void ColumnName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -6424,7 +6486,7 @@ IR *OptIndexKeyword::translate(vector<IR *> &v_ir_collector) {
 void OptIndexKeyword::deep_delete() { delete this; };
 
 void OptIndexKeyword::generate(){
-    GENERATESTART(4)
+    GENERATESTART(4, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
             CASEEND CASESTART(3)
@@ -6448,7 +6510,7 @@ void ViewName::deep_delete() {
 };
 
 void ViewName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -6471,7 +6533,7 @@ void FunctionName::deep_delete() {
 };
 
 void FunctionName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -6508,7 +6570,7 @@ IR *BinaryOp::translate(vector<IR *> &v_ir_collector) {
 
 void BinaryOp::deep_delete() { delete this; };
 
-void BinaryOp::generate(){GENERATESTART(6)
+void BinaryOp::generate(){GENERATESTART(6, 0)
 
                               SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                   CASEEND CASESTART(2) CASEEND CASESTART(3)
@@ -6534,7 +6596,7 @@ IR *OptNot::translate(vector<IR *> &v_ir_collector) {
 
 void OptNot::deep_delete() { delete this; };
 
-void OptNot::generate(){GENERATESTART(2)
+void OptNot::generate(){GENERATESTART(2, 0)
 
                             SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -6557,7 +6619,7 @@ void Name::deep_delete() {
 };
 
 void Name::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -6589,7 +6651,7 @@ void TypeName::deep_delete() {
 };
 
 void TypeName::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -6629,7 +6691,7 @@ void CharacterType::deep_delete() {
 };
 
 void CharacterType::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -6662,7 +6724,7 @@ void CharacterWithLength::deep_delete() {
 };
 
 void CharacterWithLength::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   character_conflicta_ = new CharacterConflicta();
   character_conflicta_->generate();
@@ -6700,7 +6762,7 @@ void CharacterWithoutLength::deep_delete() {
 };
 
 void CharacterWithoutLength::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -6760,7 +6822,7 @@ IR *CharacterConflicta::translate(vector<IR *> &v_ir_collector) {
 void CharacterConflicta::deep_delete() { delete this; };
 
 void CharacterConflicta::generate(){
-    GENERATESTART(10)
+    GENERATESTART(10, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
             CASEEND CASESTART(3) CASEEND CASESTART(4) CASEEND CASESTART(5)
@@ -6820,7 +6882,7 @@ IR *NumericType::translate(vector<IR *> &v_ir_collector) {
 void NumericType::deep_delete() { delete this; };
 
 void NumericType::generate(){
-    GENERATESTART(13)
+    GENERATESTART(13, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
             CASEEND CASESTART(3) CASEEND CASESTART(4) CASEEND CASESTART(5)
@@ -6853,7 +6915,7 @@ void OptTableConstraintList::deep_delete() {
 };
 
 void OptTableConstraintList::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -6893,7 +6955,7 @@ void TableConstraintList::deep_delete() {
 };
 
 void TableConstraintList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -6908,7 +6970,7 @@ void TableConstraintList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       table_constraint_ = new TableConstraint();
@@ -6968,7 +7030,7 @@ void TableConstraint::deep_delete() {
 };
 
 void TableConstraint::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -7025,7 +7087,7 @@ IR *OptEnforced::translate(vector<IR *> &v_ir_collector) {
 void OptEnforced::deep_delete() { delete this; };
 
 void OptEnforced::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 0)
 
   SWITCHSTART
   CASESTART(0)
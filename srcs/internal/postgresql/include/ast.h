@@ -1,10 +1,13 @@
 #ifndef __AST_H__
 #define __AST_H__
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
 
 #include "define.h"
+#include "utils/arena.h"
+#include "utils/hash.h"
 using namespace std;
 
 enum NODETYPE {
@@ -13,6 +16,11 @@ enum NODETYPE {
 #undef DECLARE_TYPE
 };
 typedef NODETYPE IRTYPE;
+// The number of node types, for arrays indexed by them. Not an enumerator,
+// so that switches over NODETYPE need not handle it.
+#define COUNT_TYPE(v) +1
+inline constexpr uint32_t kNodeTypeCount = 0 ALLTYPE(COUNT_TYPE);
+#undef COUNT_TYPE
 
 enum CASEIDX {
   CASE0,
@@ -423,22 +431,41 @@ enum DATATYPE {
 #undef DECLARE_TYPE
 };
 
-#define GEN_NAME() name_ = gen_id_name();
+#define GEN_NAME() node_id_ = g_id_counter++;
 
-static unsigned long g_id_counter;
+// Per thread, since trees are validated on several threads at once.
+static thread_local unsigned long g_id_counter;
 
 static inline void reset_id_counter() { g_id_counter = 0; }
 
 static string gen_id_name() { return "v" + to_string(g_id_counter++); }
 
+// Operators are interned: there is exactly one immutable IROperator per
+// distinct (prefix, middle, suffix) triple, shared by every IR using it.
+// Obtain them with `IROperator::get` or the OP* macros in define.h.
 class IROperator {
  public:
-  IROperator(string prefix = "", string middle = "", string suffix = "")
-      : prefix_(prefix), middle_(middle), suffix_(suffix) {}
-
-  string prefix_;
-  string middle_;
-  string suffix_;
+  static const IROperator* get(const string& prefix = "",
+                               const string& middle = "",
+                               const string& suffix = "");
+
+  const string prefix_;
+  const string middle_;
+  const string suffix_;
+  // Dense index of the operator in the interning table.
+  const unsigned int id_;
+  utils::TokenHash prefix_hash_;
+  utils::TokenHash middle_hash_;
+  utils::TokenHash suffix_hash_;
+
+ private:
+  IROperator(const string& prefix, const string& middle, const string& suffix,
+             unsigned int id)
+      : prefix_(prefix), middle_(middle), suffix_(suffix), id_(id) {
+    prefix_hash_.append(prefix_);
+    middle_hash_.append(middle_);
+    suffix_hash_.append(suffix_);
+  }
 };
 
 enum UnionType {
@@ -473,7 +500,14 @@ enum DATAFLAG {
 
 class IR {
  public:
-  IR(IRTYPE type, IROperator* op, IR* left = NULL, IR* right = NULL)
+  // IR nodes are allocated from the current utils::Arena, if any, so that a
+  // whole mutation round can be released at once.
+  static void* operator new(size_t size) {
+    return utils::arena_aware_new(size);
+  }
+  static void operator delete(void* ptr) { utils::arena_aware_delete(ptr); }
+
+  IR(IRTYPE type, const IROperator* op, IR* left = NULL, IR* right = NULL)
       : type_(type),
         op_(op),
         left_(left),
@@ -553,15 +587,15 @@ class IR {
     GEN_NAME();
   }
 
-  IR(IRTYPE type, IROperator* op, IR* left, IR* right, double f_val,
-     string str_val, string name, unsigned int mutated_times, int scope,
-     DATAFLAG flag)
+  IR(IRTYPE type, const IROperator* op, IR* left, IR* right, double f_val,
+     string str_val, unsigned long node_id, unsigned int mutated_times,
+     int scope, DATAFLAG flag)
       : type_(type),
         op_(op),
         left_(left),
         right_(right),
         operand_num_((!!right) + (!!left)),
-        name_(name),
+        node_id_(node_id),
         str_val_(str_val),
         float_val_(f_val),
         mutated_times_(mutated_times),
@@ -571,11 +605,7 @@ class IR {
 
   IR(const IR* ir, IR* left, IR* right) {
     this->type_ = ir->type_;
-    if (ir->op_ != NULL)
-      this->op_ = OP3(ir->op_->prefix_, ir->op_->middle_, ir->op_->suffix_);
-    else {
-      this->op_ = OP0();
-    }
+    this->op_ = ir->op_ != NULL ? ir->op_ : OP0();
     this->left_ = left;
     this->right_ = right;
     this->str_val_ = ir->str_val_;
@@ -583,7 +613,7 @@ class IR {
     this->data_type_ = ir->data_type_;
     this->scope_ = ir->scope_;
     this->data_flag_ = ir->data_flag_;
-    this->name_ = ir->name_;
+    this->node_id_ = ir->node_id_;
     this->operand_num_ = ir->operand_num_;
     this->mutated_times_ = ir->mutated_times_;
   }
@@ -599,18 +629,32 @@ class IR {
   DATAFLAG data_flag_;
   DATATYPE data_type_;
   IRTYPE type_;
-  string name_;
+  // Debug name of the node, derived from `node_id_`.
+  string name() const { return "v" + std::to_string(node_id_); }
+
+  unsigned long node_id_;
 
   string str_val_;
 
-  IROperator* op_;
+  const IROperator* op_;
   IR* left_;
   IR* right_;
   int operand_num_;
   unsigned int mutated_times_ = 0;
 
   string to_string();
-  string to_string_core();
+  // Appends the untrimmed SQL of this subtree to `res`.
+  void to_string_core(string& res);
+
+  // Hash of the SQL of the subtree, assembled from the operator, the literal
+  // and the hashes of the children. Only valid right after `structural_hash`
+  // or `update_hash`, since trees are edited in place.
+  utils::TokenHash hash_;
+  // Recomputes `hash_` for every node of the subtree, bottom-up, and returns
+  // its digest.
+  unsigned long structural_hash();
+  // Recomputes `hash_` of this node from the `hash_` of its children.
+  unsigned long update_hash();
 };
 
 class Node {
@@ -624,7 +668,14 @@ class Node {
   virtual IR* translate(vector<IR*>& v_ir_collector);
   virtual void generate() {}
   virtual void deep_delete() {}
-  Node(){};
+  // The parser sets the attributes of the nodes that have some, `generate`
+  // does not.
+  Node()
+      : type_(),
+        data_type_(kDataWhatever),
+        data_flag_(),
+        scope_(0),
+        case_idx_(0){};
   ~Node(){};
 };
 
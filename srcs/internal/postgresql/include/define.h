@@ -307,7 +307,12 @@
 
 #define TRANSLATESTART IR *res = NULL;
 
-#define GENERATESTART(len) case_idx_ = rand() % len;
+// `len` alternatives, the ones past the cases of the rule going to its
+// `default:`, and the one with the shortest derivation, see
+// utils::GenerateRule.
+#define GENERATESTART(len, shortest) \
+  utils::GenerateRule generate_rule; \
+  case_idx_ = generate_rule.pick(len, shortest);
 
 #define GENERATEEND return;
 
@@ -326,19 +331,27 @@
 #define SAFEDELETELIST(a) \
   for (auto _i : a) SAFEDELETE(_i)
 
-#define OP1(a) new IROperator(a)
+// Interns the operator once per call site, so the arguments must be string
+// literals. Use `IROperator::get` for operators built at run time.
+#define OP_INTERNED(a, b, c)                                \
+  ([]() {                                                   \
+    static const IROperator *op = IROperator::get(a, b, c); \
+    return op;                                              \
+  }())
 
-#define OP2(a, b) new IROperator(a, b)
+#define OP1(a) OP_INTERNED(a, "", "")
 
-#define OP3(a, b, c) new IROperator(a, b, c)
+#define OP2(a, b) OP_INTERNED(a, b, "")
 
-#define OPSTART(a) new IROperator(a)
+#define OP3(a, b, c) OP_INTERNED(a, b, c)
 
-#define OPMID(a) new IROperator("", a, "")
+#define OPSTART(a) OP_INTERNED(a, "", "")
 
-#define OPEND(a) new IROperator("", "", a)
+#define OPMID(a) OP_INTERNED("", a, "")
 
-#define OP0() new IROperator()
+#define OPEND(a) OP_INTERNED("", "", a)
+
+#define OP0() OP_INTERNED("", "", "")
 
 #define TRANSLATELIST(t, a, b)           \
   res = SAFETRANSLATE(a[0]);             \
@@ -352,10 +365,9 @@
 
 #define PUSH(a) v_ir_collector.push_back(a)
 
-#define MUTATESTART               \
-  IR *res = NULL;                 \
-  auto randint = get_rand_int(3); \
-  switch (randint) {
+#define MUTATESTART \
+  IR *res = NULL;   \
+  switch (mutate_side_) {
 #define DOLEFT case 0: {
 #define DORIGHT \
   break;        \
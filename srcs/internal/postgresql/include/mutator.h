@@ -1,17 +1,33 @@
 #ifndef __MUTATOR_H__
 #define __MUTATOR_H__
 
+#include <array>
 #include <map>
+#include <memory>
 #include <set>
 
 #include "ast.h"
 #include "define.h"
+#include "shared_library.h"
 #include "utils.h"
+#include "absl/container/flat_hash_set.h"
+#include "utils/arena.h"
+#include "utils/dedup_filter.h"
+#include "utils/enum_set.h"
+#include "utils/generate.h"
+#include "utils/library_weights.h"
+#include "utils/grammar_check.h"
+#include "utils/mutation_trace.h"
+#include "utils/operator_schedule.h"
+#include "utils/rng.h"
+#include "utils/thread_pool.h"
 
 #define LUCKY_NUMBER 500
 
 using namespace std;
 
+typedef utils::DenseEnumSet<IRTYPE, kNodeTypeCount> IRTypeSet;
+
 enum RELATIONTYPE {
   kRelationElement,
   kRelationSubtype,
@@ -20,8 +36,6 @@ enum RELATIONTYPE {
 
 class Mutator {
  public:
-  Mutator() { srand(time(nullptr)); }
-
   IR *deep_copy_with_record(const IR *root, const IR *record);
   unsigned long hash(IR *);
   unsigned long hash(string &);
@@ -29,7 +43,19 @@ class Mutator {
   IR *ir_random_generator(vector<IR *> v_ir_collector);
 
   vector<IR *> mutate_all(vector<IR *> &v_ir_collector);        // done
+  // Same as above, with the work spread over `pool`.
+  vector<IR *> mutate_all(vector<IR *> &v_ir_collector,
+                          utils::ThreadPool &pool);
   vector<IR *> mutate(IR *input);                               // done
+  // The variants of `input`, which is left untouched. With `traces`, adds
+  // how each of them was made. With `replayed`, the trace of a variant made
+  // before, only makes that one again, with the same library entries. The
+  // operators the scheduler, if any, skips are not built at all.
+  vector<IR *> make_variants(IR *input,
+                             vector<utils::MutationTrace> *traces = NULL,
+                             const utils::MutationTrace *replayed = NULL);
+  // Counts the `variants` made from `input` in their `mutated_times_`.
+  void count_mutation(IR *input, vector<IR *> &variants);
   IR *strategy_delete(IR *cur);                                 // Done
   IR *strategy_insert(IR *cur);                                 // Done
   IR *strategy_replace(IR *cur);                                // done
@@ -54,7 +80,27 @@ class Mutator {
   string get_a_string();            // DONE
   unsigned long get_a_val();        // DONE
   IR *get_ir_from_library(IRTYPE);  // DONE
-  IR *generate_ir_by_type(IRTYPE);  // Done
+  // A tree of `type` built from the grammar within the bounds of the
+  // generate options, the same for the same `seed`, or NULL if no rule
+  // builds one.
+  IR *generate_ir_by_type(IRTYPE, uint64_t seed);  // Done
+  // A generated tree of `type` for `get_ir_from_library`, memoized or new,
+  // or NULL if there is none. `library_size` is for the trace.
+  IR *get_generated_ir(IRTYPE type, size_t library_size);
+  // How `get_ir_from_library` generates trees, see utils::GenerateOptions.
+  void set_generate_options(const utils::GenerateOptions &options);
+  // Draws library entries by their score rather than uniformly, see
+  // utils::LibraryWeights.
+  void set_library_weights(const utils::LibraryWeightOptions &options);
+  // Samples the operators of `make_variants` with `scheduler`, which must
+  // outlive the mutator. It is read by the threads of `mutate_all`.
+  void set_operator_scheduler(utils::OperatorScheduler *scheduler) {
+    scheduler_ = scheduler;
+  }
+  // The entries of `picks` went into a mutant that ran, or that became a
+  // queue entry.
+  void library_ran(const vector<utils::LibraryPick> &picks);
+  void library_found(const vector<utils::LibraryPick> &picks);
 
   string get_data_by_type(DATATYPE);
   pair<string, string> get_data_2d_by_type(DATATYPE, DATATYPE);  // DONE
@@ -68,22 +114,29 @@ class Mutator {
   bool fix(IR *root);  // done
 
   vector<IR *> split_to_stmt(IR *root, map<IR **, IR *> &m_save,
-                             set<IRTYPE> &split_set);  // done
+                             const IRTypeSet &split_set);  // done
   bool connect_back(map<IR **, IR *> &m_save);         // done
 
   bool fix_one(IR *stmt_root,
                map<int, map<DATATYPE, vector<IR *>>> &scope_library);  // done
 
   void analyze_scope(IR *stmt_root);
+  // Also lists the nodes of the graph in `order`, the order in which they
+  // are filled: iterating the map follows the addresses of the nodes, so
+  // the draws of `fix` would depend on where the tree was allocated.
   map<IR *, vector<IR *>> build_graph(
-      IR *stmt_root, map<int, map<DATATYPE, vector<IR *>>> &scope_library);
-  bool fill_stmt_graph(map<IR *, vector<IR *>> &graph);              // done
+      IR *stmt_root, map<int, map<DATATYPE, vector<IR *>>> &scope_library,
+      vector<IR *> &order);
+  bool fill_stmt_graph(map<IR *, vector<IR *>> &graph,
+                       const vector<IR *> &order);                   // done
   void clear_scope_library(bool clear_define);                       // done
   IR *find_closest_node(IR *stmt_root, IR *node, DATATYPE type);     // done
   bool fill_one(IR *parent);                                         // done
   bool fill_one_pair(IR *parent, IR *child);                         // done
   bool fill_stmt_graph_one(map<IR *, vector<IR *>> &graph, IR *ir);  // done
-  bool validate(IR *&root);                                          // done
+  // With `trace`, takes the check path it holds if any, or records the one
+  // taken in it.
+  bool validate(IR *&root, utils::MutationTrace *trace = NULL);
 
   unsigned int calc_node(IR *root);
   bool replace_one_value_from_datalibray_2d(DATATYPE p_datatype,
@@ -101,29 +154,109 @@ class Mutator {
 
   void add_ir_to_library_no_deepcopy(IR *);  // DONE
 
-  IR *record_ = NULL;
+  // Writes the libraries to a binary snapshot, see utils/snapshot.h.
+  bool save_snapshot(const string &path);
+  // Replaces the libraries with those of a snapshot written by
+  // `save_snapshot`, without parsing any SQL. Call `init()` first for the
+  // fixed tables. Returns false if the snapshot is missing or unusable.
+  bool load_snapshot(const string &path);
+  // Reads the libraries that follow the IR library in a snapshot.
+  bool load_snapshot_tail(utils::SnapshotReader &reader);
+  // Uses the IR library of a snapshot in place, shared with every other
+  // instance attached to it, instead of a private copy. Trees added to the
+  // library from then on are exchanged through the log at `log_path`. Call
+  // `init()` first for the fixed tables.
+  bool attach_shared_library(const string &snapshot_path,
+                             const string &log_path, size_t log_capacity);
+  // Picks up the trees other instances added to the shared library.
+  size_t sync_shared_library();
+
+  // Replaces the filter of the mutants made so far by an empty one of
+  // `bytes`.
+  void set_mutant_filter_budget(size_t bytes) {
+    mutant_filter_ = utils::DedupFilter(bytes);
+  }
+  const utils::DedupFilter &mutant_filter() const { return mutant_filter_; }
+
+  // Learns the productions of `root`, a tree built by the parser.
+  void learn_productions(IR *root);
+  // Whether every node of `root` is a production of some parsed tree, i.e.
+  // whether it can skip the parser in `validate`.
+  bool well_formed(IR *root) const;
+  void set_validate_mode(utils::ValidateMode mode) { validate_mode_ = mode; }
+  // The generator of every draw made for this mutator, see utils::RngScope.
+  utils::Rng &rng() { return rng_; }
+  // How each mutant of the last `mutate_all` was made, in the same order.
+  vector<utils::MutationTrace> &mutation_traces() { return mutation_traces_; }
+  // Makes again the mutant of the tree of `v_ir_collector` described by
+  // `trace`, or returns NULL if the node has no such variant. Sets
+  // `library` to the entries it took, which are those of the trace unless
+  // the library changed.
+  IR *replay_mutation(vector<IR *> &v_ir_collector,
+                      const utils::MutationTrace &trace,
+                      vector<utils::LibraryPick> *library);
+  // The counters of the grammar check as one line of text.
+  string describe_validation() const;
+  // The same for the generated trees.
+  string describe_generation() const;
+  // The same for the library weights, or "" without them.
+  string describe_library_weights() const;
+  // Deletes the shared entries built during the previous round.
+  void release_fetched();
+  // Deletes the generated trees dropped during the previous round.
+  void release_generated();
+  // Rebuilds the tables of `library_weights_` that need it, between rounds.
+  void refresh_library_weights();
+  // The entry the variant being made again took at this point, if any.
+  const utils::LibraryPick *replayed_pick() const;
+  // Whether every subtree of `root`, hashed beforehand, is in the library.
+  bool library_has_all(IR *root);
+  // The production that `node` stands for, see utils::ProductionSet.
+  static uint64_t production_key(const IR *node);
+
+  // Scratch state of mutation and validation. It is per thread, so that
+  // several trees can be mutated or validated at once.
+  static thread_local IR *record_;
   IR *mutated_root_ = NULL;
-  map<IRTYPE, vector<IR *>> ir_library_;
-  map<IRTYPE, set<unsigned long>> ir_library_hash_;
+  // Backing storage for every tree kept in `ir_library_`.
+  utils::Arena library_arena_;
+  array<vector<IR *>, kNodeTypeCount> ir_library_;
+  array<absl::flat_hash_set<unsigned long>, kNodeTypeCount> ir_library_hash_;
+  // When attached, `ir_library_` only holds what this instance generated
+  // itself, and `ir_library_hash_` covers the shared entries as well.
+  unique_ptr<SharedLibrary> shared_library_;
+  // Shared entries picked by this thread during the current round, built on
+  // demand.
+  static thread_local utils::Arena fetch_arena_;
+  static thread_local vector<IR *> fetched_;
+  // Where `get_ir_from_library` records the entries it takes, if anywhere.
+  static thread_local vector<utils::LibraryPick> *picks_;
+  // The entries taken by the variant being made again, if any.
+  static thread_local const vector<utils::LibraryPick> *replayed_picks_;
+  // The children MUTATESTART changes, drawn by `make_variants` before the
+  // strategy runs, see MutationTrace::side.
+  static thread_local unsigned mutate_side_;
 
   vector<string> string_library_;
-  set<unsigned long> string_library_hash_;
+  absl::flat_hash_set<unsigned long> string_library_hash_;
   vector<unsigned long> value_library_;
 
   map<DATATYPE, map<DATATYPE, RELATIONTYPE>> relationmap_;
 
   vector<string> common_string_library_;
-  set<IRTYPE> not_mutatable_types_;
-  set<IRTYPE> string_types_;
-  set<IRTYPE> int_types_;
-  set<IRTYPE> float_types_;
+  IRTypeSet not_mutatable_types_;
+  IRTypeSet string_types_;
+  IRTypeSet int_types_;
+  IRTypeSet float_types_;
 
-  set<IRTYPE> safe_generate_type_;
-  set<IRTYPE> split_stmt_types_;
-  set<IRTYPE> split_substmt_types_;
+  IRTypeSet safe_generate_type_;
+  IRTypeSet split_stmt_types_;
+  IRTypeSet split_substmt_types_;
 
-  map<DATATYPE, vector<string>> data_library_;
-  map<DATATYPE, map<string, map<DATATYPE, vector<string>>>> data_library_2d_;
+  // Per-thread scratch of `validate`.
+  static thread_local map<DATATYPE, vector<string>> data_library_;
+  static thread_local map<DATATYPE, map<string, map<DATATYPE, vector<string>>>>
+      data_library_2d_;
 
   map<DATATYPE, vector<string>> g_data_library_;
   map<DATATYPE, set<unsigned long>> g_data_library_hash_;
@@ -131,9 +264,35 @@ class Mutator {
   map<DATATYPE, map<string, map<DATATYPE, vector<string>>>>
       g_data_library_2d_hash_;
 
-  map<int, map<DATATYPE, vector<IR *>>> scope_library_;
-
-  set<unsigned long> global_hash_;
+  static thread_local map<int, map<DATATYPE, vector<IR *>>> scope_library_;
+
+  // The structural hashes of the mutants made so far, to drop repeats.
+  utils::DedupFilter mutant_filter_;
+
+  utils::ProductionSet productions_;
+  utils::ValidateMode validate_mode_ = utils::ValidateMode::kReparse;
+  // Seeded from AFL++, see DataBase::seed.
+  utils::Rng rng_;
+  utils::GrammarCheckStats validate_stats_;
+  vector<utils::MutationTrace> mutation_traces_;
+
+  // One in this many generated picks makes a new tree even when the memo
+  // slot drawn holds one, and replaces it.
+  static constexpr int kGenerateRefresh = 8;
+  utils::GenerateOptions generate_options_;
+  // By type, set from `generate_options_`.
+  array<double, kNodeTypeCount> generate_weights_{};
+  // The memoized trees of each type, in `memo_size` slots, on the heap,
+  // and the ones dropped from them during the current round.
+  struct GeneratedTree {
+    uint64_t seed = 0;
+    IR *tree = NULL;
+  };
+  array<vector<GeneratedTree>, kNodeTypeCount> generated_;
+  vector<IR *> retired_;
+  utils::GenerateStats generate_stats_;
+  unique_ptr<utils::LibraryWeights> library_weights_;
+  utils::OperatorScheduler *scheduler_ = nullptr;
 };
 
 #endif
@@ -0,0 +1,99 @@
+#ifndef __SHARED_LIBRARY_H__
+#define __SHARED_LIBRARY_H__
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+#include "utils/append_log.h"
+#include "utils/snapshot.h"
+
+// One IR node of a snapshot or of a record of the shared log. Children are
+// referred to by their index in the same table and always come first;
+// `str_offset` points into the table's string pool.
+struct NodeRecord {
+  uint32_t type;
+  uint32_t op;
+  uint32_t left;
+  uint32_t right;
+  uint64_t long_val;
+  uint64_t node_id;
+  // Digest of the structural hash of the subtree, see IR::update_hash.
+  uint64_t hash;
+  uint32_t str_offset;
+  uint32_t str_size;
+  int32_t scope;
+  uint32_t data_flag;
+  uint32_t data_type;
+  uint32_t mutated_times;
+};
+
+// The IR library shared by every fuzzer instance on a machine: the trees of a
+// snapshot, mapped read-only so that all instances use the same pages, plus
+// the trees the instances have found since, which they exchange through an
+// AppendLog. Entries stay in their on-disk form and are turned into IR only
+// when the mutator picks one.
+class SharedLibrary {
+ public:
+  // Maps the IR library of `snapshot_path` and the log at `log_path`.
+  bool attach(const std::string &snapshot_path, const std::string &log_path,
+              size_t log_capacity);
+  // The snapshot, positioned after the IR library for the caller to read the
+  // rest of it.
+  utils::SnapshotReader &snapshot() { return *snapshot_; }
+
+  size_t size(IRTYPE type) const {
+    return base_[type].size() + appended_[type].size();
+  }
+  // Builds entry `i` of the `type` list in the current arena.
+  IR *materialize(IRTYPE type, size_t i) const;
+  // The digest of entry `i` of the `type` list, without building it.
+  uint64_t hash(IRTYPE type, size_t i) const;
+  // Builds every entry into `lists`, sharing common subtrees, in the current
+  // arena. Every node built is also added to `nodes`, for the caller to
+  // delete each of them once.
+  void materialize_all(std::array<std::vector<IR *>, kNodeTypeCount> &lists,
+                       std::vector<IR *> &nodes) const;
+  // The digest of every node of the snapshot library.
+  void for_each_base_hash(
+      const std::function<void(IRTYPE, uint64_t)> &f) const;
+
+  // Appends the tree at `root`, whose hashes must be up to date, to the log.
+  bool publish(const IR *root);
+  // Adds the nodes of the records appended to the log since the last call.
+  // `accept(type, hash)` decides whether a node becomes an entry, so that
+  // the caller can drop the ones it already has.
+  size_t sync(const std::function<bool(IRTYPE, uint64_t)> &accept);
+
+ private:
+  struct Segment {
+    utils::RecordView<NodeRecord> nodes;
+    std::string_view strings;
+    std::vector<const IROperator *> ops;
+  };
+  struct Ref {
+    uint32_t segment;
+    uint32_t node;
+  };
+
+  // Builds the subtree at `node`. With a `cache`, nodes built before are
+  // reused; with `built`, every new node is recorded.
+  IR *build(const Segment &segment, uint32_t node, std::vector<IR *> *cache,
+            std::vector<IR *> *built) const;
+
+  std::unique_ptr<utils::SnapshotReader> snapshot_;
+  utils::AppendLog log_;
+  uint64_t log_cursor_ = 0;
+  // Segment 0 is the snapshot, the others are records of the log.
+  std::deque<Segment> segments_;
+  std::array<utils::RecordView<uint32_t>, kNodeTypeCount> base_;
+  std::array<std::vector<Ref>, kNodeTypeCount> appended_;
+};
+
+#endif
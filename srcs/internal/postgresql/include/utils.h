@@ -6,10 +6,11 @@
 
 #include "../parser/bison_parser.h"
 #include "../parser/flex_lexer.h"
+#include "utils/rng.h"
 using std::string;
 using std::vector;
 
-#define get_rand_int(range) rand() % (range)
+#define get_rand_int(range) utils::rand_below(range)
 #define vector_rand_ele_safe(a) \
   (a.size() != 0 ? a[get_rand_int(a.size())] : gen_id_name())
 #define vector_rand_ele(a) (a[get_rand_int(a.size())])
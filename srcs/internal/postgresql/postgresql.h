@@ -2,8 +2,19 @@
 #define __POSTGRESQL_H__
 #include <memory>
 #include <stack>
+#include <string>
 
 #include "db.h"
+#include "utils/append_log.h"
+#include "utils/arena.h"
+#include "utils/dedup_filter.h"
+#include "utils/generate.h"
+#include "utils/grammar_check.h"
+#include "utils/library_weights.h"
+#include "utils/mutant_feedback.h"
+#include "utils/mutation_trace.h"
+#include "utils/operator_schedule.h"
+#include "utils/thread_pool.h"
 
 class Mutator;
 class IR;
@@ -20,11 +31,61 @@ class PostgreSQLDB : public DataBase {
   virtual bool has_mutated_test_cases();
   // Clean up the enviroment, e.g., drop all the databases.
   virtual bool clean_up() { return true; }
+  virtual bool save_library(const std::string &path);
+  virtual bool load_library(const std::string &path);
+  virtual void seed(uint64_t seed);
+  virtual bool replay(const std::string &seed, const std::string &trace,
+                      std::string *mutant);
+  virtual std::string describe();
 
  private:
   size_t validate_all(std::vector<IR *> &ir_set);
+  // Writes the probabilities of `scheduler_` to `operator_stats_`.
+  void save_schedule();
+  // The text of a validated mutant, with its trace if `trace_mutations_`.
+  std::string test_case(IR *ir, utils::MutationTrace &trace) const;
+  void init_library(const std::string &init_lib_path,
+                    const std::string &data_lib);
+  // Switches to the shared library of `lib_snapshot_` and `lib_shared_log_`.
+  bool attach_library();
+  // A mutator set up with the options of `initialize`.
+  std::unique_ptr<Mutator> new_mutator();
   std::unique_ptr<Mutator> mutator_;
   std::stack<std::string> validated_test_cases_;
+  // What made each validated test case.
+  std::stack<utils::MutantOrigin> validated_origins_;
+  // Every IR built by one call to `mutate` is allocated here.
+  utils::Arena round_arena_;
+  bool use_round_arena_ = true;
+  // Mutates and validates on `mutate_threads` threads when there are more
+  // than one.
+  std::unique_ptr<utils::ThreadPool> pool_;
+  // Snapshot of the libraries, loaded instead of parsing `init_lib` and
+  // rewritten every `lib_snapshot_interval_` interesting queries.
+  std::string lib_snapshot_;
+  size_t lib_snapshot_interval_ = 0;
+  size_t interesting_queries_ = 0;
+  // Log through which instances sharing `lib_snapshot_` exchange new trees.
+  std::string lib_shared_log_;
+  size_t lib_shared_log_capacity_ = utils::AppendLog::kDefaultCapacity;
+  // Memory of the filter that drops repeated mutants, see `dedup_filter_mb`.
+  size_t mutant_filter_bytes_ = utils::DedupFilter::kDefaultBytes;
+  utils::ValidateMode validate_mode_ = utils::ValidateMode::kReparse;
+  // Whether and how subtrees are generated from the grammar, see `generate`.
+  utils::GenerateOptions generate_options_;
+  // Whether mutants start with their trace, see `mutation_trace`.
+  bool trace_mutations_ = false;
+  // utils::seed_hash of the seed being mutated.
+  uint64_t seed_hash_ = 0;
+  // Learns which operators make queue entries, see `operator_schedule`.
+  std::unique_ptr<utils::OperatorScheduler> scheduler_;
+  std::string operator_stats_;
+  // Scores the library entries by the queue entries, see `library_weights`.
+  bool library_weights_ = false;
+  utils::LibraryWeightOptions library_weight_options_;
+  // The mutants handed out last, for the feedback of `scheduler_` and of
+  // the library weights.
+  utils::RecentMutants recent_mutants_;
 };
 
 PostgreSQLDB *create_postgresql();
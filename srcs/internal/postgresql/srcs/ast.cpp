@@ -1,12 +1,33 @@
 #include "../include/ast.h"
 
 #include <cassert>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 #include "../include/define.h"
 #include "../include/utils.h"
+#include "utils/generate.h"
 
 static string s_table_name;
 
+const IROperator *IROperator::get(const string &prefix, const string &middle,
+                                  const string &suffix) {
+  // Never destroyed, so that operators outlive every static IR.
+  static auto *table =
+      new map<std::tuple<string, string, string>, const IROperator *>();
+  static std::mutex table_mutex;
+
+  std::lock_guard<std::mutex> lock(table_mutex);
+  auto key = std::make_tuple(prefix, middle, suffix);
+  auto iter = table->find(key);
+  if (iter != table->end()) return iter->second;
+
+  auto *op = new IROperator(prefix, middle, suffix, table->size());
+  table->emplace(std::move(key), op);
+  return op;
+}
+
 Node *generate_ast_node_by_type(IRTYPE type) {
 #define DECLARE_CASE(classname) \
   if (type == k##classname) return new classname();
@@ -60,8 +81,6 @@ void deep_delete(IR *root) {
   if (root->left_) deep_delete(root->left_);
   if (root->right_) deep_delete(root->right_);
 
-  if (root->op_) delete root->op_;
-
   delete root;
 }
 
@@ -77,34 +96,91 @@ IR *deep_copy(const IR *root) {
 }
 
 string IR::to_string() {
-  auto res = to_string_core();
-  trim_string(res);
-  return res;
+  // The whole tree is written into one buffer that keeps its capacity between
+  // calls, and trimmed once.
+  static thread_local string buffer;
+  buffer.clear();
+  to_string_core(buffer);
+  trim_string(buffer);
+  return buffer;
 }
 
-string IR::to_string_core() {
+void IR::to_string_core(string &res) {
   switch (type_) {
     case kIntLiteral:
-      return std::to_string(int_val_);
+      res += std::to_string(int_val_);
+      return;
     case kFloatLiteral:
-      return std::to_string(float_val_);
+      res += std::to_string(float_val_);
+      return;
     case kIdentifier:
-      return str_val_;
     case kStringLiteral:
-      return str_val_;
+      res += str_val_;
+      return;
   }
 
-  string res;
-
   if (op_ != NULL) {
-    res += op_->prefix_ + " ";
+    res += op_->prefix_;
+    res += ' ';
+  }
+  if (left_ != NULL) {
+    left_->to_string_core(res);
+    res += ' ';
+  }
+  if (op_ != NULL) {
+    res += op_->middle_;
+    res += ' ';
+  }
+  if (right_ != NULL) {
+    right_->to_string_core(res);
+    res += ' ';
   }
-  if (left_ != NULL) res += left_->to_string_core() + " ";
-  if (op_ != NULL) res += op_->middle_ + " ";
-  if (right_ != NULL) res += right_->to_string_core() + " ";
   if (op_ != NULL) res += op_->suffix_;
+}
+
+unsigned long IR::update_hash() {
+  // Follows to_string_core piece by piece, so that trees printing the same
+  // SQL share a hash no matter how they are shaped.
+  utils::TokenHash h;
+  switch (type_) {
+    case kIntLiteral:
+      h.append(std::to_string(int_val_));
+      break;
+    case kFloatLiteral:
+      h.append(std::to_string(float_val_));
+      break;
+    case kIdentifier:
+    case kStringLiteral:
+      h.append(str_val_);
+      break;
+    default:
+      if (op_ != NULL) {
+        h.append(op_->prefix_hash_);
+        h.append_space();
+      }
+      if (left_ != NULL) {
+        h.append(left_->hash_);
+        h.append_space();
+      }
+      if (op_ != NULL) {
+        h.append(op_->middle_hash_);
+        h.append_space();
+      }
+      if (right_ != NULL) {
+        h.append(right_->hash_);
+        h.append_space();
+      }
+      if (op_ != NULL) h.append(op_->suffix_hash_);
+      break;
+  }
+  hash_ = h;
+  return h.digest();
+}
 
-  return res;
+unsigned long IR::structural_hash() {
+  if (left_ != NULL) left_->structural_hash();
+  if (right_ != NULL) right_->structural_hash();
+  return update_hash();
 }
 
 IR *Node::translate(vector<IR *> &v_ir_collector) { return NULL; }
@@ -123,7 +199,7 @@ void Program::deep_delete() {
 };
 
 void Program::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   stmtlist_ = new Stmtlist();
   stmtlist_->generate();
@@ -156,7 +232,7 @@ void Stmtlist::deep_delete() {
 };
 
 void Stmtlist::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -171,7 +247,7 @@ void Stmtlist::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       stmt_ = new Stmt();
@@ -234,7 +310,7 @@ void Stmt::deep_delete() {
 };
 
 void Stmt::generate() {
-  GENERATESTART(7)
+  GENERATESTART(7, 4)
 
   SWITCHSTART
   CASESTART(0)
@@ -299,7 +375,7 @@ void CreateStmt::deep_delete() {
 };
 
 void CreateStmt::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -348,7 +424,7 @@ void DropStmt::deep_delete() {
 };
 
 void DropStmt::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -385,7 +461,7 @@ void AlterStmt::deep_delete() {
 };
 
 void AlterStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   table_name_ = new TableName();
   table_name_->generate();
@@ -419,7 +495,7 @@ void SelectStmt::deep_delete() {
 };
 
 void SelectStmt::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -459,7 +535,7 @@ void SelectWithParens::deep_delete() {
 };
 
 void SelectWithParens::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -472,7 +548,7 @@ void SelectWithParens::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       select_no_parens_ = new SelectNoParens();
@@ -511,7 +587,7 @@ void SelectNoParens::deep_delete() {
 };
 
 void SelectNoParens::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_with_clause_ = new OptWithClause();
   opt_with_clause_->generate();
@@ -554,7 +630,7 @@ void SelectClauseList::deep_delete() {
 };
 
 void SelectClauseList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -571,7 +647,7 @@ void SelectClauseList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       select_clause_ = new SelectClause();
@@ -618,7 +694,7 @@ void SelectClause::deep_delete() {
 };
 
 void SelectClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_all_or_distinct_ = new OptAllOrDistinct();
   opt_all_or_distinct_->generate();
@@ -656,7 +732,7 @@ IR *CombineClause::translate(vector<IR *> &v_ir_collector) {
 
 void CombineClause::deep_delete() { delete this; };
 
-void CombineClause::generate(){GENERATESTART(3)
+void CombineClause::generate(){GENERATESTART(3, 0)
 
                                    SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                        CASEEND CASESTART(2) CASEEND SWITCHEND
@@ -685,7 +761,7 @@ void OptFromClause::deep_delete() {
 };
 
 void OptFromClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -715,7 +791,7 @@ void SelectTarget::deep_delete() {
 };
 
 void SelectTarget::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_list_ = new ExprList();
   expr_list_->generate();
@@ -745,7 +821,7 @@ void OptWindowClause::deep_delete() {
 };
 
 void OptWindowClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -775,7 +851,7 @@ void WindowClause::deep_delete() {
 };
 
 void WindowClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   window_def_list_ = new WindowDefList();
   window_def_list_->generate();
@@ -808,7 +884,7 @@ void WindowDefList::deep_delete() {
 };
 
 void WindowDefList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -823,7 +899,7 @@ void WindowDefList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       window_def_ = new WindowDef();
@@ -854,7 +930,7 @@ void WindowDef::deep_delete() {
 };
 
 void WindowDef::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   window_name_ = new WindowName();
   window_name_->generate();
@@ -879,7 +955,7 @@ void WindowName::deep_delete() {
 };
 
 void WindowName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -912,7 +988,7 @@ void Window::deep_delete() {
 };
 
 void Window::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_exist_window_name_ = new OptExistWindowName();
   opt_exist_window_name_->generate();
@@ -948,7 +1024,7 @@ void OptPartition::deep_delete() {
 };
 
 void OptPartition::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1003,7 +1079,7 @@ void OptFrameClause::deep_delete() {
 };
 
 void OptFrameClause::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -1052,7 +1128,7 @@ IR *RangeOrRows::translate(vector<IR *> &v_ir_collector) {
 
 void RangeOrRows::deep_delete() { delete this; };
 
-void RangeOrRows::generate(){GENERATESTART(3)
+void RangeOrRows::generate(){GENERATESTART(3, 0)
 
                                  SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                      CASEEND CASESTART(2) CASEEND SWITCHEND
@@ -1081,7 +1157,7 @@ void FrameBoundStart::deep_delete() {
 };
 
 void FrameBoundStart::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1117,7 +1193,7 @@ void FrameBoundEnd::deep_delete() {
 };
 
 void FrameBoundEnd::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1157,7 +1233,7 @@ void FrameBound::deep_delete() {
 };
 
 void FrameBound::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -1197,7 +1273,7 @@ void OptFrameExclude::deep_delete() {
 };
 
 void OptFrameExclude::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1235,7 +1311,7 @@ IR *FrameExclude::translate(vector<IR *> &v_ir_collector) {
 
 void FrameExclude::deep_delete() { delete this; };
 
-void FrameExclude::generate(){GENERATESTART(4)
+void FrameExclude::generate(){GENERATESTART(4, 0)
 
                                   SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                       CASEEND CASESTART(2) CASEEND CASESTART(3)
@@ -1265,7 +1341,7 @@ void OptExistWindowName::deep_delete() {
 };
 
 void OptExistWindowName::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1304,7 +1380,7 @@ void OptGroupClause::deep_delete() {
 };
 
 void OptGroupClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1343,7 +1419,7 @@ void OptHavingClause::deep_delete() {
 };
 
 void OptHavingClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1380,7 +1456,7 @@ void OptWhereClause::deep_delete() {
 };
 
 void OptWhereClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1410,7 +1486,7 @@ void WhereClause::deep_delete() {
 };
 
 void WhereClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_ = new Expr();
   expr_->generate();
@@ -1433,7 +1509,7 @@ void FromClause::deep_delete() {
 };
 
 void FromClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   table_ref_ = new TableRef();
   table_ref_->generate();
@@ -1484,7 +1560,7 @@ void TableRef::deep_delete() {
 };
 
 void TableRef::generate() {
-  GENERATESTART(300)
+  GENERATESTART(300, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -1513,7 +1589,7 @@ void TableRef::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 2;
+    int tmp_case_idx = get_rand_int(2);
     switch (tmp_case_idx) {
       CASESTART(0)
       opt_table_prefix_ = new OptTablePrefix();
@@ -1562,7 +1638,7 @@ void OptOnOrUsing::deep_delete() {
 };
 
 void OptOnOrUsing::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1601,7 +1677,7 @@ void OnOrUsing::deep_delete() {
 };
 
 void OnOrUsing::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -1642,7 +1718,7 @@ void ColumnNameList::deep_delete() {
 };
 
 void ColumnNameList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -1657,7 +1733,7 @@ void ColumnNameList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       column_name_ = new ColumnName();
@@ -1695,7 +1771,7 @@ void OptTablePrefix::deep_delete() {
 };
 
 void OptTablePrefix::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1737,7 +1813,7 @@ void JoinOp::deep_delete() {
 };
 
 void JoinOp::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -1779,7 +1855,7 @@ IR *OptJoinType::translate(vector<IR *> &v_ir_collector) {
 
 void OptJoinType::deep_delete() { delete this; };
 
-void OptJoinType::generate(){GENERATESTART(5)
+void OptJoinType::generate(){GENERATESTART(5, 0)
 
                                  SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                      CASEEND CASESTART(2) CASEEND CASESTART(3)
@@ -1814,7 +1890,7 @@ void ExprList::deep_delete() {
 };
 
 void ExprList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1829,7 +1905,7 @@ void ExprList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       expr_ = new Expr();
@@ -1865,7 +1941,7 @@ void OptLimitClause::deep_delete() {
 };
 
 void OptLimitClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1910,7 +1986,7 @@ void LimitClause::deep_delete() {
 };
 
 void LimitClause::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -1956,7 +2032,7 @@ void OptOrderClause::deep_delete() {
 };
 
 void OptOrderClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -1991,7 +2067,7 @@ IR *OptOrderNulls::translate(vector<IR *> &v_ir_collector) {
 
 void OptOrderNulls::deep_delete() { delete this; };
 
-void OptOrderNulls::generate(){GENERATESTART(3)
+void OptOrderNulls::generate(){GENERATESTART(3, 0)
 
                                    SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                        CASEEND CASESTART(2)
@@ -2025,7 +2101,7 @@ void OrderItemList::deep_delete() {
 };
 
 void OrderItemList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -2040,7 +2116,7 @@ void OrderItemList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       order_item_ = new OrderItem();
@@ -2075,7 +2151,7 @@ void OrderItem::deep_delete() {
 };
 
 void OrderItem::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_ = new Expr();
   expr_->generate();
@@ -2108,7 +2184,7 @@ IR *OptOrderBehavior::translate(vector<IR *> &v_ir_collector) {
 void OptOrderBehavior::deep_delete() { delete this; };
 
 void OptOrderBehavior::generate(){
-    GENERATESTART(3)
+    GENERATESTART(3, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
 
@@ -2142,7 +2218,7 @@ void OptWithClause::deep_delete() {
 };
 
 void OptWithClause::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -2186,7 +2262,7 @@ void CteTableList::deep_delete() {
 };
 
 void CteTableList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -2201,7 +2277,7 @@ void CteTableList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       cte_table_ = new CteTable();
@@ -2232,7 +2308,7 @@ void CteTable::deep_delete() {
 };
 
 void CteTable::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   cte_table_name_ = new CteTableName();
   cte_table_name_->generate();
@@ -2259,7 +2335,7 @@ void CteTableName::deep_delete() {
 };
 
 void CteTableName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   table_name_ = new TableName();
   table_name_->generate();
@@ -2290,7 +2366,7 @@ IR *OptAllOrDistinct::translate(vector<IR *> &v_ir_collector) {
 void OptAllOrDistinct::deep_delete() { delete this; };
 
 void OptAllOrDistinct::generate(){
-    GENERATESTART(3)
+    GENERATESTART(3, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
 
@@ -2343,7 +2419,7 @@ void CreateTableStmt::deep_delete() {
 };
 
 void CreateTableStmt::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -2406,7 +2482,7 @@ void CreateIndexStmt::deep_delete() {
 };
 
 void CreateIndexStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_unique_ = new OptUnique();
   opt_unique_->generate();
@@ -2501,7 +2577,7 @@ void CreateViewStmt::deep_delete() {
 };
 
 void CreateViewStmt::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -2574,7 +2650,7 @@ void DropIndexStmt::deep_delete() {
 };
 
 void DropIndexStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_if_exist_ = new OptIfExist();
   opt_if_exist_->generate();
@@ -2601,7 +2677,7 @@ void DropTableStmt::deep_delete() {
 };
 
 void DropTableStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_if_exist_ = new OptIfExist();
   opt_if_exist_->generate();
@@ -2628,7 +2704,7 @@ void DropViewStmt::deep_delete() {
 };
 
 void DropViewStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_if_exist_ = new OptIfExist();
   opt_if_exist_->generate();
@@ -2663,7 +2739,7 @@ void InsertStmt::deep_delete() {
 };
 
 void InsertStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_with_clause_ = new OptWithClause();
   opt_with_clause_->generate();
@@ -2708,7 +2784,7 @@ void InsertRest::deep_delete() {
 };
 
 void InsertRest::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -2757,7 +2833,7 @@ void SuperValuesList::deep_delete() {
 };
 
 void SuperValuesList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -2772,7 +2848,7 @@ void SuperValuesList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       values_list_ = new ValuesList();
@@ -2801,7 +2877,7 @@ void ValuesList::deep_delete() {
 };
 
 void ValuesList::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_list_ = new ExprList();
   expr_list_->generate();
@@ -2841,7 +2917,7 @@ void OptOnConflict::deep_delete() {
 };
 
 void OptOnConflict::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -2888,7 +2964,7 @@ void OptConflictExpr::deep_delete() {
 };
 
 void OptConflictExpr::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -2930,7 +3006,7 @@ void IndexedColumnList::deep_delete() {
 };
 
 void IndexedColumnList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -2945,7 +3021,7 @@ void IndexedColumnList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       indexed_column_ = new IndexedColumn();
@@ -2976,7 +3052,7 @@ void IndexedColumn::deep_delete() {
 };
 
 void IndexedColumn::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_ = new Expr();
   expr_->generate();
@@ -3011,7 +3087,7 @@ void UpdateStmt::deep_delete() {
 };
 
 void UpdateStmt::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_with_clause_ = new OptWithClause();
   opt_with_clause_->generate();
@@ -3048,7 +3124,7 @@ void ReindexStmt::deep_delete() {
 };
 
 void ReindexStmt::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3100,7 +3176,7 @@ void AlterAction::deep_delete() {
 };
 
 void AlterAction::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3151,7 +3227,7 @@ void ColumnDefList::deep_delete() {
 };
 
 void ColumnDefList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3166,7 +3242,7 @@ void ColumnDefList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       column_def_ = new ColumnDef();
@@ -3201,7 +3277,7 @@ void ColumnDef::deep_delete() {
 };
 
 void ColumnDef::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -3235,7 +3311,7 @@ void OptColumnConstraintList::deep_delete() {
 };
 
 void OptColumnConstraintList::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -3275,7 +3351,7 @@ void ColumnConstraintList::deep_delete() {
 };
 
 void ColumnConstraintList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3290,7 +3366,7 @@ void ColumnConstraintList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       column_constraint_ = new ColumnConstraint();
@@ -3319,7 +3395,7 @@ void ColumnConstraint::deep_delete() {
 };
 
 void ColumnConstraint::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   constraint_type_ = new ConstraintType();
   constraint_type_->generate();
@@ -3360,7 +3436,7 @@ void ConstraintType::deep_delete() {
 };
 
 void ConstraintType::generate() {
-  GENERATESTART(5)
+  GENERATESTART(5, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3407,7 +3483,7 @@ void ForeignClause::deep_delete() {
 };
 
 void ForeignClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   table_name_ = new TableName();
   table_name_->generate();
@@ -3443,7 +3519,7 @@ void OptForeignKeyActions::deep_delete() {
 };
 
 void OptForeignKeyActions::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -3490,7 +3566,7 @@ void ForeignKeyActions::deep_delete() {
 };
 
 void ForeignKeyActions::generate() {
-  GENERATESTART(5)
+  GENERATESTART(5, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3538,7 +3614,7 @@ IR *KeyActions::translate(vector<IR *> &v_ir_collector) {
 
 void KeyActions::deep_delete() { delete this; };
 
-void KeyActions::generate(){GENERATESTART(5)
+void KeyActions::generate(){GENERATESTART(5, 0)
 
                                 SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                     CASEEND CASESTART(2) CASEEND CASESTART(3)
@@ -3573,7 +3649,7 @@ void OptConstraintAttributeSpec::deep_delete() {
 };
 
 void OptConstraintAttributeSpec::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -3613,7 +3689,7 @@ IR *OptInitialTime::translate(vector<IR *> &v_ir_collector) {
 void OptInitialTime::deep_delete() { delete this; };
 
 void OptInitialTime::generate(){
-    GENERATESTART(3)
+    GENERATESTART(3, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
 
@@ -3636,7 +3712,7 @@ void ConstraintName::deep_delete() {
 };
 
 void ConstraintName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   name_ = new Name();
   name_->generate();
@@ -3680,7 +3756,7 @@ IR *OptTemp::translate(vector<IR *> &v_ir_collector) {
 void OptTemp::deep_delete() { delete this; };
 
 void OptTemp::generate(){
-    GENERATESTART(8)
+    GENERATESTART(8, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
             CASEEND CASESTART(3) CASEEND CASESTART(4) CASEEND CASESTART(5)
@@ -3714,7 +3790,7 @@ IR *OptCheckOption::translate(vector<IR *> &v_ir_collector) {
 void OptCheckOption::deep_delete() { delete this; };
 
 void OptCheckOption::generate(){
-    GENERATESTART(4)
+    GENERATESTART(4, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
             CASEEND CASESTART(3)
@@ -3745,7 +3821,7 @@ void OptColumnNameListP::deep_delete() {
 };
 
 void OptColumnNameListP::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -3785,7 +3861,7 @@ void SetClauseList::deep_delete() {
 };
 
 void SetClauseList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3800,7 +3876,7 @@ void SetClauseList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       set_clause_ = new SetClause();
@@ -3841,7 +3917,7 @@ void SetClause::deep_delete() {
 };
 
 void SetClause::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3905,7 +3981,7 @@ void Expr::deep_delete() {
 };
 
 void Expr::generate() {
-  GENERATESTART(6)
+  GENERATESTART(6, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -3991,7 +4067,7 @@ void Operand::deep_delete() {
 };
 
 void Operand::generate() {
-  GENERATESTART(8)
+  GENERATESTART(8, 3)
 
   SWITCHSTART
   CASESTART(0)
@@ -4048,7 +4124,7 @@ void CastExpr::deep_delete() {
 };
 
 void CastExpr::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_ = new Expr();
   expr_->generate();
@@ -4082,7 +4158,7 @@ void ScalarExpr::deep_delete() {
 };
 
 void ScalarExpr::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4139,7 +4215,7 @@ void UnaryExpr::deep_delete() {
 };
 
 void UnaryExpr::generate() {
-  GENERATESTART(7)
+  GENERATESTART(7, 5)
 
   SWITCHSTART
   CASESTART(0)
@@ -4211,7 +4287,7 @@ void BinaryExpr::deep_delete() {
 };
 
 void BinaryExpr::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -4269,7 +4345,7 @@ void LogicExpr::deep_delete() {
 };
 
 void LogicExpr::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4332,7 +4408,7 @@ void InExpr::deep_delete() {
 };
 
 void InExpr::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -4403,7 +4479,7 @@ void CaseExpr::deep_delete() {
 };
 
 void CaseExpr::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4468,7 +4544,7 @@ void BetweenExpr::deep_delete() {
 };
 
 void BetweenExpr::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4509,7 +4585,7 @@ void ExistsExpr::deep_delete() {
 };
 
 void ExistsExpr::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   opt_not_ = new OptNot();
   opt_not_->generate();
@@ -4544,7 +4620,7 @@ void CaseList::deep_delete() {
 };
 
 void CaseList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4559,7 +4635,7 @@ void CaseList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       case_clause_ = new CaseClause();
@@ -4590,7 +4666,7 @@ void CaseClause::deep_delete() {
 };
 
 void CaseClause::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   expr_1_ = new Expr();
   expr_1_->generate();
@@ -4646,7 +4722,7 @@ void CompExpr::deep_delete() {
 };
 
 void CompExpr::generate() {
-  GENERATESTART(6)
+  GENERATESTART(6, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4707,7 +4783,7 @@ void ExtractExpr::deep_delete() {
 };
 
 void ExtractExpr::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   datetime_field_ = new DatetimeField();
   datetime_field_->generate();
@@ -4747,7 +4823,7 @@ IR *DatetimeField::translate(vector<IR *> &v_ir_collector) {
 void DatetimeField::deep_delete() { delete this; };
 
 void DatetimeField::generate(){
-    GENERATESTART(6)
+    GENERATESTART(6, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
             CASEEND CASESTART(3) CASEEND CASESTART(4) CASEEND CASESTART(5)
@@ -4772,7 +4848,7 @@ void ArrayIndex::deep_delete() {
 };
 
 void ArrayIndex::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   operand_ = new Operand();
   operand_->generate();
@@ -4811,7 +4887,7 @@ void Literal::deep_delete() {
 };
 
 void Literal::generate() {
-  GENERATESTART(3)
+  GENERATESTART(3, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4842,7 +4918,7 @@ IR *StringLiteral::translate(vector<IR *> &v_ir_collector) {
 void StringLiteral::deep_delete() { delete this; };
 
 void StringLiteral::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   string_val_ = gen_string();
 
@@ -4866,7 +4942,7 @@ IR *BoolLiteral::translate(vector<IR *> &v_ir_collector) {
 
 void BoolLiteral::deep_delete() { delete this; };
 
-void BoolLiteral::generate(){GENERATESTART(2)
+void BoolLiteral::generate(){GENERATESTART(2, 0)
 
                                  SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                      CASEEND SWITCHEND
@@ -4897,7 +4973,7 @@ void NumLiteral::deep_delete() {
 };
 
 void NumLiteral::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -4924,7 +5000,7 @@ IR *IntLiteral::translate(vector<IR *> &v_ir_collector) {
 void IntLiteral::deep_delete() { delete this; };
 
 void IntLiteral::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   int_val_ = gen_int();
 
@@ -4942,7 +5018,7 @@ IR *FloatLiteral::translate(vector<IR *> &v_ir_collector) {
 void FloatLiteral::deep_delete() { delete this; };
 
 void FloatLiteral::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   float_val_ = gen_float();
 
@@ -4966,7 +5042,7 @@ IR *OptColumn::translate(vector<IR *> &v_ir_collector) {
 
 void OptColumn::deep_delete() { delete this; };
 
-void OptColumn::generate(){GENERATESTART(2)
+void OptColumn::generate(){GENERATESTART(2, 0)
 
                                SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -4991,7 +5067,7 @@ IR *OptIfNotExist::translate(vector<IR *> &v_ir_collector) {
 
 void OptIfNotExist::deep_delete() { delete this; };
 
-void OptIfNotExist::generate(){GENERATESTART(2)
+void OptIfNotExist::generate(){GENERATESTART(2, 0)
 
                                    SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -5016,7 +5092,7 @@ IR *OptIfExist::translate(vector<IR *> &v_ir_collector) {
 
 void OptIfExist::deep_delete() { delete this; };
 
-void OptIfExist::generate(){GENERATESTART(2)
+void OptIfExist::generate(){GENERATESTART(2, 0)
 
                                 SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -5035,7 +5111,7 @@ IR *Identifier::translate(vector<IR *> &v_ir_collector) {
 void Identifier::deep_delete() { delete this; };
 
 void Identifier::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   string_val_ = gen_string();
 
@@ -5057,7 +5133,7 @@ void TableName::deep_delete() {
 };
 
 void TableName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -5080,7 +5156,7 @@ void ColumnName::deep_delete() {
 };
 
 void ColumnName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -5105,7 +5181,7 @@ IR *OptUnique::translate(vector<IR *> &v_ir_collector) {
 
 void OptUnique::deep_delete() { delete this; };
 
-void OptUnique::generate(){GENERATESTART(2)
+void OptUnique::generate(){GENERATESTART(2, 0)
 
                                SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -5128,7 +5204,7 @@ void ViewName::deep_delete() {
 };
 
 void ViewName::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -5162,7 +5238,7 @@ IR *BinaryOp::translate(vector<IR *> &v_ir_collector) {
 
 void BinaryOp::deep_delete() { delete this; };
 
-void BinaryOp::generate(){GENERATESTART(5)
+void BinaryOp::generate(){GENERATESTART(5, 0)
 
                               SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
                                   CASEEND CASESTART(2) CASEEND CASESTART(3)
@@ -5187,7 +5263,7 @@ IR *OptNot::translate(vector<IR *> &v_ir_collector) {
 
 void OptNot::deep_delete() { delete this; };
 
-void OptNot::generate(){GENERATESTART(2)
+void OptNot::generate(){GENERATESTART(2, 0)
 
                             SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -5210,7 +5286,7 @@ void Name::deep_delete() {
 };
 
 void Name::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   identifier_ = new Identifier();
   identifier_->generate();
@@ -5242,7 +5318,7 @@ void TypeName::deep_delete() {
 };
 
 void TypeName::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -5282,7 +5358,7 @@ void CharacterType::deep_delete() {
 };
 
 void CharacterType::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -5315,7 +5391,7 @@ void CharacterWithLength::deep_delete() {
 };
 
 void CharacterWithLength::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   character_conflicta_ = new CharacterConflicta();
   character_conflicta_->generate();
@@ -5340,7 +5416,7 @@ void CharacterWithoutLength::deep_delete() {
 };
 
 void CharacterWithoutLength::generate() {
-  GENERATESTART(1)
+  GENERATESTART(1, 0)
 
   character_conflicta_ = new CharacterConflicta();
   character_conflicta_->generate();
@@ -5389,7 +5465,7 @@ void CharacterConflicta::deep_delete() {
 };
 
 void CharacterConflicta::generate() {
-  GENERATESTART(7)
+  GENERATESTART(7, 2)
 
   SWITCHSTART
   CASESTART(0)
@@ -5438,7 +5514,7 @@ IR *OptVarying::translate(vector<IR *> &v_ir_collector) {
 
 void OptVarying::deep_delete() { delete this; };
 
-void OptVarying::generate(){GENERATESTART(2)
+void OptVarying::generate(){GENERATESTART(2, 0)
 
                                 SWITCHSTART CASESTART(0) CASEEND CASESTART(1)
 
@@ -5491,7 +5567,7 @@ IR *NumericType::translate(vector<IR *> &v_ir_collector) {
 void NumericType::deep_delete() { delete this; };
 
 void NumericType::generate(){
-    GENERATESTART(11)
+    GENERATESTART(11, 0)
 
         SWITCHSTART CASESTART(0) CASEEND CASESTART(1) CASEEND CASESTART(2)
             CASEEND CASESTART(3) CASEEND CASESTART(4) CASEEND CASESTART(5)
@@ -5522,7 +5598,7 @@ void OptTableConstraintList::deep_delete() {
 };
 
 void OptTableConstraintList::generate() {
-  GENERATESTART(2)
+  GENERATESTART(2, 1)
 
   SWITCHSTART
   CASESTART(0)
@@ -5562,7 +5638,7 @@ void TableConstraintList::deep_delete() {
 };
 
 void TableConstraintList::generate() {
-  GENERATESTART(200)
+  GENERATESTART(200, 0)
 
   SWITCHSTART
   CASESTART(0)
@@ -5577,7 +5653,7 @@ void TableConstraintList::generate() {
   CASEEND
 
   default: {
-    int tmp_case_idx = rand() % 1;
+    int tmp_case_idx = get_rand_int(1);
     switch (tmp_case_idx) {
       CASESTART(0)
       table_constraint_ = new TableConstraint();
@@ -5633,7 +5709,7 @@ void TableConstraint::deep_delete() {
 };
 
 void TableConstraint::generate() {
-  GENERATESTART(4)
+  GENERATESTART(4, 2)
 
   SWITCHSTART
   CASESTART(0)
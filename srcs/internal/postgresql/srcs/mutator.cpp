@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cfloat>
+#include <chrono>
 #include <climits>
 #include <cstdio>
 #include <deque>
@@ -18,22 +19,46 @@ using namespace std;
 
 //#define GRAPHLOG
 
+thread_local IR *Mutator::record_ = NULL;
+thread_local utils::Arena Mutator::fetch_arena_;
+thread_local vector<IR *> Mutator::fetched_;
+thread_local vector<utils::LibraryPick> *Mutator::picks_ = NULL;
+thread_local const vector<utils::LibraryPick> *Mutator::replayed_picks_ =
+    NULL;
+thread_local unsigned Mutator::mutate_side_ = 0;
+thread_local map<DATATYPE, vector<string>> Mutator::data_library_;
+thread_local map<DATATYPE, map<string, map<DATATYPE, vector<string>>>>
+    Mutator::data_library_2d_;
+thread_local map<int, map<DATATYPE, vector<IR *>>> Mutator::scope_library_;
+
+// Debug builds check every structural hash against the SQL of the tree: two
+// trees may only share a structural hash if they serialize identically.
+static void verify_structural_hash(IR *root, unsigned long h) {
+#ifdef VERIFY_IR_HASH
+  static thread_local map<unsigned long, uint64_t> sql_hashes;
+  // trim_string turns the character after a ';' into a newline, so the
+  // number of spaces there still shows. Compare modulo whitespace instead.
+  string raw = root->to_string(), sql;
+  for (char c : raw) {
+    if (c == '\n') c = ' ';
+    if (c == ' ' && (sql.empty() || sql.back() == ' ')) continue;
+    sql += c;
+  }
+  uint64_t sql_hash = ducking_hash(sql.c_str(), sql.size());
+  auto iter = sql_hashes.emplace(h, sql_hash).first;
+  assert(iter->second == sql_hash && "structural hash collision");
+#endif
+}
+
 IR *Mutator::deep_copy_with_record(const IR *root, const IR *record) {
   IR *left = NULL, *right = NULL, *copy_res;
 
   if (root->left_) left = deep_copy_with_record(root->left_, record);
   if (root->right_) right = deep_copy_with_record(root->right_, record);
 
-  if (root->op_ != NULL)
-    copy_res =
-        new IR(root->type_,
-               OP3(root->op_->prefix_, root->op_->middle_, root->op_->suffix_),
-               left, right, root->float_val_, root->str_val_, root->name_,
-               root->mutated_times_, root->scope_, root->data_flag_);
-  else
-    copy_res = new IR(root->type_, NULL, left, right, root->float_val_,
-                      root->str_val_, root->name_, root->mutated_times_,
-                      root->scope_, root->data_flag_);
+  copy_res = new IR(root->type_, root->op_, left, right, root->float_val_,
+                    root->str_val_, root->node_id_, root->mutated_times_,
+                    root->scope_, root->data_flag_);
 
   copy_res->data_type_ = root->data_type_;
 
@@ -49,49 +74,160 @@ vector<IR *> Mutator::mutate_all(vector<IR *> &v_ir_collector) {
   IR *root = v_ir_collector[v_ir_collector.size() - 1];
 
   mutated_root_ = root;
-
-  for (auto ir : v_ir_collector) {
-    if (not_mutatable_types_.find(ir->type_) != not_mutatable_types_.end())
+  release_fetched();
+  release_generated();
+  sync_shared_library();
+  refresh_library_weights();
+  mutation_traces_.clear();
+  uint64_t round = rng_.next();
+
+  for (size_t n = 0; n < v_ir_collector.size(); n++) {
+    IR *ir = v_ir_collector[n];
+    if (not_mutatable_types_.count(ir->type_))
       continue;
 
-    vector<IR *> v_mutated_ir = mutate(ir);
+    // Each node draws from its own generator, see utils::MutationTrace.
+    utils::Rng node_rng(utils::MutationTrace::node_seed(round, n));
+    utils::RngScope rng_scope(&node_rng);
+    vector<utils::MutationTrace> traces;
+    vector<IR *> v_mutated_ir = make_variants(ir, &traces);
+    count_mutation(ir, v_mutated_ir);
 
-    for (auto i : v_mutated_ir) {
+    for (size_t k = 0; k < v_mutated_ir.size(); k++) {
       IR *new_ir_tree = deep_copy_with_record(root, ir);
-      replace(new_ir_tree, this->record_, i);
+      replace(new_ir_tree, this->record_, v_mutated_ir[k]);
 
       extract_struct(new_ir_tree);
-      string tmp = new_ir_tree->to_string();
-      unsigned tmp_hash = hash(tmp);
-      if (global_hash_.find(tmp_hash) != global_hash_.end()) {
+      unsigned long tmp_hash = hash(new_ir_tree);
+      if (mutant_filter_.insert(tmp_hash)) {
         deep_delete(new_ir_tree);
         continue;
       }
 
-      global_hash_.insert(tmp_hash);
       res.push_back(new_ir_tree);
+      traces[k].round = round;
+      traces[k].node = n;
+      mutation_traces_.push_back(std::move(traces[k]));
+    }
+  }
+
+  return res;
+}
+
+// Mutates every node of the tree on `pool`, in three passes: the variants of
+// all nodes first, which only read the tree, then their counts, then the
+// mutated copies of the tree. Variants that end up with the same structure
+// are dropped in the order of the serial version.
+vector<IR *> Mutator::mutate_all(vector<IR *> &v_ir_collector,
+                                 utils::ThreadPool &pool) {
+  // Generated trees are memoized, which the serial version does alone.
+  if (generate_options_.mode != utils::GenerateMode::kOff) {
+    return mutate_all(v_ir_collector);
+  }
+  IR *root = v_ir_collector[v_ir_collector.size() - 1];
+
+  mutated_root_ = root;
+  release_fetched();
+  sync_shared_library();
+  refresh_library_weights();
+  mutation_traces_.clear();
+  uint64_t round = rng_.next();
+
+  // The workers draw from the generators of the nodes, and seeding them
+  // must not draw from `rng_`, which would change the following rounds.
+  utils::Rng workers_rng(round);
+  utils::RngScope workers_scope(&workers_rng);
+
+  // The same draws as the serial version, so the same mutants.
+  vector<vector<IR *>> variants(v_ir_collector.size());
+  vector<vector<utils::MutationTrace>> traces(v_ir_collector.size());
+  pool.run(v_ir_collector.size(), [&](size_t i) {
+    IR *ir = v_ir_collector[i];
+    if (not_mutatable_types_.count(ir->type_)) return;
+    utils::Rng node_rng(utils::MutationTrace::node_seed(round, i));
+    utils::RngScope rng_scope(&node_rng);
+    variants[i] = make_variants(ir, &traces[i]);
+    // The variants are copies, so the shared entries they came from can go.
+    release_fetched();
+  });
+
+  struct Candidate {
+    IR *node;
+    IR *variant;
+    IR *tree;
+    unsigned long hash;
+    utils::MutationTrace *trace;
+  };
+  vector<Candidate> candidates;
+  for (size_t i = 0; i < v_ir_collector.size(); i++) {
+    count_mutation(v_ir_collector[i], variants[i]);
+    for (size_t k = 0; k < variants[i].size(); k++) {
+      traces[i][k].round = round;
+      traces[i][k].node = i;
+      candidates.push_back(
+          {v_ir_collector[i], variants[i][k], NULL, 0, &traces[i][k]});
+    }
+  }
+
+  pool.run(candidates.size(), [&](size_t i) {
+    auto &candidate = candidates[i];
+    IR *new_ir_tree = deep_copy_with_record(root, candidate.node);
+    replace(new_ir_tree, this->record_, candidate.variant);
+
+    extract_struct(new_ir_tree);
+    candidate.tree = new_ir_tree;
+    candidate.hash = hash(new_ir_tree);
+  });
+
+  vector<IR *> res;
+  for (auto &candidate : candidates) {
+    if (mutant_filter_.insert(candidate.hash)) {
+      deep_delete(candidate.tree);
+      continue;
     }
+    res.push_back(candidate.tree);
+    mutation_traces_.push_back(std::move(*candidate.trace));
   }
 
   return res;
 }
 
 void Mutator::add_ir_to_library(IR *cur) {
+  learn_productions(cur);
   extract_struct(cur);
-  cur = deep_copy(cur);
+  if (shared_library_ != nullptr) {
+    // The tree goes through the log, where every instance, this one
+    // included, picks it up. It stays private only if the log is full.
+    cur->structural_hash();
+    if (library_has_all(cur)) return;
+    if (shared_library_->publish(cur)) {
+      sync_shared_library();
+      return;
+    }
+  }
+  {
+    utils::ArenaScope library_scope(&library_arena_);
+    cur = deep_copy(cur);
+  }
   add_ir_to_library_no_deepcopy(cur);
   return;
 }
 
+bool Mutator::library_has_all(IR *root) {
+  if (root->left_ && !library_has_all(root->left_)) return false;
+  if (root->right_ && !library_has_all(root->right_)) return false;
+  return ir_library_hash_[root->type_].count(root->hash_.digest()) != 0;
+}
+
 void Mutator::add_ir_to_library_no_deepcopy(IR *cur) {
   if (cur->left_) add_ir_to_library_no_deepcopy(cur->left_);
   if (cur->right_) add_ir_to_library_no_deepcopy(cur->right_);
 
   auto type = cur->type_;
-  auto h = hash(cur);
-  if (find(ir_library_hash_[type].begin(), ir_library_hash_[type].end(), h) !=
-      ir_library_hash_[type].end())
-    return;
+  // The children were hashed just above, so only this node is left.
+  auto h = cur->update_hash();
+  verify_structural_hash(cur, h);
+  if (ir_library_hash_[type].count(h)) return;
 
   ir_library_hash_[type].insert(h);
   ir_library_[type].push_back(cur);
@@ -261,32 +397,105 @@ void Mutator::init(string f_testcase, string f_common_string, string file2d,
 }
 
 vector<IR *> Mutator::mutate(IR *input) {
+  refresh_library_weights();
+  vector<IR *> res = make_variants(input);
+  count_mutation(input, res);
+  return res;
+}
+
+vector<IR *> Mutator::make_variants(IR *input,
+                                    vector<utils::MutationTrace> *traces,
+                                    const utils::MutationTrace *replayed) {
   vector<IR *> res;
 
   if (!lucky_enough_to_be_mutated(input->mutated_times_)) {
     return res;
   }
-  auto tmp = strategy_delete(input);
-  if (tmp != NULL) {
-    res.push_back(tmp);
-  }
+  // Each strategy draws from a generator of its own, so that skipping one
+  // changes nothing for the others, and a variant is made again alone.
+  uint64_t strategy_seeds[3];
+  for (auto &seed : strategy_seeds) seed = utils::current_rng().next();
+  vector<utils::LibraryPick> picks;
+  picks_ = traces != NULL ? &picks : NULL;
+  auto take = [&](IR *(Mutator::*strategy_fn)(IR *),
+                  utils::MutationStrategy strategy) {
+    utils::Rng strategy_rng(strategy_seeds[size_t(strategy)]);
+    utils::RngScope rng_scope(&strategy_rng);
+    // The operator is drawn, and kept or not, before the variant is built.
+    // The draws are the same with or without a scheduler.
+    mutate_side_ =
+        strategy == utils::MutationStrategy::kInsert ? 0 : get_rand_int(3);
+    double keep_draw = strategy_rng.uniform();
+    if (replayed != NULL) {
+      if (replayed->strategy != strategy) return;
+    } else if (scheduler_ != nullptr &&
+               !scheduler_->keep(
+                   input->type_,
+                   utils::mutation_operator(strategy, mutate_side_),
+                   keep_draw)) {
+      return;
+    }
+    replayed_picks_ = replayed != NULL ? &replayed->library : NULL;
+    IR *variant = (this->*strategy_fn)(input);
+    if (variant != NULL) {
+      res.push_back(variant);
+      if (traces != NULL) {
+        traces->emplace_back();
+        traces->back().strategy = strategy;
+        traces->back().library = std::move(picks);
+        traces->back().node_type = input->type_;
+        traces->back().side = mutate_side_;
+      }
+    }
+    picks.clear();
+  };
+  take(&Mutator::strategy_delete, utils::MutationStrategy::kDelete);
+  take(&Mutator::strategy_insert, utils::MutationStrategy::kInsert);
+  take(&Mutator::strategy_replace, utils::MutationStrategy::kReplace);
+  picks_ = NULL;
+  replayed_picks_ = NULL;
 
-  tmp = strategy_insert(input);
-  if (tmp != NULL) {
-    res.push_back(tmp);
-  }
+  return res;
+}
+
+IR *Mutator::replay_mutation(vector<IR *> &v_ir_collector,
+                             const utils::MutationTrace &trace,
+                             vector<utils::LibraryPick> *library) {
+  if (trace.node >= v_ir_collector.size()) return NULL;
+  IR *root = v_ir_collector[v_ir_collector.size() - 1];
+  IR *ir = v_ir_collector[trace.node];
+  if (not_mutatable_types_.count(ir->type_)) return NULL;
 
-  tmp = strategy_replace(input);
-  if (tmp != NULL) {
-    res.push_back(tmp);
+  mutated_root_ = root;
+  release_fetched();
+  release_generated();
+  refresh_library_weights();
+  utils::Rng node_rng(trace.node_seed());
+  utils::RngScope rng_scope(&node_rng);
+  vector<utils::MutationTrace> traces;
+  vector<IR *> variants = make_variants(ir, &traces, &trace);
+  count_mutation(ir, variants);
+
+  IR *res = NULL;
+  for (size_t k = 0; k < variants.size(); k++) {
+    if (res != NULL || traces[k].strategy != trace.strategy) {
+      deep_delete(variants[k]);
+      continue;
+    }
+    *library = std::move(traces[k].library);
+    res = deep_copy_with_record(root, ir);
+    replace(res, this->record_, variants[k]);
+    extract_struct(res);
   }
+  return res;
+}
 
-  input->mutated_times_ += res.size();
-  for (auto i : res) {
+void Mutator::count_mutation(IR *input, vector<IR *> &variants) {
+  input->mutated_times_ += variants.size();
+  for (auto i : variants) {
     if (i == NULL) continue;
     i->mutated_times_ = input->mutated_times_;
   }
-  return res;
 }
 
 bool Mutator::replace(IR *root, IR *old_ir, IR *new_ir) {
@@ -387,10 +596,12 @@ IR *Mutator::strategy_replace(IR *cur) {
   if (cur->left_ != NULL) {
     res = deep_copy(cur);
 
+    // Library entries are shared, so only the copy takes the data type.
     auto new_node = get_ir_from_library(res->left_->type_);
-    new_node->data_type_ = res->left_->data_type_;
+    auto data_type = res->left_->data_type_;
     deep_delete(res->left_);
     res->left_ = deep_copy(new_node);
+    res->left_->data_type_ = data_type;
   }
 
   DORIGHT
@@ -398,9 +609,10 @@ IR *Mutator::strategy_replace(IR *cur) {
     res = deep_copy(cur);
 
     auto new_node = get_ir_from_library(res->right_->type_);
-    new_node->data_type_ = res->right_->data_type_;
+    auto data_type = res->right_->data_type_;
     deep_delete(res->right_);
     res->right_ = deep_copy(new_node);
+    res->right_->data_type_ = data_type;
   }
 
   DOBOTH
@@ -409,13 +621,15 @@ IR *Mutator::strategy_replace(IR *cur) {
 
     auto new_left = get_ir_from_library(res->left_->type_);
     auto new_right = get_ir_from_library(res->right_->type_);
-    new_left->data_type_ = res->left_->data_type_;
-    new_right->data_type_ = res->right_->data_type_;
+    auto left_data_type = res->left_->data_type_;
+    auto right_data_type = res->right_->data_type_;
     deep_delete(res->right_);
     res->right_ = deep_copy(new_right);
+    res->right_->data_type_ = right_data_type;
 
     deep_delete(res->left_);
     res->left_ = deep_copy(new_left);
+    res->left_->data_type_ = left_data_type;
   }
 
   MUTATEEND
@@ -447,30 +661,200 @@ pair<string, string> Mutator::get_data_2d_by_type(DATATYPE type1,
   return res;
 }
 
-IR *Mutator::generate_ir_by_type(IRTYPE type) {
+IR *Mutator::generate_ir_by_type(IRTYPE type, uint64_t seed) {
   auto ast_node = generate_ast_node_by_type(type);
-  ast_node->generate();
+  if (ast_node == NULL) return NULL;
+  auto start = chrono::steady_clock::now();
+  utils::GenerateBudget budget(generate_options_);
+  {
+    utils::Rng tree_rng(seed);
+    utils::RngScope rng_scope(&tree_rng);
+    utils::GenerateScope generate_scope(&budget);
+    ast_node->generate();
+  }
   vector<IR *> tmp_vector;
   ast_node->translate(tmp_vector);
+  ast_node->deep_delete();
   assert(tmp_vector.size());
+  IR *res = tmp_vector[tmp_vector.size() - 1];
+  generate_stats_.count(generate_stats_.trees);
+  generate_stats_.count(generate_stats_.rules, budget.rules());
+  generate_stats_.count(
+      generate_stats_.generate_ns,
+      chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() -
+                                                 start)
+          .count());
+  // A rule may stand for a type of its own, which the tree cannot replace.
+  if (res->type_ != type) {
+    deep_delete(res);
+    return NULL;
+  }
+  return res;
+}
+
+IR *Mutator::get_generated_ir(IRTYPE type, size_t library_size) {
+  // As many draws whatever the memo holds, so that a mutant is made again
+  // without it, see `replay_mutation`.
+  uint64_t seed = utils::current_rng().next();
+  bool reuse = get_rand_int(kGenerateRefresh) != 0;
+  size_t slot = get_rand_int(generate_options_.memo_size);
+  utils::LibraryPick pick{uint32_t(type), utils::LibraryPick::kGenerated,
+                          uint32_t(library_size), seed};
+  auto &memo = generated_[type];
+  if (memo.size() < generate_options_.memo_size) {
+    memo.resize(generate_options_.memo_size);
+  }
+
+  IR *ir = NULL;
+  if (replayed_picks_ != NULL) {
+    // The memo of the original run is gone: a memoized tree is generated
+    // again from its seed.
+    const utils::LibraryPick *recorded = replayed_pick();
+    if (recorded != NULL &&
+        recorded->index == utils::LibraryPick::kMemoized) {
+      pick = *recorded;
+    }
+  } else if (reuse && slot < memo.size() && memo[slot].tree != NULL) {
+    generate_stats_.count(generate_stats_.memo_hits);
+    pick.index = utils::LibraryPick::kMemoized;
+    pick.tree_seed = memo[slot].seed;
+    ir = memo[slot].tree;
+  }
+  if (ir == NULL) {
+    // Memoized trees outlive the round, and the ones replaced are deleted.
+    utils::ArenaScope heap_scope(nullptr);
+    ir = generate_ir_by_type(type, pick.tree_seed);
+    if (ir == NULL) return NULL;
+    if (replayed_picks_ != NULL || slot >= memo.size()) {
+      retired_.push_back(ir);
+    } else {
+      // The tree replaced may still be in use until the end of the round.
+      if (memo[slot].tree != NULL) retired_.push_back(memo[slot].tree);
+      memo[slot] = {pick.tree_seed, ir};
+    }
+  }
+  if (picks_ != NULL) picks_->push_back(pick);
+  return ir;
+}
+
+void Mutator::release_generated() {
+  for (auto ir : retired_) deep_delete(ir);
+  retired_.clear();
+}
 
-  return tmp_vector[tmp_vector.size() - 1];
+void Mutator::set_generate_options(const utils::GenerateOptions &options) {
+  generate_options_ = options;
+  generate_weights_.fill(1);
+  for (auto &[name, weight] : options.weights) {
+    auto type = get_nodetype_by_string(name);
+    if (type == kUnknown) {
+      cerr << "generate_weights: unknown rule " << name << endl;
+      continue;
+    }
+    generate_weights_[type] = weight;
+  }
+}
+
+string Mutator::describe_generation() const {
+  return generate_stats_.describe();
 }
 
 IR *Mutator::get_ir_from_library(IRTYPE type) {
-  const int generate_prop = 1;
-  const int threshold = 0;
-  static IR *empty_ir = new IR(kStringLiteral, "");
-#ifdef USEGENERATE
-  if (ir_library_[type].empty() == true ||
-      (get_rand_int(400) == 0 && type != kUnknown)) {
-    auto ir = generate_ir_by_type(type);
-    add_ir_to_library_no_deepcopy(ir);
-    return ir;
+  static IR *empty_ir = [] {
+    utils::ArenaScope heap_scope(nullptr);
+    return new IR(kStringLiteral, "");
+  }();
+  size_t own_size = ir_library_[type].size();
+  size_t size = own_size;
+  if (shared_library_ != nullptr) size += shared_library_->size(type);
+  if (generate_options_.mode != utils::GenerateMode::kOff && type != kUnknown) {
+    bool generate = size == 0;
+    if (!generate && generate_options_.mode == utils::GenerateMode::kMixed) {
+      generate = utils::current_rng().uniform() <
+                 generate_options_.probability * generate_weights_[type];
+    }
+    if (generate) {
+      if (IR *ir = get_generated_ir(type, size)) {
+        if (size == 0) generate_stats_.count(generate_stats_.empty_filled);
+        return ir;
+      }
+    }
   }
-#endif
-  if (ir_library_[type].empty()) return empty_ir;
-  return vector_rand_ele(ir_library_[type]);
+  if (size == 0) return empty_ir;
+  size_t i;
+  if (library_weights_ == nullptr) {
+    i = get_rand_int(size);
+  } else {
+    i = library_weights_->sample(type, size, utils::current_rng().uniform());
+  }
+  // The library may have grown since the original run, and its scores are
+  // gone, but the index it took is recorded. Whether the entry is still
+  // there is checked by its hash, see `replay_mutation`.
+  const utils::LibraryPick *recorded = replayed_pick();
+  if (recorded != NULL && recorded->type == type && recorded->index < size) {
+    i = recorded->index;
+  }
+  if (picks_ != NULL) {
+    uint64_t hash = i < own_size
+                        ? ir_library_[type][i]->hash_.digest()
+                        : shared_library_->hash(type, i - own_size);
+    picks_->push_back(
+        {uint32_t(type), uint32_t(i), uint32_t(size), 0, hash});
+  }
+  if (i < own_size) return ir_library_[type][i];
+  // Callers copy what they take from the library, so the entry only has to
+  // live until the next round.
+  utils::ArenaScope fetch_scope(&fetch_arena_);
+  IR *ir = shared_library_->materialize(type, i - own_size);
+  fetched_.push_back(ir);
+  return ir;
+}
+
+const utils::LibraryPick *Mutator::replayed_pick() const {
+  if (replayed_picks_ == NULL) return NULL;
+  size_t position = picks_ != NULL ? picks_->size() : 0;
+  if (position >= replayed_picks_->size()) return NULL;
+  return &(*replayed_picks_)[position];
+}
+
+void Mutator::set_library_weights(const utils::LibraryWeightOptions &options) {
+  library_weights_ =
+      std::make_unique<utils::LibraryWeights>(kNodeTypeCount, options);
+}
+
+void Mutator::refresh_library_weights() {
+  if (library_weights_ == nullptr) return;
+  library_weights_->refresh([this](uint32_t type) {
+    size_t size = ir_library_[type].size();
+    if (shared_library_ != nullptr) {
+      size += shared_library_->size(static_cast<IRTYPE>(type));
+    }
+    return size;
+  });
+}
+
+void Mutator::library_ran(const vector<utils::LibraryPick> &picks) {
+  if (library_weights_ == nullptr) return;
+  for (auto &pick : picks) {
+    if (pick.index < pick.size) library_weights_->ran(pick.type, pick.index);
+  }
+}
+
+void Mutator::library_found(const vector<utils::LibraryPick> &picks) {
+  if (library_weights_ == nullptr) return;
+  for (auto &pick : picks) {
+    if (pick.index < pick.size) library_weights_->found(pick.type, pick.index);
+  }
+}
+
+string Mutator::describe_library_weights() const {
+  return library_weights_ != nullptr ? library_weights_->describe() : "";
+}
+
+void Mutator::release_fetched() {
+  for (auto ir : fetched_) deep_delete(ir);
+  fetched_.clear();
+  fetch_arena_.reset();
 }
 
 string Mutator::get_a_string() {
@@ -498,8 +882,9 @@ unsigned long Mutator::hash(string &sql) {
 }
 
 unsigned long Mutator::hash(IR *root) {
-  auto tmp_str = move(root->to_string());
-  return this->hash(tmp_str);
+  auto h = root->structural_hash();
+  verify_structural_hash(root, h);
+  return h;
 }
 
 void Mutator::debug(IR *root) {
@@ -508,7 +893,15 @@ void Mutator::debug(IR *root) {
   }
 }
 
-Mutator::~Mutator() {}
+Mutator::~Mutator() {
+  release_fetched();
+  release_generated();
+  for (auto &memo : generated_) {
+    for (auto &entry : memo) {
+      if (entry.tree != NULL) deep_delete(entry.tree);
+    }
+  }
+}
 
 void Mutator::extract_struct(IR *root) {
   static int counter = 0;
@@ -527,11 +920,11 @@ void Mutator::extract_struct(IR *root) {
     return;
   }
 
-  if (string_types_.find(type) != string_types_.end()) {
+  if (string_types_.count(type)) {
     root->str_val_ = "'x'";
-  } else if (int_types_.find(type) != int_types_.end()) {
+  } else if (int_types_.count(type)) {
     root->int_val_ = 1;
-  } else if (float_types_.find(type) != float_types_.end()) {
+  } else if (float_types_.count(type)) {
     root->float_val_ = 1.0;
   }
 }
@@ -553,11 +946,11 @@ void Mutator::extract_struct2(IR *root) {
     return;
   }
 
-  if (string_types_.find(type) != string_types_.end()) {
+  if (string_types_.count(type)) {
     root->str_val_ = "'x'";
-  } else if (int_types_.find(type) != int_types_.end()) {
+  } else if (int_types_.count(type)) {
     root->int_val_ = 1;
-  } else if (float_types_.find(type) != float_types_.end()) {
+  } else if (float_types_.count(type)) {
     root->float_val_ = 1.0;
   }
 }
@@ -587,29 +980,119 @@ string Mutator::parse_data(string &input) {
   return res;
 }
 
-bool Mutator::validate(IR *&root) {
-  reset_data_library();
-  string sql = root->to_string();
-  auto ast = parser(sql);
-  if (ast == NULL) return false;
+// The type and operator of `node`, or 0 if there is none.
+static uint64_t node_label(const IR *node) {
+  if (node == NULL) return 0;
+  const IROperator *op = node->op_ != NULL ? node->op_ : OP0();
+  return utils::ProductionSet::key(node->type_, op->id_);
+}
 
-  deep_delete(root);
-  root = NULL;
+// Whether `a` and `b` have the same shape and attributes, literals aside.
+static bool same_tree(const IR *a, const IR *b) {
+  if (a == NULL || b == NULL) return a == b;
+  if (node_label(a) != node_label(b) || a->data_type_ != b->data_type_) {
+    return false;
+  }
+  if (a->data_type_ != kDataWhatever &&
+      (a->data_flag_ != b->data_flag_ || a->scope_ != b->scope_)) {
+    return false;
+  }
+  return same_tree(a->left_, b->left_) && same_tree(a->right_, b->right_);
+}
 
-  vector<IR *> ir_vector;
-  ast->translate(ir_vector);
-  ast->deep_delete();
+bool Mutator::validate(IR *&root, utils::MutationTrace *trace) {
+  reset_data_library();
+  bool checked =
+      validate_mode_ != utils::ValidateMode::kReparse && well_formed(root);
+  bool skip_parser = validate_mode_ == utils::ValidateMode::kGrammar && checked;
+  if (trace != NULL) {
+    // A replay takes the path of the run, whatever productions it knows.
+    if (trace->check != utils::CheckPath::kUnknown) {
+      skip_parser = trace->check == utils::CheckPath::kGrammar;
+    }
+    trace->check =
+        skip_parser ? utils::CheckPath::kGrammar : utils::CheckPath::kReparse;
+  }
+  if (skip_parser) {
+    validate_stats_.count(validate_stats_.accepted);
+  } else {
+    if (validate_mode_ == utils::ValidateMode::kGrammar) {
+      validate_stats_.count(validate_stats_.fallbacks);
+    }
+    string sql = root->to_string();
+    auto ast = parser(sql);
+    bool compare = validate_mode_ == utils::ValidateMode::kCompare;
+    if (compare) {
+      validate_stats_.count(validate_stats_.compared);
+      if (checked && ast == NULL) {
+        validate_stats_.count(validate_stats_.false_accepts);
+      } else if (!checked && ast != NULL) {
+        validate_stats_.count(validate_stats_.false_rejects);
+      }
+    }
+    if (ast == NULL) return false;
 
-  root = ir_vector[ir_vector.size() - 1];
+    vector<IR *> ir_vector;
+    ast->translate(ir_vector);
+    ast->deep_delete();
+
+    IR *reparsed = ir_vector[ir_vector.size() - 1];
+    if (compare && checked && !same_tree(root, reparsed)) {
+      validate_stats_.count(validate_stats_.tree_mismatches);
+    }
+    deep_delete(root);
+    root = reparsed;
+  }
   reset_id_counter();
 
   if (fix(root) == false) {
     return false;
   }
 
+  if (trace != NULL && trace->generated()) {
+    generate_stats_.count(generate_stats_.valid_mutants);
+  }
   return true;
 }
 
+// Every child is described with its own children, since many productions
+// share the generic kUnknown type, and with the attributes `fix` relies
+// on, which only matter for nodes with a data type.
+uint64_t Mutator::production_key(const IR *node) {
+  uint64_t key = node_label(node);
+  for (const IR *child : {node->left_, node->right_}) {
+    uint64_t attributes = 0;
+    if (child != NULL) {
+      attributes = utils::hash_combine(node_label(child), child->data_type_);
+      if (child->data_type_ != kDataWhatever) {
+        attributes = utils::hash_combine(
+            attributes, utils::hash_combine(child->data_flag_, child->scope_));
+      }
+      attributes = utils::hash_combine(
+          attributes, utils::hash_combine(node_label(child->left_),
+                                          node_label(child->right_)));
+    }
+    key = utils::ProductionSet::add_child(key, child != NULL, attributes);
+  }
+  return key;
+}
+
+void Mutator::learn_productions(IR *root) {
+  if (root->left_) learn_productions(root->left_);
+  if (root->right_) learn_productions(root->right_);
+  productions_.insert(production_key(root));
+}
+
+bool Mutator::well_formed(IR *root) const {
+  if (!productions_.contains(production_key(root))) return false;
+  if (root->left_ && !well_formed(root->left_)) return false;
+  return root->right_ == NULL || well_formed(root->right_);
+}
+
+string Mutator::describe_validation() const {
+  return validate_stats_.describe(productions_.size());
+}
+
 unsigned int Mutator::calc_node(IR *root) {
   unsigned int res = 0;
   if (root->left_) res += calc_node(root->left_);
@@ -664,7 +1147,7 @@ bool Mutator::fix(IR *root) {
 }
 
 vector<IR *> Mutator::split_to_stmt(IR *root, map<IR **, IR *> &m_save,
-                                    set<IRTYPE> &split_set) {
+                                    const IRTypeSet &split_set) {
   vector<IR *> res;
   deque<IR *> bfs = {root};
 
@@ -675,21 +1158,19 @@ vector<IR *> Mutator::split_to_stmt(IR *root, map<IR **, IR *> &m_save,
     if (node && node->left_) bfs.push_back(node->left_);
     if (node && node->right_) bfs.push_back(node->right_);
 
-    if (node->left_ && find(split_set.begin(), split_set.end(),
-                            node->left_->type_) != split_set.end()) {
+    if (node->left_ && split_set.count(node->left_->type_)) {
       res.push_back(node->left_);
       m_save[&node->left_] = node->left_;
       node->left_ = NULL;
     }
-    if (node->right_ && find(split_set.begin(), split_set.end(),
-                             node->right_->type_) != split_set.end()) {
+    if (node->right_ && split_set.count(node->right_->type_)) {
       res.push_back(node->right_);
       m_save[&node->right_] = node->right_;
       node->right_ = NULL;
     }
   }
 
-  if (find(split_set.begin(), split_set.end(), root->type_) != split_set.end())
+  if (split_set.count(root->type_))
     res.push_back(root);
 
   return res;
@@ -702,13 +1183,14 @@ bool Mutator::connect_back(map<IR **, IR *> &m_save) {
   return true;
 }
 
-static set<IR *> visited;
+static thread_local set<IR *> visited;
 
 bool Mutator::fix_one(IR *stmt_root,
                       map<int, map<DATATYPE, vector<IR *>>> &scope_library) {
   visited.clear();
   analyze_scope(stmt_root);
-  auto graph = build_graph(stmt_root, scope_library);
+  vector<IR *> order;
+  auto graph = build_graph(stmt_root, scope_library, order);
 
 #ifdef GRAPHLOG
   for (auto &iter : graph) {
@@ -720,7 +1202,7 @@ bool Mutator::fix_one(IR *stmt_root,
   }
   cout << "OUTPUT END" << endl;
 #endif
-  return fill_stmt_graph(graph);
+  return fill_stmt_graph(graph, order);
 }
 
 void Mutator::analyze_scope(IR *stmt_root) {
@@ -738,8 +1220,17 @@ void Mutator::analyze_scope(IR *stmt_root) {
 }
 
 map<IR *, vector<IR *>> Mutator::build_graph(
-    IR *stmt_root, map<int, map<DATATYPE, vector<IR *>>> &scope_library) {
+    IR *stmt_root, map<int, map<DATATYPE, vector<IR *>>> &scope_library,
+    vector<IR *> &order) {
   map<IR *, vector<IR *>> res;
+  auto edges = [&](IR *node) -> vector<IR *> & {
+    auto iter = res.find(node);
+    if (iter == res.end()) {
+      order.push_back(node);
+      iter = res.emplace(node, vector<IR *>()).first;
+    }
+    return iter->second;
+  };
   deque<IR *> bfs = {stmt_root};
 
   while (!bfs.empty()) {
@@ -750,14 +1241,12 @@ map<IR *, vector<IR *>> Mutator::build_graph(
     auto cur_data_flag = node->data_flag_;
     auto cur_data_type = node->data_type_;
 
-    if (find(int_types_.begin(), int_types_.end(), node->type_) !=
-        int_types_.end()) {
+    if (int_types_.count(node->type_)) {
       if (get_rand_int(100) > 50)
         node->int_val_ = vector_rand_ele(value_library_);
       else
         node->int_val_ = get_rand_int(100);
-    } else if (find(float_types_.begin(), float_types_.end(), node->type_) !=
-               float_types_.end()) {
+    } else if (float_types_.count(node->type_)) {
       node->float_val_ = (double)(get_rand_int(100000000));
     }
 
@@ -765,7 +1254,7 @@ map<IR *, vector<IR *>> Mutator::build_graph(
     if (node->right_) bfs.push_back(node->right_);
     if (cur_data_type == kDataWhatever) continue;
 
-    res[node];
+    edges(node);
     cur_scope--;
 
     if (relationmap_.find(cur_data_type) != relationmap_.end()) {
@@ -788,7 +1277,7 @@ map<IR *, vector<IR *>> Mutator::build_graph(
                   vector_rand_ele(scope_library[cur_scope][target.first]);
           }
         }
-        if (pick_node != NULL) res[pick_node].push_back(node);
+        if (pick_node != NULL) edges(pick_node).push_back(node);
       }
     }
   }
@@ -796,7 +1285,8 @@ map<IR *, vector<IR *>> Mutator::build_graph(
   return res;
 }
 
-bool Mutator::fill_stmt_graph(map<IR *, vector<IR *>> &graph) {
+bool Mutator::fill_stmt_graph(map<IR *, vector<IR *>> &graph,
+                              const vector<IR *> &order) {
   bool res = true;
   map<IR *, bool> zero_indegrees;
   for (auto &iter : graph) {
@@ -807,14 +1297,12 @@ bool Mutator::fill_stmt_graph(map<IR *, vector<IR *>> &graph) {
       zero_indegrees[ir] = false;
     }
   }
-  for (auto &iter : graph) {
-    auto type1 = iter.first->data_type_;
-    auto beg = iter.first;
+  for (auto beg : order) {
     if (zero_indegrees[beg] == false || visited.find(beg) != visited.end()) {
       continue;
     }
-    res &= fill_one(iter.first);
-    res &= fill_stmt_graph_one(graph, iter.first);
+    res &= fill_one(beg);
+    res &= fill_stmt_graph_one(graph, beg);
   }
 
   return res;
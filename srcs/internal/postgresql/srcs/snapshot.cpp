@@ -0,0 +1,384 @@
+#include "../include/ast.h"
+#include "../include/mutator.h"
+#include "../include/shared_library.h"
+#include "absl/container/flat_hash_map.h"
+#include "utils/snapshot.h"
+
+// The IR library is stored as one table of nodes in which every child comes
+// before its parent, followed by the per-type lists as indices into that
+// table. Nodes shared between several lists are stored once. The records
+// have a fixed size, so that a mapped table can be used in place.
+
+namespace {
+constexpr char kDialect[] = "postgresql";
+constexpr uint32_t kNoIndex = ~0u;
+
+class NodeTable {
+ public:
+  void add(IR *ir) {
+    if (ir == NULL || index_.count(ir)) return;
+    add(ir->left_);
+    add(ir->right_);
+    if (ir->op_ != NULL && !op_index_.count(ir->op_)) {
+      op_index_[ir->op_] = ops_.size();
+      ops_.push_back(ir->op_);
+    }
+    index_[ir] = nodes_.size();
+    nodes_.push_back(ir);
+  }
+
+  uint32_t index(const IR *ir) const {
+    return ir == NULL ? kNoIndex : index_.at(ir);
+  }
+
+  vector<uint32_t> indices(const vector<IR *> &irs) const {
+    vector<uint32_t> res;
+    res.reserve(irs.size());
+    for (auto ir : irs) res.push_back(index(ir));
+    return res;
+  }
+
+  void write(utils::SnapshotWriter &writer) const {
+    vector<string> op_strings;
+    for (auto op : ops_) {
+      op_strings.push_back(op->prefix_);
+      op_strings.push_back(op->middle_);
+      op_strings.push_back(op->suffix_);
+    }
+    writer.put(op_strings);
+
+    vector<NodeRecord> records;
+    string strings;
+    records.reserve(nodes_.size());
+    for (auto ir : nodes_) {
+      NodeRecord r = {};
+      r.type = ir->type_;
+      r.op = ir->op_ == NULL ? kNoIndex : op_index_.at(ir->op_);
+      r.left = index(ir->left_);
+      r.right = index(ir->right_);
+      r.long_val = ir->long_val_;
+      r.node_id = ir->node_id_;
+      // Children come first, so their hashes are already up to date.
+      r.hash = ir->update_hash();
+      r.str_offset = strings.size();
+      r.str_size = ir->str_val_.size();
+      r.scope = ir->scope_;
+      r.data_flag = ir->data_flag_;
+      r.data_type = ir->data_type_;
+      r.mutated_times = ir->mutated_times_;
+      strings += ir->str_val_;
+      records.push_back(r);
+    }
+    writer.put_records(records);
+    writer.put(strings);
+  }
+
+ private:
+  absl::flat_hash_map<const IR *, uint32_t> index_;
+  vector<IR *> nodes_;
+  absl::flat_hash_map<const IROperator *, uint32_t> op_index_;
+  vector<const IROperator *> ops_;
+};
+
+// Reads a table written by NodeTable::write and checks that every index in
+// it is in range. Children must come before their parent, which also rules
+// out cycles.
+bool read_table(utils::SnapshotReader &reader,
+                utils::RecordView<NodeRecord> &nodes, string_view &strings,
+                vector<const IROperator *> &ops) {
+  vector<string> op_strings;
+  if (!reader.get(op_strings) || op_strings.size() % 3 != 0 ||
+      !reader.get(nodes) || !reader.get(strings)) {
+    return false;
+  }
+  ops.clear();
+  for (size_t i = 0; i < op_strings.size(); i += 3) {
+    ops.push_back(IROperator::get(op_strings[i], op_strings[i + 1],
+                                  op_strings[i + 2]));
+  }
+  for (uint32_t i = 0; i < nodes.size(); ++i) {
+    NodeRecord r = nodes[i];
+    if (r.type >= kNodeTypeCount || (r.op != kNoIndex && r.op >= ops.size()) ||
+        (r.left != kNoIndex && r.left >= i) ||
+        (r.right != kNoIndex && r.right >= i) ||
+        r.str_offset > strings.size() ||
+        r.str_size > strings.size() - r.str_offset) {
+      return false;
+    }
+  }
+  return true;
+}
+
+IR *make_node(const NodeRecord &r, const vector<const IROperator *> &ops,
+              string_view strings, IR *left, IR *right) {
+  IR *ir = new IR(static_cast<IRTYPE>(r.type),
+                  r.op == kNoIndex ? NULL : ops[r.op], left, right, 0.0,
+                  string(strings.substr(r.str_offset, r.str_size)), r.node_id,
+                  r.mutated_times, r.scope, static_cast<DATAFLAG>(r.data_flag));
+  ir->long_val_ = r.long_val;
+  ir->data_type_ = static_cast<DATATYPE>(r.data_type);
+  return ir;
+}
+
+// Rebuilds every node of a table into the current arena.
+bool read_nodes(utils::SnapshotReader &reader, vector<IR *> &nodes) {
+  utils::RecordView<NodeRecord> records;
+  string_view strings;
+  vector<const IROperator *> ops;
+  if (!read_table(reader, records, strings, ops)) return false;
+  nodes.clear();
+  nodes.reserve(records.size());
+  for (uint32_t i = 0; i < records.size(); ++i) {
+    NodeRecord r = records[i];
+    nodes.push_back(make_node(r, ops, strings,
+                              r.left == kNoIndex ? NULL : nodes[r.left],
+                              r.right == kNoIndex ? NULL : nodes[r.right]));
+  }
+  return true;
+}
+
+bool valid_indices(const vector<uint32_t> &indices, size_t node_count) {
+  for (auto i : indices) {
+    if (i >= node_count) return false;
+  }
+  return true;
+}
+
+bool valid_indices(const utils::RecordView<uint32_t> &indices,
+                   size_t node_count) {
+  for (size_t i = 0; i < indices.size(); ++i) {
+    if (indices[i] >= node_count) return false;
+  }
+  return true;
+}
+};  // namespace
+
+bool Mutator::save_snapshot(const string &path) {
+  // Entries of the shared library are written out as well, so that the
+  // snapshot holds everything this instance can pick from.
+  utils::Arena shared_arena;
+  array<vector<IR *>, kNodeTypeCount> shared_lists;
+  vector<IR *> shared_nodes;
+  if (shared_library_ != nullptr) {
+    utils::ArenaScope shared_scope(&shared_arena);
+    shared_library_->materialize_all(shared_lists, shared_nodes);
+  }
+
+  NodeTable table;
+  for (size_t type = 0; type < kNodeTypeCount; ++type) {
+    for (auto ir : ir_library_[type]) table.add(ir);
+    for (auto ir : shared_lists[type]) table.add(ir);
+  }
+
+  utils::SnapshotWriter writer;
+  table.write(writer);
+  for (size_t type = 0; type < kNodeTypeCount; ++type) {
+    auto indices = table.indices(ir_library_[type]);
+    auto shared_indices = table.indices(shared_lists[type]);
+    indices.insert(indices.end(), shared_indices.begin(),
+                   shared_indices.end());
+    writer.put(indices);
+  }
+
+  vector<uint32_t> safe_generate_types;
+  for (uint32_t type = 0; type < kNodeTypeCount; ++type) {
+    if (safe_generate_type_.count(static_cast<IRTYPE>(type)))
+      safe_generate_types.push_back(type);
+  }
+  writer.put(safe_generate_types);
+  writer.put(string_library_);
+  writer.put(value_library_);
+  writer.put(common_string_library_);
+  writer.put(g_data_library_);
+  writer.put(g_data_library_2d_);
+
+  bool ok = writer.write_file(path, kDialect, kNodeTypeCount);
+  for (auto ir : shared_nodes) delete ir;
+  return ok;
+}
+
+// Reads the part of a snapshot that follows the IR library.
+bool Mutator::load_snapshot_tail(utils::SnapshotReader &reader) {
+  vector<uint32_t> safe_generate_types;
+  vector<string> string_library, common_string_library;
+  vector<unsigned long> value_library;
+  map<DATATYPE, vector<string>> g_data_library;
+  map<DATATYPE, map<string, map<DATATYPE, vector<string>>>> g_data_library_2d;
+  reader.get(safe_generate_types);
+  reader.get(string_library);
+  reader.get(value_library);
+  reader.get(common_string_library);
+  reader.get(g_data_library);
+  reader.get(g_data_library_2d);
+  if (!reader.done()) return false;
+
+  for (auto type : safe_generate_types) {
+    if (type < kNodeTypeCount) safe_generate_type_.insert(IRTYPE(type));
+  }
+  string_library_ = std::move(string_library);
+  value_library_ = std::move(value_library);
+  common_string_library_ = std::move(common_string_library);
+  g_data_library_ = std::move(g_data_library);
+  g_data_library_2d_ = std::move(g_data_library_2d);
+  return true;
+}
+
+bool Mutator::load_snapshot(const string &path) {
+  utils::SnapshotReader reader;
+  if (!reader.open(path, kDialect, kNodeTypeCount)) return false;
+
+  vector<IR *> nodes;
+  {
+    utils::ArenaScope library_scope(&library_arena_);
+    if (!read_nodes(reader, nodes)) return false;
+  }
+
+  array<vector<uint32_t>, kNodeTypeCount> library_indices;
+  for (auto &indices : library_indices) {
+    if (!reader.get(indices) || !valid_indices(indices, nodes.size()))
+      return false;
+  }
+  if (!load_snapshot_tail(reader)) return false;
+
+  // Children come first, so every node is hashed after its subtrees.
+  vector<unsigned long> digests;
+  digests.reserve(nodes.size());
+  for (auto ir : nodes) digests.push_back(ir->update_hash());
+  for (auto ir : nodes) productions_.insert(production_key(ir));
+
+  for (size_t type = 0; type < kNodeTypeCount; ++type) {
+    ir_library_[type].clear();
+    ir_library_hash_[type].clear();
+    for (auto i : library_indices[type]) {
+      ir_library_[type].push_back(nodes[i]);
+      ir_library_hash_[type].insert(digests[i]);
+    }
+  }
+  return true;
+}
+
+bool Mutator::attach_shared_library(const string &snapshot_path,
+                                    const string &log_path,
+                                    size_t log_capacity) {
+  auto shared = std::make_unique<SharedLibrary>();
+  if (!shared->attach(snapshot_path, log_path, log_capacity) ||
+      !load_snapshot_tail(shared->snapshot())) {
+    return false;
+  }
+  shared->for_each_base_hash([this](IRTYPE type, uint64_t h) {
+    ir_library_hash_[type].insert(h);
+  });
+  shared_library_ = std::move(shared);
+  sync_shared_library();
+  return true;
+}
+
+size_t Mutator::sync_shared_library() {
+  if (shared_library_ == nullptr) return 0;
+  return shared_library_->sync([this](IRTYPE type, uint64_t h) {
+    return ir_library_hash_[type].insert(h).second;
+  });
+}
+
+bool SharedLibrary::attach(const string &snapshot_path, const string &log_path,
+                           size_t log_capacity) {
+  snapshot_ = std::make_unique<utils::SnapshotReader>();
+  auto &reader = *snapshot_;
+  if (!reader.open(snapshot_path, kDialect, kNodeTypeCount)) return false;
+  Segment base;
+  if (!read_table(reader, base.nodes, base.strings, base.ops)) return false;
+  for (auto &indices : base_) {
+    if (!reader.get(indices) || !valid_indices(indices, base.nodes.size()))
+      return false;
+  }
+  segments_.push_back(std::move(base));
+  return log_.open(log_path, kDialect, kNodeTypeCount, log_capacity);
+}
+
+IR *SharedLibrary::build(const Segment &segment, uint32_t node,
+                         vector<IR *> *cache, vector<IR *> *built) const {
+  if (cache != nullptr && (*cache)[node] != NULL) return (*cache)[node];
+  NodeRecord r = segment.nodes[node];
+  IR *left =
+      r.left == kNoIndex ? NULL : build(segment, r.left, cache, built);
+  IR *right =
+      r.right == kNoIndex ? NULL : build(segment, r.right, cache, built);
+  IR *ir = make_node(r, segment.ops, segment.strings, left, right);
+  if (cache != nullptr) (*cache)[node] = ir;
+  if (built != nullptr) built->push_back(ir);
+  return ir;
+}
+
+IR *SharedLibrary::materialize(IRTYPE type, size_t i) const {
+  if (i < base_[type].size()) {
+    return build(segments_[0], base_[type][i], nullptr, nullptr);
+  }
+  Ref ref = appended_[type][i - base_[type].size()];
+  return build(segments_[ref.segment], ref.node, nullptr, nullptr);
+}
+
+uint64_t SharedLibrary::hash(IRTYPE type, size_t i) const {
+  if (i < base_[type].size()) return segments_[0].nodes[base_[type][i]].hash;
+  Ref ref = appended_[type][i - base_[type].size()];
+  return segments_[ref.segment].nodes[ref.node].hash;
+}
+
+void SharedLibrary::materialize_all(array<vector<IR *>, kNodeTypeCount> &lists,
+                                    vector<IR *> &nodes) const {
+  vector<vector<IR *>> caches(segments_.size());
+  for (size_t s = 0; s < segments_.size(); ++s) {
+    caches[s].assign(segments_[s].nodes.size(), NULL);
+  }
+  for (size_t type = 0; type < kNodeTypeCount; ++type) {
+    for (size_t i = 0; i < base_[type].size(); ++i) {
+      lists[type].push_back(
+          build(segments_[0], base_[type][i], &caches[0], &nodes));
+    }
+    for (auto ref : appended_[type]) {
+      lists[type].push_back(build(segments_[ref.segment], ref.node,
+                                  &caches[ref.segment], &nodes));
+    }
+  }
+}
+
+void SharedLibrary::for_each_base_hash(
+    const std::function<void(IRTYPE, uint64_t)> &f) const {
+  auto &nodes = segments_[0].nodes;
+  for (size_t type = 0; type < kNodeTypeCount; ++type) {
+    for (size_t i = 0; i < base_[type].size(); ++i) {
+      f(static_cast<IRTYPE>(type), nodes[base_[type][i]].hash);
+    }
+  }
+}
+
+bool SharedLibrary::publish(const IR *root) {
+  NodeTable table;
+  table.add(const_cast<IR *>(root));
+  utils::SnapshotWriter writer;
+  table.write(writer);
+  return log_.append(writer.payload().data(), writer.payload().size());
+}
+
+size_t SharedLibrary::sync(
+    const std::function<bool(IRTYPE, uint64_t)> &accept) {
+  return log_.read(log_cursor_, [&](const char *data, uint32_t size) {
+    utils::SnapshotReader reader;
+    reader.open_payload(data, size);
+    Segment segment;
+    // A record that does not parse is skipped; the others still apply.
+    if (!read_table(reader, segment.nodes, segment.strings, segment.ops) ||
+        !reader.done()) {
+      return;
+    }
+    uint32_t id = segments_.size();
+    bool used = false;
+    for (uint32_t i = 0; i < segment.nodes.size(); ++i) {
+      NodeRecord r = segment.nodes[i];
+      auto type = static_cast<IRTYPE>(r.type);
+      if (!accept(type, r.hash)) continue;
+      appended_[type].push_back({id, i});
+      used = true;
+    }
+    if (used) segments_.push_back(std::move(segment));
+  });
+}
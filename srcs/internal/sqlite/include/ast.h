@@ -1,6 +1,7 @@
 #ifndef __AST_H__
 #define __AST_H__
 
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <set>
@@ -8,6 +9,8 @@
 #include <vector>
 
 #include "define.h"
+#include "utils/arena.h"
+#include "utils/hash.h"
 
 using namespace std;
 
@@ -16,11 +19,12 @@ using namespace std;
 ALLCLASS(DECLARE_CLASS);
 #undef DECLARE_CLASS
 
-#define GEN_NAME() name_ = gen_id_name();
+#define GEN_NAME() node_id_ = g_id_counter++;
 
 #define reset_counter() g_id_counter = 0;
 
-static unsigned long g_id_counter;
+// Per thread, since trees are validated on several threads at once.
+static thread_local unsigned long g_id_counter;
 
 static inline void clear_id() { g_id_counter = 0; }
 
@@ -36,6 +40,12 @@ enum NODETYPE {
   ALLTYPE(DECLARE_TYPE)
 #undef DECLARE_TYPE
 };
+// The number of node types, for arrays indexed by them. Not an enumerator,
+// so that switches over NODETYPE need not handle it.
+#define COUNT_TYPE(v) +1
+inline constexpr uint32_t kNodeTypeCount =
+    uint32_t(kconst_float) + 1 ALLTYPE(COUNT_TYPE);
+#undef COUNT_TYPE
 
 enum IDTYPE {
   id_whatever,
@@ -65,19 +75,44 @@ enum IDTYPE {
 
 typedef NODETYPE IRTYPE;
 
+// Operators are interned: there is exactly one immutable IROperator per
+// distinct (prefix, middle, suffix) triple, shared by every IR using it.
+// Obtain them with `IROperator::get` or the OP* macros in define.h.
 class IROperator {
  public:
-  IROperator(string prefix = "", string middle = "", string suffix = "")
-      : prefix_(prefix), middle_(middle), suffix_(suffix) {}
-
-  string prefix_;
-  string middle_;
-  string suffix_;
+  static const IROperator* get(const string& prefix = "",
+                               const string& middle = "",
+                               const string& suffix = "");
+
+  const string prefix_;
+  const string middle_;
+  const string suffix_;
+  // Dense index of the operator in the interning table.
+  const unsigned int id_;
+  utils::TokenHash prefix_hash_;
+  utils::TokenHash middle_hash_;
+  utils::TokenHash suffix_hash_;
+
+ private:
+  IROperator(const string& prefix, const string& middle, const string& suffix,
+             unsigned int id)
+      : prefix_(prefix), middle_(middle), suffix_(suffix), id_(id) {
+    prefix_hash_.append(prefix_);
+    middle_hash_.append(middle_);
+    suffix_hash_.append(suffix_);
+  }
 };
 
 class IR {
  public:
-  IR(IRTYPE type, IROperator* op, IR* left = NULL, IR* right = NULL)
+  // IR nodes are allocated from the current utils::Arena, if any, so that a
+  // whole mutation round can be released at once.
+  static void* operator new(size_t size) {
+    return utils::arena_aware_new(size);
+  }
+  static void operator delete(void* ptr) { utils::arena_aware_delete(ptr); }
+
+  IR(IRTYPE type, const IROperator* op, IR* left = NULL, IR* right = NULL)
       : type_(type),
         op_(op),
         left_(left),
@@ -131,14 +166,14 @@ class IR {
     GEN_NAME();
   }
 
-  IR(IRTYPE type, IROperator* op, IR* left, IR* right, double f_val,
-     string str_val, string name, unsigned int mutated_times)
+  IR(IRTYPE type, const IROperator* op, IR* left, IR* right, double f_val,
+     string str_val, unsigned long node_id, unsigned int mutated_times)
       : type_(type),
         op_(op),
         left_(left),
         right_(right),
         operand_num_((!!right) + (!!left)),
-        name_(name),
+        node_id_(node_id),
         str_val_(str_val),
         f_val_(f_val),
         mutated_times_(mutated_times),
@@ -152,14 +187,30 @@ class IR {
 
   IDTYPE id_type_;
   IRTYPE type_;
-  string name_;
+  // Debug name of the node, derived from `node_id_`.
+  string name() const { return "v" + std::to_string(node_id_); }
+
+  unsigned long node_id_;
   string str_val_;
-  IROperator* op_;
+  const IROperator* op_;
   IR* left_;
   IR* right_;
   int operand_num_;
   unsigned int mutated_times_ = 0;
   string to_string();
+  // Appends the untrimmed SQL of this subtree to `res`. Returns false if the
+  // node is a literal, which `to_string` hands out verbatim.
+  bool to_string_core(string& res);
+
+  // Hash of the SQL of the subtree, assembled from the operator, the literal
+  // and the hashes of the children. Only valid right after `structural_hash`
+  // or `update_hash`, since trees are edited in place.
+  utils::TokenHash hash_;
+  // Recomputes `hash_` for every node of the subtree, bottom-up, and returns
+  // its digest.
+  unsigned long structural_hash();
+  // Recomputes `hash_` of this node from the `hash_` of its children.
+  unsigned long update_hash();
 };
 
 class IRCollector {
@@ -1,9 +1,22 @@
 #ifndef __MUTATOR_H__
 #define __MUTATOR_H__
 
+#include <array>
+#include <memory>
+
+#include "absl/container/flat_hash_set.h"
 #include "ast.h"
 #include "define.h"
 #include "utils.h"
+#include "utils/arena.h"
+#include "utils/grammar_check.h"
+#include "utils/library_weights.h"
+#include "utils/mutant_feedback.h"
+#include "utils/mutation_trace.h"
+#include "utils/operator_schedule.h"
+#include "utils/rng.h"
+#include "utils/sparse_table.h"
+#include "utils/thread_pool.h"
 
 #define LUCKY_NUMBER 500
 
@@ -11,17 +24,29 @@ using namespace std;
 
 class Mutator {
  public:
-  Mutator() { srand(time(nullptr)); }
-
   IR *deep_copy_with_record(const IR *root, const IR *record);
   unsigned long hash(IR *);
   unsigned long hash(string);
 
   IR *ir_random_generator(vector<IR *> v_ir_collector);
 
-  vector<IR *> mutate_all(vector<IR *> &v_ir_collector);
+  // With `origins`, also what made each mutant, for the feedback of the
+  // scheduler and of the library weights.
+  vector<IR *> mutate_all(vector<IR *> &v_ir_collector,
+                          vector<utils::MutantOrigin> *origins = NULL);
+  // Same as above, with the work spread over `pool`.
+  vector<IR *> mutate_all(vector<IR *> &v_ir_collector,
+                          utils::ThreadPool &pool,
+                          vector<utils::MutantOrigin> *origins = NULL);
 
   vector<IR *> mutate(IR *input);
+  // The variants of `input`, which is left untouched. With `origins`, also
+  // what made each variant. The operators the scheduler, if any, skips are
+  // not built at all.
+  vector<IR *> make_variants(IR *input,
+                             vector<utils::MutantOrigin> *origins = NULL);
+  // Counts the `variants` made from `input` in their `mutated_times_`.
+  void count_mutation(IR *input, vector<IR *> &variants);
   IR *strategy_delete(IR *cur);
   IR *strategy_insert(IR *cur);
   IR *strategy_replace(IR *cur);
@@ -38,9 +63,30 @@ class Mutator {
   IR *get_from_libary_3D(IR *);
   IR *get_from_libary_2D(IR *);
 
+  // The libraries that mutants take entries from, as told apart by the
+  // types of their utils::LibraryPick: `library * kNodeTypeCount + type`.
+  enum Library : uint32_t { kLibrary2D, kLeftLibrary, kRightLibrary };
+  static constexpr size_t kLibraries = 3;
+  // Draws library entries by their score rather than uniformly, see
+  // utils::LibraryWeights.
+  void set_library_weights(const utils::LibraryWeightOptions &options);
+  // Samples the operators of `make_variants` with `scheduler`, which must
+  // outlive the mutator. It is read by the threads of `mutate_all`.
+  void set_operator_scheduler(utils::OperatorScheduler *scheduler) {
+    scheduler_ = scheduler;
+  }
+  // The entries of `picks` went into a mutant that ran, or that became a
+  // queue entry.
+  void library_ran(const vector<utils::LibraryPick> &picks);
+  void library_found(const vector<utils::LibraryPick> &picks);
+  // The same for the library weights, or "" without them.
+  string describe_library_weights() const;
+
   void init(string f_testcase, string f_common_string = "", string pragma = "");
   string fix(IR *root);
+  bool fix(IR *root, string &res, size_t depth);
   string extract_struct(IR *root);
+  bool extract_struct(IR *root, string &res);
   string extract_struct2(IR *root);
   void add_new_table(IR *root, string &table_name);
   void reset_database();
@@ -63,26 +109,66 @@ class Mutator {
   unsigned long get_a_val();
   static vector<string> common_string_libary;
   static vector<unsigned long> value_libary;
-  static map<string, vector<string>> m_tables;
-  static vector<string> v_table_names;
+  // The tables seen by the statement being fixed. Per thread, so that
+  // several trees can be validated at once.
+  static thread_local map<string, vector<string>> m_tables;
+  static thread_local vector<string> v_table_names;
   ~Mutator();
 
   void debug(IR *root);
   unsigned long get_library_size();
+  // Writes the libraries to a binary snapshot, see utils/snapshot.h.
+  bool save_snapshot(const string &path);
+  // Replaces the libraries with those of a snapshot written by
+  // `save_snapshot`, without parsing any SQL. Returns false if the snapshot
+  // is missing or unusable.
+  bool load_snapshot(const string &path);
   int try_fix(char *buf, int len, char *&new_buf, int &new_len);
 
+  // Learns the productions of `root`, a tree built by the parser.
+  void learn_productions(IR *root);
+  // Whether every node of `root` is a production of some parsed tree, i.e.
+  // whether it can skip the parser in `validate`.
+  bool well_formed(IR *root) const;
+  void set_validate_mode(utils::ValidateMode mode) { validate_mode_ = mode; }
+  // The generator of every draw made for this mutator, see utils::RngScope.
+  utils::Rng &rng() { return rng_; }
+  // The counters of the grammar check as one line of text.
+  string describe_validation() const;
+
  private:
-  IR *record_ = NULL;
-  map<NODETYPE, map<NODETYPE, vector<IR *>>> ir_libary_3D_;
-  map<NODETYPE, map<NODETYPE, set<unsigned long>>> ir_libary_3D_hash_;
-  map<NODETYPE, set<unsigned long>> ir_libary_2D_hash_;
-  map<NODETYPE, vector<IR *>> ir_libary_2D_;
-  map<NODETYPE, vector<IR *>> left_lib;
-  map<NODETYPE, vector<IR *>> right_lib;
+  // The production that `node` stands for, see utils::ProductionSet.
+  static uint64_t production_key(const IR *node);
+  // The list of `library` for `type`.
+  const vector<IR *> &library_list(Library library, NODETYPE type) const;
+  // The index of the entry to take from the list of `library` for `type`,
+  // which has `size` entries.
+  size_t pick_from_library(Library library, NODETYPE type, size_t size);
+  // Rebuilds the tables of `library_weights_` that need it, between rounds.
+  void refresh_library_weights();
+
+  // Per-thread scratch of `deep_copy_with_record`.
+  static thread_local IR *record_;
+  // Where `pick_from_library` records the entries it takes, if anywhere.
+  static thread_local vector<utils::LibraryPick> *picks_;
+  // The children MUTATESTART changes, drawn by `make_variants` before the
+  // strategy runs.
+  static thread_local unsigned mutate_side_;
+  // Backing storage for every tree kept in the libraries below.
+  utils::Arena library_arena_;
+  // Indexed by node type. The 3D library is keyed by the types of the left
+  // and right children, of which only a few pairs ever occur.
+  utils::SparseTable<vector<IR *>, kNodeTypeCount> ir_libary_3D_;
+  utils::SparseTable<absl::flat_hash_set<unsigned long>, kNodeTypeCount>
+      ir_libary_3D_hash_;
+  array<absl::flat_hash_set<unsigned long>, kNodeTypeCount> ir_libary_2D_hash_;
+  array<vector<IR *>, kNodeTypeCount> ir_libary_2D_;
+  array<vector<IR *>, kNodeTypeCount> left_lib;
+  array<vector<IR *>, kNodeTypeCount> right_lib;
   vector<string> string_libary;
   map<IDTYPE, IDTYPE> relationmap;
   map<IDTYPE, IDTYPE> cross_map;
-  set<unsigned long> string_libary_hash_;
+  absl::flat_hash_set<unsigned long> string_libary_hash_;
 
   vector<string> cmds_;
   map<string, vector<string>> m_cmd_value_lib_;
@@ -90,6 +176,14 @@ class Mutator {
   string s_table_name;
 
   map<NODETYPE, int> type_counter_;
+
+  utils::ProductionSet productions_;
+  utils::ValidateMode validate_mode_ = utils::ValidateMode::kReparse;
+  // Seeded from AFL++, see DataBase::seed.
+  utils::Rng rng_;
+  utils::GrammarCheckStats validate_stats_;
+  unique_ptr<utils::LibraryWeights> library_weights_;
+  utils::OperatorScheduler *scheduler_ = nullptr;
 };
 
 #endif
@@ -6,6 +6,7 @@
 #include "../parser/flex_lexer.h"
 #include "ast.h"
 #include "define.h"
+#include "utils/rng.h"
 //#include "/usr/local/mysql/include/mysql.h"
 
 #include <dirent.h>
@@ -19,7 +20,7 @@
 
 using std::string;
 
-#define get_rand_int(range) rand() % (range)
+#define get_rand_int(range) utils::rand_below(range)
 //#define vector_rand_ele(a) (a[get_rand_int(a.size())])
 #define vector_rand_ele(a) \
   (a.size() != 0 ? a[get_rand_int(a.size())] : gen_id_name())
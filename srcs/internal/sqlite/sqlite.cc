@@ -3,10 +3,27 @@
 #include <string>
 #include <vector>
 
+#include "absl/strings/str_format.h"
 #include "ast.h"
 #include "define.h"
 #include "mutator.h"
 #include "utils.h"
+#include "utils/hash.h"
+
+namespace {
+
+// The name of a node type, without its k, as the MySQL and PostgreSQL
+// mutators name them.
+std::string node_type_name(uint32_t type) {
+#define TYPE_NAME(v) #v,
+  static const char *const kNames[] = {"kconst_str", "kconst_int",
+                                       "kconst_float", ALLTYPE(TYPE_NAME)};
+#undef TYPE_NAME
+  if (type >= kNodeTypeCount) return absl::StrFormat("type%d", type);
+  return kNames[type] + 1;
+}
+
+}  // namespace
 
 SQLiteDB *create_sqlite() { return new SQLiteDB; }
 SQLiteDB::SQLiteDB() { mutator_ = std::make_unique<Mutator>(); }
@@ -16,16 +33,101 @@ bool SQLiteDB::initialize(YAML::Node config) {
   std::cerr << "Init path" << init_lib_path << std::endl;
   const std::string pragma_path = config["pragma"].as<std::string>();
   std::cerr << "pragma path" << pragma_path << std::endl;
+  if (config["ir_arena"]) {
+    use_round_arena_ = config["ir_arena"].as<bool>();
+  }
+  if (config["validate_mode"]) {
+    std::string mode = config["validate_mode"].as<std::string>();
+    if (!utils::parse_validate_mode(mode, &validate_mode_)) {
+      std::cerr << absl::StrFormat("Unknown validate_mode %s.\n", mode);
+    }
+    mutator_->set_validate_mode(validate_mode_);
+  }
+  if (config["library_weights"] && config["library_weights"].as<bool>()) {
+    library_weights_ = true;
+    if (config["library_rare_boost"]) {
+      library_weight_options_.rare_boost =
+          config["library_rare_boost"].as<double>();
+    }
+    mutator_->set_library_weights(library_weight_options_);
+  }
+  if (config["operator_schedule"] && config["operator_schedule"].as<bool>()) {
+    utils::ScheduleOptions options;
+    if (config["operator_schedule_period"]) {
+      options.period = config["operator_schedule_period"].as<uint32_t>();
+    }
+    if (config["operator_stats"]) {
+      operator_stats_ = config["operator_stats"].as<std::string>();
+    }
+    scheduler_ = std::make_unique<utils::OperatorScheduler>(kNodeTypeCount,
+                                                            options, 0);
+    mutator_->set_operator_scheduler(scheduler_.get());
+  }
+  if (config["mutate_threads"]) {
+    size_t threads = config["mutate_threads"].as<size_t>();
+    if (threads > 1) pool_ = std::make_unique<utils::ThreadPool>(threads);
+  }
+  if (config["lib_snapshot"]) {
+    lib_snapshot_ = config["lib_snapshot"].as<std::string>();
+    if (config["lib_snapshot_interval"]) {
+      lib_snapshot_interval_ = config["lib_snapshot_interval"].as<size_t>();
+    }
+    if (load_library(lib_snapshot_)) {
+      std::cerr << "Loaded library snapshot " << lib_snapshot_ << std::endl;
+      return true;
+    }
+  }
   std::vector<std::string> file_list =
       get_all_files_in_dir(init_lib_path.c_str());
   for (auto &f : file_list) {
     std::cerr << "init lib: " << f << ", status ";
     mutator_->init(f, "", pragma_path);
   }
+  if (!lib_snapshot_.empty()) save_library(lib_snapshot_);
+  return true;
+}
+
+bool SQLiteDB::save_library(const std::string &path) {
+  return mutator_->save_snapshot(path);
+}
+
+bool SQLiteDB::load_library(const std::string &path) {
+  auto mutator = std::make_unique<Mutator>();
+  mutator->set_validate_mode(validate_mode_);
+  if (library_weights_) mutator->set_library_weights(library_weight_options_);
+  mutator->set_operator_scheduler(scheduler_.get());
+  if (!mutator->load_snapshot(path)) return false;
+  mutator_ = std::move(mutator);
   return true;
 }
 
+void SQLiteDB::seed(uint64_t seed) {
+  mutator_->rng().seed(seed);
+  if (scheduler_ != nullptr) scheduler_->seed(seed);
+}
+
+std::string SQLiteDB::describe() {
+  std::string result = mutator_->describe_validation();
+  if (scheduler_ != nullptr) result += "; " + scheduler_->describe();
+  if (library_weights_) result += "; " + mutator_->describe_library_weights();
+  return result;
+}
+
+void SQLiteDB::save_schedule() {
+  if (operator_stats_.empty()) return;
+  if (!scheduler_->save(operator_stats_, node_type_name)) {
+    std::cerr << "Cannot write " << operator_stats_ << std::endl;
+  }
+}
+
 bool SQLiteDB::save_interesting_query(const std::string &query) {
+  utils::MutantOrigin origin;
+  if (recent_mutants_.take(utils::hash_bytes(query.data(), query.size()),
+                           &origin)) {
+    if (scheduler_ != nullptr) scheduler_->found(origin.node_type, origin.op);
+    mutator_->library_found(origin.library);
+  }
+  utils::RngScope rng_scope(&mutator_->rng());
   if (Program *program = parser(query)) {
     std::vector<IR *> ir_set;
     IR *ir = program->translate(ir_set);
@@ -40,18 +142,37 @@ bool SQLiteDB::save_interesting_query(const std::string &query) {
       mutator_->add_to_library(root_ir);
       deep_delete(root_ir);
     }
+    if (lib_snapshot_interval_ &&
+        ++interesting_queries_ % lib_snapshot_interval_ == 0) {
+      save_library(lib_snapshot_);
+    }
     return true;
   }
   return false;
 }
 
-size_t SQLiteDB::validate_all(const std::vector<IR *> &ir_set) {
-  for (IR *ir : ir_set) {
-    std::string validated_ir = mutator_->validate(ir);
+size_t SQLiteDB::validate_all(
+    const std::vector<IR *> &ir_set,
+    std::vector<utils::MutantOrigin> &origins) {
+  if (pool_ != nullptr) {
+    std::vector<std::string> validated(ir_set.size());
+    pool_->run(ir_set.size(), [&](size_t i) {
+      validated[i] = mutator_->validate(ir_set[i]);
+    });
+    for (size_t i = 0; i < ir_set.size(); i++) {
+      if (validated[i].empty()) continue;
+      validated_test_cases_.push(std::move(validated[i]));
+      if (feedback()) validated_origins_.push(std::move(origins[i]));
+    }
+    return validated_test_cases_.size();
+  }
+  for (size_t i = 0; i < ir_set.size(); i++) {
+    std::string validated_ir = mutator_->validate(ir_set[i]);
     if (validated_ir.empty()) {
       continue;
     }
     validated_test_cases_.push(std::move(validated_ir));
+    if (feedback()) validated_origins_.push(std::move(origins[i]));
   }
   return validated_test_cases_.size();
 }
@@ -61,6 +182,13 @@ bool SQLiteDB::has_mutated_test_cases() {
 }
 
 size_t SQLiteDB::mutate(const std::string &query) {
+  // The trees of the previous round are gone by now, so its arena can be
+  // recycled as a whole.
+  round_arena_.reset();
+  if (pool_ != nullptr) pool_->reset_arenas();
+  utils::ArenaScope round_scope(use_round_arena_ ? &round_arena_ : nullptr);
+  utils::RngScope rng_scope(&mutator_->rng());
+
   std::vector<IR *> ir_set, mutated_tree;
   Program *program_root = parser(query.c_str());
   if (program_root == nullptr) {
@@ -78,11 +206,17 @@ size_t SQLiteDB::mutate(const std::string &query) {
     program_root->deep_delete();
   }
   program_root->deep_delete();
+  // The seed was just parsed, so its productions are valid ones.
+  mutator_->learn_productions(ir_set[ir_set.size() - 1]);
 
-  mutated_tree = mutator_->mutate_all(ir_set);
+  std::vector<utils::MutantOrigin> origins;
+  auto *mutant_origins = feedback() ? &origins : nullptr;
+  mutated_tree = pool_ != nullptr
+                     ? mutator_->mutate_all(ir_set, *pool_, mutant_origins)
+                     : mutator_->mutate_all(ir_set, mutant_origins);
   deep_delete(ir_set[ir_set.size() - 1]);
 
-  size_t validated_ir_size = validate_all(mutated_tree);
+  size_t validated_ir_size = validate_all(mutated_tree, origins);
   for (auto ir : mutated_tree) {
     deep_delete(ir);
   }
@@ -95,5 +229,15 @@ size_t SQLiteDB::mutate(const std::string &query) {
 std::string SQLiteDB::get_next_mutated_query() {
   auto result = validated_test_cases_.top();
   validated_test_cases_.pop();
+  if (feedback()) {
+    utils::MutantOrigin origin = std::move(validated_origins_.top());
+    validated_origins_.pop();
+    if (scheduler_ != nullptr && scheduler_->ran(origin.node_type, origin.op)) {
+      save_schedule();
+    }
+    mutator_->library_ran(origin.library);
+    recent_mutants_.add(utils::hash_bytes(result.data(), result.size()),
+                        std::move(origin));
+  }
   return result;
 }
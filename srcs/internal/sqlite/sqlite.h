@@ -3,8 +3,15 @@
 #include <memory>
 #include <stack>
 #include <string>
+#include <vector>
 
 #include "db.h"
+#include "utils/arena.h"
+#include "utils/grammar_check.h"
+#include "utils/library_weights.h"
+#include "utils/mutant_feedback.h"
+#include "utils/operator_schedule.h"
+#include "utils/thread_pool.h"
 
 class Mutator;
 class IR;
@@ -20,11 +27,44 @@ class SQLiteDB : public DataBase {
   virtual bool has_mutated_test_cases();
   // Clean up the enviroment, e.g., drop all the databases.
   virtual bool clean_up() { return true; }
+  virtual bool save_library(const std::string &path);
+  virtual bool load_library(const std::string &path);
+  virtual void seed(uint64_t seed);
+  virtual std::string describe();
 
  private:
-  size_t validate_all(const std::vector<IR *> &ir_set);
+  size_t validate_all(const std::vector<IR *> &ir_set,
+                      std::vector<utils::MutantOrigin> &origins);
+  // Whether the mutants handed out are followed, for `scheduler_` or the
+  // library weights.
+  bool feedback() const { return scheduler_ != nullptr || library_weights_; }
+  // Writes the probabilities of `scheduler_` to `operator_stats_`.
+  void save_schedule();
   std::unique_ptr<Mutator> mutator_;
   std::stack<std::string> validated_test_cases_;
+  // What made each validated test case, with `feedback()`.
+  std::stack<utils::MutantOrigin> validated_origins_;
+  // Every IR built by one call to `mutate` is allocated here.
+  utils::Arena round_arena_;
+  bool use_round_arena_ = true;
+  // Mutates and validates on `mutate_threads` threads when there are more
+  // than one.
+  std::unique_ptr<utils::ThreadPool> pool_;
+  // Snapshot of the libraries, loaded instead of parsing `init_lib` and
+  // rewritten every `lib_snapshot_interval_` interesting queries.
+  std::string lib_snapshot_;
+  size_t lib_snapshot_interval_ = 0;
+  size_t interesting_queries_ = 0;
+  utils::ValidateMode validate_mode_ = utils::ValidateMode::kReparse;
+  // Learns which operators make queue entries, see `operator_schedule`.
+  std::unique_ptr<utils::OperatorScheduler> scheduler_;
+  std::string operator_stats_;
+  // Scores the library entries by the queue entries, see `library_weights`.
+  bool library_weights_ = false;
+  utils::LibraryWeightOptions library_weight_options_;
+  // The mutants handed out last, for the feedback of `scheduler_` and of
+  // the library weights.
+  utils::RecentMutants recent_mutants_;
 };
 
 SQLiteDB *create_sqlite();
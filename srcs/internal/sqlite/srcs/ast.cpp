@@ -3,6 +3,9 @@
 #include <cassert>
 #include <cstdio>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <tuple>
 #include <vector>
 
 #include "../include/mutator.h"
@@ -10,31 +13,126 @@
 
 static string s_table_name;
 
-string IR::to_string() {
-  string res;
+const IROperator *IROperator::get(const string &prefix, const string &middle,
+                                  const string &suffix) {
+  // Never destroyed, so that operators outlive every static IR.
+  static auto *table =
+      new map<std::tuple<string, string, string>, const IROperator *>();
+  static std::mutex table_mutex;
+
+  std::lock_guard<std::mutex> lock(table_mutex);
+  auto key = std::make_tuple(prefix, middle, suffix);
+  auto iter = table->find(key);
+  if (iter != table->end()) return iter->second;
 
-  if (type_ == kColumnName && str_val_ == "*") return str_val_;
+  auto *op = new IROperator(prefix, middle, suffix, table->size());
+  table->emplace(std::move(key), op);
+  return op;
+}
+
+string IR::to_string() {
+  // The whole tree is written into one buffer that keeps its capacity
+  // between calls and trimmed once; every child is preceded by a separator,
+  // so this matches trimming each subtree on its own.
+  static thread_local string buffer;
+  buffer.clear();
+  if (to_string_core(buffer)) trim_string(buffer);
+  return buffer;
+}
+
+bool IR::to_string_core(string &res) {
+  if (type_ == kColumnName && str_val_ == "*") {
+    res += str_val_;
+    return false;
+  }
   if (type_ == kFilePath || type_ == kPrepareTargetQuery ||
       type_ == kStringLiteral || type_ == kIdentifier ||
       type_ == kOptOrderType || type_ == kColumnType || type_ == kSetType ||
-      type_ == kOptJoinType || type_ == kOptDistinct || type_ == kNullLiteral)
-    return str_val_;
-  if (type_ == kIntLiteral) return std::to_string(int_val_);
-  if (type_ == kFloatLiteral || type_ == kconst_float)
-    return std::to_string(f_val_);
-  if (type_ == kconst_str) return str_val_;
-  if (type_ == kconst_int) return std::to_string(int_val_);
-
-  if (!str_val_.empty()) return str_val_;
-
-  if (op_ != NULL) res += op_->prefix_ + " ";
-  if (left_ != NULL) res += left_->to_string() + " ";
-  if (op_ != NULL) res += op_->middle_ + " ";
-  if (right_ != NULL) res += right_->to_string() + " ";
+      type_ == kOptJoinType || type_ == kOptDistinct || type_ == kNullLiteral ||
+      type_ == kconst_str) {
+    res += str_val_;
+    return false;
+  }
+  if (type_ == kIntLiteral || type_ == kconst_int) {
+    res += std::to_string(int_val_);
+    return false;
+  }
+  if (type_ == kFloatLiteral || type_ == kconst_float) {
+    res += std::to_string(f_val_);
+    return false;
+  }
+
+  if (!str_val_.empty()) {
+    res += str_val_;
+    return false;
+  }
+
+  if (op_ != NULL) {
+    res += op_->prefix_;
+    res += ' ';
+  }
+  if (left_ != NULL) {
+    left_->to_string_core(res);
+    res += ' ';
+  }
+  if (op_ != NULL) {
+    res += op_->middle_;
+    res += ' ';
+  }
+  if (right_ != NULL) {
+    right_->to_string_core(res);
+    res += ' ';
+  }
   if (op_ != NULL) res += op_->suffix_;
+  return true;
+}
+
+unsigned long IR::update_hash() {
+  // Follows to_string_core piece by piece, so that trees printing the same
+  // SQL share a hash no matter how they are shaped.
+  utils::TokenHash h;
+  if (type_ == kIntLiteral || type_ == kconst_int) {
+    h.append(std::to_string(int_val_));
+  } else if (type_ == kFloatLiteral || type_ == kconst_float) {
+    h.append(std::to_string(f_val_));
+  } else if (!str_val_.empty() || type_ == kFilePath ||
+             type_ == kPrepareTargetQuery || type_ == kStringLiteral ||
+             type_ == kIdentifier || type_ == kOptOrderType ||
+             type_ == kColumnType || type_ == kSetType ||
+             type_ == kOptJoinType || type_ == kOptDistinct ||
+             type_ == kNullLiteral || type_ == kconst_str) {
+    h.append(str_val_);
+    hash_ = h;
+    // to_string returns literals verbatim, spaces included.
+    return utils::hash_combine(
+        h.digest(), utils::hash_bytes(str_val_.data(), str_val_.size()));
+  } else {
+    if (op_ != NULL) {
+      h.append(op_->prefix_hash_);
+      h.append_space();
+    }
+    if (left_ != NULL) {
+      h.append(left_->hash_);
+      h.append_space();
+    }
+    if (op_ != NULL) {
+      h.append(op_->middle_hash_);
+      h.append_space();
+    }
+    if (right_ != NULL) {
+      h.append(right_->hash_);
+      h.append_space();
+    }
+    if (op_ != NULL) h.append(op_->suffix_hash_);
+  }
+  hash_ = h;
+  return h.digest();
+}
 
-  trim_string(res);
-  return res;
+unsigned long IR::structural_hash() {
+  if (left_ != NULL) left_->structural_hash();
+  if (right_ != NULL) right_->structural_hash();
+  return update_hash();
 }
 
 IR *ShowStatement::translate(vector<IR *> &v_ir_collector) {
@@ -979,7 +1077,7 @@ IR *LogicExpr::translate(vector<IR *> &v_ir_collector) {
   auto tmp1 = SAFETRANSLATE(expr1_);
   auto tmp2 = SAFETRANSLATE(expr2_);
 
-  res = new IR(kLogicExpr, OPMID(operator_), tmp1, tmp2);
+  res = new IR(kLogicExpr, IROperator::get("", operator_, ""), tmp1, tmp2);
   TRANSLATEEND
 }
 
@@ -1100,7 +1198,7 @@ IR *BinaryExpr::translate(vector<IR *> &v_ir_collector) {
   CASESTART(1)
   auto tmp1 = SAFETRANSLATE(operand1_);
   auto tmp2 = SAFETRANSLATE(operand2_);
-  res = new IR(kBinaryExpr, OPMID(operator_), tmp1, tmp2);
+  res = new IR(kBinaryExpr, IROperator::get("", operator_, ""), tmp1, tmp2);
   CASEEND
   SWITCHEND
 
@@ -1111,7 +1209,7 @@ IR *CompExpr::translate(vector<IR *> &v_ir_collector) {
   TRANSLATESTART
   auto tmp1 = SAFETRANSLATE(operand1_);
   auto tmp2 = SAFETRANSLATE(operand2_);
-  res = new IR(kCompExpr, OPMID(operator_), tmp1, tmp2);
+  res = new IR(kCompExpr, IROperator::get("", operator_, ""), tmp1, tmp2);
   TRANSLATEEND
 }
 IR *CaseExpr::translate(vector<IR *> &v_ir_collector) {
@@ -2578,7 +2676,7 @@ void OptWhen::deep_delete() {
 IR *TriggerCmdList::translate(vector<IR *> &v_ir_collector) {
   TRANSLATESTART
   TRANSLATELIST(kTriggerCmdList, v_trigger_cmd_list_, ";");
-  res->op_->suffix_ = ";";
+  res->op_ = IROperator::get(res->op_->prefix_, res->op_->middle_, ";");
   TRANSLATEENDNOPUSH
 }
 
@@ -18,8 +18,23 @@ using namespace std;
 
 vector<string> Mutator::common_string_libary;
 vector<unsigned long> Mutator::value_libary;
-map<string, vector<string>> Mutator::m_tables;
-vector<string> Mutator::v_table_names;
+thread_local map<string, vector<string>> Mutator::m_tables;
+thread_local vector<string> Mutator::v_table_names;
+thread_local IR *Mutator::record_ = NULL;
+thread_local vector<utils::LibraryPick> *Mutator::picks_ = NULL;
+thread_local unsigned Mutator::mutate_side_ = 0;
+
+// Debug builds check every structural hash against the SQL of the tree: two
+// trees may only share a structural hash if they serialize identically.
+static void verify_structural_hash(IR *root, unsigned long h) {
+#ifdef VERIFY_IR_HASH
+  static thread_local map<unsigned long, uint64_t> sql_hashes;
+  string sql = root->to_string();
+  uint64_t sql_hash = ducking_hash(sql.c_str(), sql.size());
+  auto iter = sql_hashes.emplace(h, sql_hash).first;
+  assert(iter->second == sql_hash && "structural hash collision");
+#endif
+}
 
 IR *Mutator::deep_copy_with_record(const IR *root, const IR *record) {
   IR *left = NULL, *right = NULL, *copy_res;
@@ -32,14 +47,8 @@ IR *Mutator::deep_copy_with_record(const IR *root, const IR *record) {
     right = deep_copy_with_record(root->right_,
                                   record);  // no I forget to update here
 
-  if (root->op_ != NULL)
-    copy_res = new IR(
-        root->type_,
-        OP3(root->op_->prefix_, root->op_->middle_, root->op_->suffix_), left,
-        right, root->f_val_, root->str_val_, root->name_, root->mutated_times_);
-  else
-    copy_res = new IR(root->type_, NULL, left, right, root->f_val_,
-                      root->str_val_, root->name_, root->mutated_times_);
+  copy_res = new IR(root->type_, root->op_, left, right, root->f_val_,
+                    root->str_val_, root->node_id_, root->mutated_times_);
 
   copy_res->id_type_ = root->id_type_;
 
@@ -68,16 +77,22 @@ bool Mutator::check_node_num(IR *root, unsigned int limit) {
   return is_good;
 }
 
-vector<IR *> Mutator::mutate_all(vector<IR *> &v_ir_collector) {
+vector<IR *> Mutator::mutate_all(vector<IR *> &v_ir_collector,
+                                 vector<utils::MutantOrigin> *origins) {
   vector<IR *> res;
   set<unsigned long> res_hash;
   IR *root = v_ir_collector[v_ir_collector.size() - 1];
+  refresh_library_weights();
 
   for (auto ir : v_ir_collector) {
     if (ir == root || ir->type_ == kProgram) continue;
-    vector<IR *> v_mutated_ir = mutate(ir);
+    vector<utils::MutantOrigin> variant_origins;
+    vector<IR *> v_mutated_ir =
+        make_variants(ir, origins != NULL ? &variant_origins : NULL);
+    count_mutation(ir, v_mutated_ir);
 
-    for (auto i : v_mutated_ir) {
+    for (size_t k = 0; k < v_mutated_ir.size(); k++) {
+      IR *i = v_mutated_ir[k];
       IR *new_ir_tree = deep_copy_with_record(root, ir);
       replace(new_ir_tree, this->record_, i);
 
@@ -87,7 +102,7 @@ vector<IR *> Mutator::mutate_all(vector<IR *> &v_ir_collector) {
       }
 
       string tmp = extract_struct(new_ir_tree);
-      unsigned tmp_hash = hash(tmp);
+      unsigned long tmp_hash = hash(tmp);
       if (res_hash.find(tmp_hash) != res_hash.end()) {
         deep_delete(new_ir_tree);
         continue;
@@ -95,12 +110,77 @@ vector<IR *> Mutator::mutate_all(vector<IR *> &v_ir_collector) {
 
       res_hash.insert(tmp_hash);
       res.push_back(new_ir_tree);
+      if (origins != NULL) origins->push_back(std::move(variant_origins[k]));
     }
   }
 
   return res;
 }
 
+// Mutates every node of the tree on `pool`, in three passes: the variants of
+// all nodes first, which only read the tree, then their counts, then the
+// mutated copies of the tree. Variants that end up with the same structure
+// are dropped in the order of the serial version.
+vector<IR *> Mutator::mutate_all(vector<IR *> &v_ir_collector,
+                                 utils::ThreadPool &pool,
+                                 vector<utils::MutantOrigin> *origins) {
+  IR *root = v_ir_collector[v_ir_collector.size() - 1];
+  refresh_library_weights();
+
+  vector<vector<IR *>> variants(v_ir_collector.size());
+  vector<vector<utils::MutantOrigin>> variant_origins(v_ir_collector.size());
+  pool.run(v_ir_collector.size(), [&](size_t i) {
+    IR *ir = v_ir_collector[i];
+    if (ir == root || ir->type_ == kProgram) return;
+    variants[i] =
+        make_variants(ir, origins != NULL ? &variant_origins[i] : NULL);
+  });
+
+  struct Candidate {
+    IR *node;
+    IR *variant;
+    IR *tree;
+    utils::MutantOrigin *origin;
+  };
+  vector<Candidate> candidates;
+  for (size_t i = 0; i < v_ir_collector.size(); i++) {
+    count_mutation(v_ir_collector[i], variants[i]);
+    for (size_t k = 0; k < variants[i].size(); k++) {
+      candidates.push_back({v_ir_collector[i], variants[i][k], NULL,
+                            origins != NULL ? &variant_origins[i][k] : NULL});
+    }
+  }
+
+  pool.run(candidates.size(), [&](size_t i) {
+    auto &candidate = candidates[i];
+    IR *new_ir_tree = deep_copy_with_record(root, candidate.node);
+    replace(new_ir_tree, this->record_, candidate.variant);
+
+    if (!check_node_num(new_ir_tree, 100)) {
+      deep_delete(new_ir_tree);
+      return;
+    }
+    candidate.tree = new_ir_tree;
+  });
+
+  // extract_struct adds the literals of the tree to the libraries, so it
+  // runs here, in order.
+  vector<IR *> res;
+  set<unsigned long> res_hash;
+  for (auto &candidate : candidates) {
+    if (candidate.tree == NULL) continue;
+    unsigned long tmp_hash = hash(extract_struct(candidate.tree));
+    if (!res_hash.insert(tmp_hash).second) {
+      deep_delete(candidate.tree);
+      continue;
+    }
+    res.push_back(candidate.tree);
+    if (origins != NULL) origins->push_back(std::move(*candidate.origin));
+  }
+
+  return res;
+}
+
 void Mutator::init(string f_testcase, string f_common_string, string pragma) {
   ifstream input_test(f_testcase);
   string line;
@@ -208,24 +288,49 @@ void Mutator::init(string f_testcase, string f_common_string, string pragma) {
 }
 
 vector<IR *> Mutator::mutate(IR *input) {
+  vector<IR *> res = make_variants(input);
+  count_mutation(input, res);
+  return res;
+}
+
+vector<IR *> Mutator::make_variants(IR *input,
+                                    vector<utils::MutantOrigin> *origins) {
   vector<IR *> res;
 
   if (!lucky_enough_to_be_mutated(input->mutated_times_)) {
     return res;  // return a empty set if the IR is not mutated
   }
 
-  res.push_back(strategy_delete(input));
-  res.push_back(strategy_insert(input));
-  res.push_back(strategy_replace(input));
+  auto take = [&](IR *(Mutator::*strategy_fn)(IR *),
+                  utils::MutationStrategy strategy) {
+    // The operator is drawn, and kept or not, before the variant is built.
+    mutate_side_ =
+        strategy == utils::MutationStrategy::kInsert ? 0 : get_rand_int(3);
+    auto op = utils::mutation_operator(strategy, mutate_side_);
+    if (scheduler_ != nullptr &&
+        !scheduler_->keep(input->type_, op, utils::current_rng().uniform())) {
+      return;
+    }
+    if (origins != NULL) origins->push_back({uint32_t(input->type_), op, {}});
+    picks_ = origins != NULL ? &origins->back().library : NULL;
+    res.push_back((this->*strategy_fn)(input));
+  };
+  take(&Mutator::strategy_delete, utils::MutationStrategy::kDelete);
+  take(&Mutator::strategy_insert, utils::MutationStrategy::kInsert);
+  take(&Mutator::strategy_replace, utils::MutationStrategy::kReplace);
+  picks_ = NULL;
 
   // may do some simple filter for res, like removing some duplicated cases
 
-  input->mutated_times_ += res.size();
-  for (auto i : res) {
+  return res;
+}
+
+void Mutator::count_mutation(IR *input, vector<IR *> &variants) {
+  input->mutated_times_ += variants.size();
+  for (auto i : variants) {
     if (i == NULL) continue;
     i->mutated_times_ = input->mutated_times_;
   }
-  return res;
 }
 
 bool Mutator::replace(IR *root, IR *old_ir, IR *new_ir) {
@@ -258,10 +363,27 @@ IR *Mutator::locate_parent(IR *root, IR *old_ir) {
 string Mutator::validate(IR *root) {
   if (root == NULL) return "";
   try {
-    string sql_str = root->to_string();
-    auto parsed_ir = parser(sql_str);
-    if (parsed_ir == NULL) return "";
-    parsed_ir->deep_delete();
+    bool checked =
+        validate_mode_ != utils::ValidateMode::kReparse && well_formed(root);
+    if (validate_mode_ == utils::ValidateMode::kGrammar && checked) {
+      validate_stats_.count(validate_stats_.accepted);
+    } else {
+      if (validate_mode_ == utils::ValidateMode::kGrammar) {
+        validate_stats_.count(validate_stats_.fallbacks);
+      }
+      string sql_str = root->to_string();
+      auto parsed_ir = parser(sql_str);
+      if (validate_mode_ == utils::ValidateMode::kCompare) {
+        validate_stats_.count(validate_stats_.compared);
+        if (checked && parsed_ir == NULL) {
+          validate_stats_.count(validate_stats_.false_accepts);
+        } else if (!checked && parsed_ir != NULL) {
+          validate_stats_.count(validate_stats_.false_rejects);
+        }
+      }
+      if (parsed_ir == NULL) return "";
+      parsed_ir->deep_delete();
+    }
 
     reset_counter();
     vector<IR *> ordered_ir;
@@ -275,6 +397,46 @@ string Mutator::validate(IR *root) {
   return "";
 }
 
+// The type and operator of `node`, or 0 if there is none.
+static uint64_t node_label(const IR *node) {
+  if (node == NULL) return 0;
+  const IROperator *op = node->op_ != NULL ? node->op_ : OP0();
+  return utils::ProductionSet::key(node->type_, op->id_);
+}
+
+// Every child is described with its own children, since many productions
+// share generic types such as kUnknown. The parsed tree is thrown away, so
+// unlike in the other dialects the attributes of the nodes do not matter.
+uint64_t Mutator::production_key(const IR *node) {
+  uint64_t key = node_label(node);
+  for (const IR *child : {node->left_, node->right_}) {
+    uint64_t attributes = 0;
+    if (child != NULL) {
+      attributes = utils::hash_combine(
+          node_label(child), utils::hash_combine(node_label(child->left_),
+                                                 node_label(child->right_)));
+    }
+    key = utils::ProductionSet::add_child(key, child != NULL, attributes);
+  }
+  return key;
+}
+
+void Mutator::learn_productions(IR *root) {
+  if (root->left_) learn_productions(root->left_);
+  if (root->right_) learn_productions(root->right_);
+  productions_.insert(production_key(root));
+}
+
+bool Mutator::well_formed(IR *root) const {
+  if (!productions_.contains(production_key(root))) return false;
+  if (root->left_ && !well_formed(root->left_)) return false;
+  return root->right_ == NULL || well_formed(root->right_);
+}
+
+string Mutator::describe_validation() const {
+  return validate_stats_.describe(productions_.size());
+}
+
 static void collect_ir(IR *root, set<IDTYPE> &type_to_fix,
                        vector<IR *> &ir_to_fix) {
   auto idtype = root->id_type_;
@@ -530,7 +692,8 @@ IR *Mutator::strategy_insert(IR *cur) {
 
   if (cur->type_ == kStatementList) {
     int size = left_lib[kStatementList].size();
-    auto new_right = deep_copy(left_lib[kStatementList][get_rand_int(size)]);
+    auto new_right = deep_copy(left_lib[kStatementList][pick_from_library(
+        kLeftLibrary, kStatementList, size)]);
     auto new_res = new IR(kStatementList, OPMID(";"), res, new_right);
     return new_res;
   }
@@ -539,8 +702,8 @@ IR *Mutator::strategy_insert(IR *cur) {
     auto left_type = res->left_->type_;
     auto left_lib_size = left_lib[left_type].size();
     if (left_lib_size != 0) {
-      auto new_right =
-          deep_copy(left_lib[left_type][get_rand_int(left_lib_size)]);
+      auto new_right = deep_copy(left_lib[left_type][pick_from_library(
+          kLeftLibrary, left_type, left_lib_size)]);
       res->right_ = new_right;
       return res;
     }
@@ -548,8 +711,8 @@ IR *Mutator::strategy_insert(IR *cur) {
     auto right_type = res->right_->type_;
     auto right_lib_size = right_lib[right_type].size();
     if (right_lib_size != 0) {
-      auto new_left =
-          deep_copy(right_lib[right_type][get_rand_int(right_lib_size)]);
+      auto new_left = deep_copy(right_lib[right_type][pick_from_library(
+          kRightLibrary, right_type, right_lib_size)]);
       res->left_ = new_left;
       return res;
     }
@@ -562,7 +725,8 @@ IR *Mutator::strategy_insert(IR *cur) {
   }
 
   auto save = res;
-  res = deep_copy(ir_libary_2D_[res->type_][get_rand_int(lib_size)]);
+  res = deep_copy(ir_libary_2D_[res->type_][pick_from_library(
+      kLibrary2D, res->type_, lib_size)]);
   deep_delete(save);
 
   return res;
@@ -638,13 +802,69 @@ bool Mutator::lucky_enough_to_be_mutated(unsigned int mutated_times) {
 }
 
 IR *Mutator::get_from_libary_2D(IR *ir) {
-  static IR *empty_str = new IR(kStringLiteral, "");
+  static IR *empty_str = [] {
+    utils::ArenaScope heap_scope(nullptr);
+    return new IR(kStringLiteral, "");
+  }();
 
   if (!ir) return NULL;
 
   auto &i = ir_libary_2D_[ir->type_];
   if (i.size() == 0) return empty_str;
-  return i[get_rand_int(i.size())];
+  return i[pick_from_library(kLibrary2D, ir->type_, i.size())];
+}
+
+const vector<IR *> &Mutator::library_list(Library library,
+                                          NODETYPE type) const {
+  switch (library) {
+    case kLeftLibrary:
+      return left_lib[type];
+    case kRightLibrary:
+      return right_lib[type];
+    default:
+      return ir_libary_2D_[type];
+  }
+}
+
+size_t Mutator::pick_from_library(Library library, NODETYPE type,
+                                  size_t size) {
+  uint32_t slot = uint32_t(library) * kNodeTypeCount + type;
+  size_t i = library_weights_ != nullptr
+                 ? library_weights_->sample(slot, size,
+                                            utils::current_rng().uniform())
+                 : get_rand_int(size);
+  if (picks_ != NULL) {
+    picks_->push_back({slot, uint32_t(i), uint32_t(size)});
+  }
+  return i;
+}
+
+void Mutator::set_library_weights(const utils::LibraryWeightOptions &options) {
+  library_weights_ = std::make_unique<utils::LibraryWeights>(
+      kLibraries * kNodeTypeCount, options);
+}
+
+void Mutator::refresh_library_weights() {
+  if (library_weights_ == nullptr) return;
+  library_weights_->refresh([this](uint32_t slot) {
+    return library_list(Library(slot / kNodeTypeCount),
+                        NODETYPE(slot % kNodeTypeCount))
+        .size();
+  });
+}
+
+void Mutator::library_ran(const vector<utils::LibraryPick> &picks) {
+  if (library_weights_ == nullptr) return;
+  for (auto &pick : picks) library_weights_->ran(pick.type, pick.index);
+}
+
+void Mutator::library_found(const vector<utils::LibraryPick> &picks) {
+  if (library_weights_ == nullptr) return;
+  for (auto &pick : picks) library_weights_->found(pick.type, pick.index);
+}
+
+string Mutator::describe_library_weights() const {
+  return library_weights_ != nullptr ? library_weights_->describe() : "";
 }
 
 IR *Mutator::get_from_libary_3D(IR *ir) {
@@ -655,9 +875,9 @@ IR *Mutator::get_from_libary_3D(IR *ir) {
   if (ir->right_) {
     right_type = ir->right_->type_;
   }
-  auto &i = ir_libary_3D_[left_type][right_type];
-  if (i.size() == 0) return new IR(kStringLiteral, "");
-  return i[get_rand_int(i.size())];
+  auto *i = ir_libary_3D_.find(left_type, right_type);
+  if (i == nullptr || i->size() == 0) return new IR(kStringLiteral, "");
+  return (*i)[get_rand_int(i->size())];
 }
 
 string Mutator::get_a_string() {
@@ -683,21 +903,17 @@ unsigned long Mutator::get_library_size() {
   unsigned long res = 0;
 
   for (auto &i : ir_libary_2D_) {
-    res += i.second.size();
+    res += i.size();
   }
 
-  for (auto &i : ir_libary_3D_) {
-    for (auto &j : i.second) {
-      res += j.second.size();
-    }
-  }
+  ir_libary_3D_.for_each([&res](vector<IR *> &i) { res += i.size(); });
 
   for (auto &i : left_lib) {
-    res += i.second.size();
+    res += i.size();
   }
 
   for (auto &i : right_lib) {
-    res += i.second.size();
+    res += i.size();
   }
 
   return res;
@@ -708,13 +924,20 @@ void Mutator::add_to_library(IR *ir) {
 #else
 void Mutator::add_to_library_core(IR *ir) {
 #endif
+  learn_productions(ir);
   NODETYPE p_type = ir->type_;
-  unsigned long p_hash = hash(ir->to_string());
+  unsigned long p_hash = hash(ir);
   if (ir_libary_2D_hash_[p_type].find(p_hash) !=
       ir_libary_2D_hash_[p_type].end()) {
     return;
   }
-  IR *ir_copy = deep_copy(ir);
+  IR *ir_copy;
+  {
+    utils::ArenaScope library_scope(&library_arena_);
+    ir_copy = deep_copy(ir);
+  }
+  // Hash every subtree of the copy once; add_to_library_core builds on that.
+  ir_copy->structural_hash();
   add_to_library_core(ir_copy);
 }
 
@@ -724,8 +947,9 @@ void Mutator::add_to_library_core(IR *ir) {
 void Mutator::add_to_library(IR *ir) {
 #endif
 
-  string p_str = ir->to_string();
-  unsigned long p_hash = hash(p_str);
+  // The children were hashed by add_to_library, so this is O(1).
+  unsigned long p_hash = ir->update_hash();
+  verify_structural_hash(ir, p_hash);
   NODETYPE p_type = ir->type_;
   NODETYPE left_type = kEmpty, right_type = kEmpty;
 
@@ -772,17 +996,15 @@ void Mutator::add_to_library(IR *ir) {
   }
 
   // update library_3D
-  set<unsigned long> &hash_map = ir_libary_3D_hash_[left_type][right_type];
-  if (hash_map.find(p_hash) != hash_map.end()) {
+  auto &hash_map = ir_libary_3D_hash_(left_type, right_type);
+  if (!hash_map.insert(p_hash).second) {
     return;
   }
 
-  ir_libary_3D_hash_[left_type][right_type].insert(p_hash);
-
 #ifdef _NON_REPLACE_
-  ir_libary_3D_[left_type][right_type].push_back(ir);
+  ir_libary_3D_(left_type, right_type).push_back(ir);
 #else
-  ir_libary_3D_[left_type][right_type].push_back(deep_copy(ir));
+  ir_libary_3D_(left_type, right_type).push_back(deep_copy(ir));
 #endif
 
   return;
@@ -792,7 +1014,11 @@ unsigned long Mutator::hash(string sql) {
   return ducking_hash(sql.c_str(), sql.size());
 }
 
-unsigned long Mutator::hash(IR *root) { return this->hash(root->to_string()); }
+unsigned long Mutator::hash(IR *root) {
+  auto h = root->structural_hash();
+  verify_structural_hash(root, h);
+  return h;
+}
 
 void Mutator::debug(IR *root) {
   cout << get_string_by_type(root->type_) << endl;
@@ -803,31 +1029,29 @@ void Mutator::debug(IR *root) {
 Mutator::~Mutator() {
   cout << "HERE" << endl;
   // delete ir_libary_3D_
-  for (auto &i : ir_libary_3D_) {
-    for (auto &j : i.second) {
-      for (auto &ir : j.second) {
-        deep_delete(ir);
-      }
+  ir_libary_3D_.for_each([](vector<IR *> &i) {
+    for (auto &ir : i) {
+      deep_delete(ir);
     }
-  }
+  });
 
   // delete ir_libary_2D_
   for (auto &i : ir_libary_2D_) {
-    for (auto &ir : i.second) {
+    for (auto &ir : i) {
       deep_delete(ir);
     }
   }
 
   // delete left_lib
   for (auto &i : left_lib) {
-    for (auto &ir : i.second) {
+    for (auto &ir : i) {
       deep_delete(ir);
     }
   }
 
   // delete right_lib
   for (auto &i : right_lib) {
-    for (auto &ir : i.second) {
+    for (auto &ir : i) {
       deep_delete(ir);
     }
   }
@@ -905,30 +1129,43 @@ void Mutator::fix_graph(map<IR *, set<IR *>> &graph, IR *root,
   }
 }
 
-/* tranverse ir in the order: _right ==> root ==> left_ */
 string Mutator::fix(IR *root) {
-  string res;
+  static thread_local string buffer;
+  buffer.clear();
+  if (fix(root, buffer, 0)) trim_string(buffer);
+  return buffer;
+}
+
+/* tranverse ir in the order: _right ==> root ==> left_ */
+/* Appends the fixed SQL of `root` to `res` without trimming it. Returns false
+ * if `root` is a leaf whose text `fix(IR *)` returns verbatim. */
+bool Mutator::fix(IR *root, string &res, size_t depth) {
+  // The right subtree is fixed first so that random draws keep their order.
+  // Its text waits in a per-depth scratch buffer until it is appended.
+  static thread_local deque<string> right_buffers;
+  if (right_buffers.size() <= depth) right_buffers.resize(depth + 1);
+  string &tmp_right = right_buffers[depth];
+
   auto *right_ = root->right_, *left_ = root->left_;
   auto *op_ = root->op_;
   auto type_ = root->type_;
-  auto str_val_ = root->str_val_;
-  auto f_val_ = root->f_val_;
-  auto int_val_ = root->int_val_;
+  const string &str_val_ = root->str_val_;
   auto id_type_ = root->id_type_;
 
-  string tmp_right;
-  if (right_ != NULL) tmp_right = fix(right_);
+  tmp_right.clear();
+  if (right_ != NULL) fix(right_, tmp_right, depth + 1);
 
   if (type_ == kIdentifier &&
       (id_type_ == id_database_name || id_type_ == id_schema_name)) {
     if (get_rand_int(2) == 1)
-      return string("main");
+      res += "main";
     else
-      return string("temp");
+      res += "temp";
+    return false;
   }
 
   if (type_ == kCmdPragma) {
-    string res = "PRAGMA ";
+    res += "PRAGMA ";
     int lib_size = cmds_.size();
     string &key = cmds_[get_rand_int(lib_size)];
     res += key;
@@ -948,39 +1185,66 @@ string Mutator::fix(IR *root) {
     } else {
       value = "=" + value;
     }
-    if (!value.empty()) res += value + ";";
-    return res;
+    if (!value.empty()) {
+      res += value;
+      res += ';';
+    }
+    return false;
   }
 
   if (type_ == kFilePath || type_ == kPrepareTargetQuery ||
       type_ == kOptOrderType || type_ == kColumnType || type_ == kSetType ||
-      type_ == kOptJoinType || type_ == kOptDistinct || type_ == kNullLiteral)
-    return str_val_;
+      type_ == kOptJoinType || type_ == kOptDistinct || type_ == kNullLiteral) {
+    res += str_val_;
+    return false;
+  }
   if (type_ == kStringLiteral) {
-    auto s = string_libary[get_rand_int(string_libary.size())];
-    return "'" + s + "'";
+    res += '\'';
+    res += string_libary[get_rand_int(string_libary.size())];
+    res += '\'';
+    return false;
+  }
+  if (type_ == kIntLiteral) {
+    res += std::to_string(value_libary[get_rand_int(value_libary.size())]);
+    return false;
   }
-  if (type_ == kIntLiteral)
-    return std::to_string(value_libary[get_rand_int(value_libary.size())]);
-  if (type_ == kFloatLiteral || type_ == kconst_float)
-    return std::to_string(
+  if (type_ == kFloatLiteral || type_ == kconst_float) {
+    res += std::to_string(
         float(value_libary[get_rand_int(value_libary.size())]) + 0.1);
-  if (type_ == kconst_str)
-    return string_libary[get_rand_int(string_libary.size())];
-  ;
-  if (type_ == kconst_int)
-    return std::to_string(value_libary[get_rand_int(value_libary.size())]);
+    return false;
+  }
+  if (type_ == kconst_str) {
+    res += string_libary[get_rand_int(string_libary.size())];
+    return false;
+  }
+  if (type_ == kconst_int) {
+    res += std::to_string(value_libary[get_rand_int(value_libary.size())]);
+    return false;
+  }
 
-  if (!str_val_.empty()) return str_val_;
+  if (!str_val_.empty()) {
+    res += str_val_;
+    return false;
+  }
 
-  if (op_ != NULL) res += op_->prefix_ + " ";
-  if (left_ != NULL) res += fix(left_) + " ";
-  if (op_ != NULL) res += op_->middle_ + " ";
-  if (right_ != NULL) res += tmp_right + " ";
+  if (op_ != NULL) {
+    res += op_->prefix_;
+    res += ' ';
+  }
+  if (left_ != NULL) {
+    fix(left_, res, depth + 1);
+    res += ' ';
+  }
+  if (op_ != NULL) {
+    res += op_->middle_;
+    res += ' ';
+  }
+  if (right_ != NULL) {
+    res += tmp_right;
+    res += ' ';
+  }
   if (op_ != NULL) res += op_->suffix_;
-
-  trim_string(res);
-  return res;
+  return true;
 }
 
 unsigned int Mutator::calc_node(IR *root) {
@@ -1046,19 +1310,29 @@ string Mutator::extract_struct2(IR *root) {
 }
 
 string Mutator::extract_struct(IR *root) {
-  static int counter = 0;
-  string res;
+  static thread_local string buffer;
+  buffer.clear();
+  if (extract_struct(root, buffer)) trim_string(buffer);
+  return buffer;
+}
+
+/* Appends the structure of `root` to `res` without trimming it. Returns false
+ * if `root` is a leaf whose text `extract_struct(IR *)` returns verbatim. */
+bool Mutator::extract_struct(IR *root, string &res) {
   auto *right_ = root->right_, *left_ = root->left_;
   auto *op_ = root->op_;
   auto type_ = root->type_;
-  auto str_val_ = root->str_val_;
+  const string &str_val_ = root->str_val_;
 
-  if (type_ == kColumnName && str_val_ == "*") return str_val_;
-  if (type_ == kOptOrderType || type_ == kNullLiteral || type_ == kColumnType ||
-      type_ == kSetType || type_ == kOptJoinType || type_ == kOptDistinct)
-    return str_val_;
+  if ((type_ == kColumnName && str_val_ == "*") || type_ == kOptOrderType ||
+      type_ == kNullLiteral || type_ == kColumnType || type_ == kSetType ||
+      type_ == kOptJoinType || type_ == kOptDistinct) {
+    res += str_val_;
+    return false;
+  }
   if (root->id_type_ != id_whatever && root->id_type_ != id_module_name) {
-    return "x";
+    res += 'x';
+    return false;
   }
   if (type_ == kPrepareTargetQuery || type_ == kStringLiteral) {
     string str_val = str_val_;
@@ -1072,31 +1346,51 @@ string Mutator::extract_struct(IR *root) {
       string_libary.push_back(magic_string);
       string_libary_hash_.insert(h);
     }
-    return "'y'";
+    res += "'y'";
+    return false;
   }
   if (type_ == kIntLiteral) {
     value_libary.push_back(root->int_val_);
-    return "10";
+    res += "10";
+    return false;
   }
   if (type_ == kFloatLiteral || type_ == kconst_float) {
     value_libary.push_back((unsigned long)root->f_val_);
-    return "0.1";
+    res += "0.1";
+    return false;
   }
   if (type_ == kconst_int) {
     value_libary.push_back(root->int_val_);
-    return "11";
+    res += "11";
+    return false;
+  }
+  if (type_ == kFilePath) {
+    res += "'file_name'";
+    return false;
   }
-  if (type_ == kFilePath) return "'file_name'";
 
-  if (!str_val_.empty()) return str_val_;
-  if (op_ != NULL) res += op_->prefix_ + " ";
-  if (left_ != NULL) res += extract_struct(left_) + " ";
-  if (op_ != NULL) res += op_->middle_ + " ";
-  if (right_ != NULL) res += extract_struct(right_) + " ";
+  if (!str_val_.empty()) {
+    res += str_val_;
+    return false;
+  }
+  if (op_ != NULL) {
+    res += op_->prefix_;
+    res += ' ';
+  }
+  if (left_ != NULL) {
+    extract_struct(left_, res);
+    res += ' ';
+  }
+  if (op_ != NULL) {
+    res += op_->middle_;
+    res += ' ';
+  }
+  if (right_ != NULL) {
+    extract_struct(right_, res);
+    res += ' ';
+  }
   if (op_ != NULL) res += op_->suffix_;
-
-  trim_string(res);
-  return res;
+  return true;
 }
 
 void Mutator::add_new_table(IR *root, string &table_name) {
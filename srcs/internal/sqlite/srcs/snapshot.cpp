@@ -0,0 +1,266 @@
+#include <algorithm>
+
+#include "../include/ast.h"
+#include "../include/mutator.h"
+#include "absl/container/flat_hash_map.h"
+#include "utils/snapshot.h"
+
+// The IR libraries are stored as one table of nodes in which every child
+// comes before its parent, followed by the libraries as indices into that
+// table. The libraries share most of their nodes, which are stored once.
+
+namespace {
+constexpr char kDialect[] = "sqlite";
+constexpr uint32_t kNoIndex = ~0u;
+
+class NodeTable {
+ public:
+  void add(const IR *ir) {
+    if (ir == NULL || index_.count(ir)) return;
+    add(ir->left_);
+    add(ir->right_);
+    if (ir->op_ != NULL && !op_index_.count(ir->op_)) {
+      op_index_[ir->op_] = ops_.size();
+      ops_.push_back(ir->op_);
+    }
+    index_[ir] = nodes_.size();
+    nodes_.push_back(ir);
+  }
+  void add(const vector<IR *> &irs) {
+    for (auto ir : irs) add(ir);
+  }
+
+  uint32_t index(const IR *ir) const {
+    return ir == NULL ? kNoIndex : index_.at(ir);
+  }
+
+  vector<uint32_t> indices(const vector<IR *> &irs) const {
+    vector<uint32_t> res;
+    res.reserve(irs.size());
+    for (auto ir : irs) res.push_back(index(ir));
+    return res;
+  }
+
+  void write(utils::SnapshotWriter &writer) const {
+    vector<string> op_strings;
+    for (auto op : ops_) {
+      op_strings.push_back(op->prefix_);
+      op_strings.push_back(op->middle_);
+      op_strings.push_back(op->suffix_);
+    }
+    writer.put(op_strings);
+
+    writer.put(static_cast<uint32_t>(nodes_.size()));
+    for (auto ir : nodes_) {
+      writer.put(static_cast<uint32_t>(ir->type_));
+      writer.put(ir->op_ == NULL ? kNoIndex : op_index_.at(ir->op_));
+      writer.put(index(ir->left_));
+      writer.put(index(ir->right_));
+      writer.put(ir->int_val_);
+      writer.put(ir->str_val_);
+      writer.put(ir->id_type_);
+      writer.put(ir->node_id_);
+      writer.put(ir->mutated_times_);
+    }
+  }
+
+ private:
+  absl::flat_hash_map<const IR *, uint32_t> index_;
+  vector<const IR *> nodes_;
+  absl::flat_hash_map<const IROperator *, uint32_t> op_index_;
+  vector<const IROperator *> ops_;
+};
+
+// Rebuilds the nodes written by NodeTable::write into the current arena.
+bool read_nodes(utils::SnapshotReader &reader, vector<IR *> &nodes) {
+  vector<string> op_strings;
+  if (!reader.get(op_strings) || op_strings.size() % 3 != 0) return false;
+  vector<const IROperator *> ops;
+  for (size_t i = 0; i < op_strings.size(); i += 3) {
+    ops.push_back(IROperator::get(op_strings[i], op_strings[i + 1],
+                                  op_strings[i + 2]));
+  }
+
+  uint32_t count;
+  if (!reader.get(count)) return false;
+  nodes.clear();
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t type, op, left, right;
+    unsigned long int_val, node_id;
+    string str_val;
+    IDTYPE id_type;
+    unsigned int mutated_times;
+    if (!reader.get(type) || !reader.get(op) || !reader.get(left) ||
+        !reader.get(right) || !reader.get(int_val) || !reader.get(str_val) ||
+        !reader.get(id_type) || !reader.get(node_id) ||
+        !reader.get(mutated_times)) {
+      return false;
+    }
+    // Children always precede their parent, which also rules out cycles.
+    if (type >= kNodeTypeCount || (op != kNoIndex && op >= ops.size()) ||
+        (left != kNoIndex && left >= i) || (right != kNoIndex && right >= i)) {
+      return false;
+    }
+    IR *ir = new IR(static_cast<IRTYPE>(type),
+                    op == kNoIndex ? NULL : ops[op],
+                    left == kNoIndex ? NULL : nodes[left],
+                    right == kNoIndex ? NULL : nodes[right], 0.0, str_val,
+                    node_id, mutated_times);
+    ir->int_val_ = int_val;
+    ir->id_type_ = id_type;
+    nodes.push_back(ir);
+  }
+  return true;
+}
+
+bool valid_indices(const vector<uint32_t> &indices, size_t node_count) {
+  for (auto i : indices) {
+    if (i >= node_count) return false;
+  }
+  return true;
+}
+
+// The 3D library is written as (left type, right type, indices) for every
+// non-empty cell.
+struct Cell3D {
+  uint32_t left_type;
+  uint32_t right_type;
+  vector<uint32_t> indices;
+};
+};  // namespace
+
+bool Mutator::save_snapshot(const string &path) {
+  vector<Cell3D> cells;
+  NodeTable table;
+  for (auto &irs : ir_libary_2D_) table.add(irs);
+  for (auto &irs : left_lib) table.add(irs);
+  for (auto &irs : right_lib) table.add(irs);
+  for (uint32_t l = 0; l < kNodeTypeCount; ++l) {
+    for (uint32_t r = 0; r < kNodeTypeCount; ++r) {
+      auto *irs = ir_libary_3D_.find(l, r);
+      if (irs == nullptr || irs->empty()) continue;
+      table.add(*irs);
+      cells.push_back({l, r, {}});
+    }
+  }
+
+  utils::SnapshotWriter writer;
+  table.write(writer);
+  for (auto &irs : ir_libary_2D_) writer.put(table.indices(irs));
+  for (auto &irs : left_lib) writer.put(table.indices(irs));
+  for (auto &irs : right_lib) writer.put(table.indices(irs));
+  writer.put(static_cast<uint32_t>(cells.size()));
+  for (auto &cell : cells) {
+    writer.put(cell.left_type);
+    writer.put(cell.right_type);
+    writer.put(
+        table.indices(*ir_libary_3D_.find(cell.left_type, cell.right_type)));
+  }
+
+  vector<unsigned long> string_hashes(string_libary_hash_.begin(),
+                                      string_libary_hash_.end());
+  sort(string_hashes.begin(), string_hashes.end());
+  writer.put(string_libary);
+  writer.put(string_hashes);
+  writer.put(relationmap);
+  writer.put(cross_map);
+  writer.put(cmds_);
+  writer.put(m_cmd_value_lib_);
+  writer.put(common_string_libary);
+  writer.put(value_libary);
+  writer.put(m_tables);
+  writer.put(v_table_names);
+
+  return writer.write_file(path, kDialect, kNodeTypeCount);
+}
+
+bool Mutator::load_snapshot(const string &path) {
+  utils::SnapshotReader reader;
+  if (!reader.open(path, kDialect, kNodeTypeCount)) return false;
+
+  vector<IR *> nodes;
+  {
+    utils::ArenaScope library_scope(&library_arena_);
+    if (!read_nodes(reader, nodes)) return false;
+  }
+  for (auto ir : nodes) productions_.insert(production_key(ir));
+
+  array<vector<uint32_t>, kNodeTypeCount> indices_2D, indices_left,
+      indices_right;
+  for (auto *lists : {&indices_2D, &indices_left, &indices_right}) {
+    for (auto &indices : *lists) {
+      if (!reader.get(indices) || !valid_indices(indices, nodes.size()))
+        return false;
+    }
+  }
+  uint32_t cell_count;
+  if (!reader.get(cell_count)) return false;
+  vector<Cell3D> cells;
+  for (uint32_t i = 0; i < cell_count; ++i) {
+    Cell3D cell;
+    if (!reader.get(cell.left_type) || !reader.get(cell.right_type) ||
+        !reader.get(cell.indices) || cell.left_type >= kNodeTypeCount ||
+        cell.right_type >= kNodeTypeCount ||
+        !valid_indices(cell.indices, nodes.size())) {
+      return false;
+    }
+    cells.push_back(std::move(cell));
+  }
+
+  vector<string> string_library, cmds, common_string_library, table_names;
+  vector<unsigned long> string_hashes, value_library;
+  map<IDTYPE, IDTYPE> relations, cross;
+  map<string, vector<string>> cmd_value_lib, tables;
+  reader.get(string_library);
+  reader.get(string_hashes);
+  reader.get(relations);
+  reader.get(cross);
+  reader.get(cmds);
+  reader.get(cmd_value_lib);
+  reader.get(common_string_library);
+  reader.get(value_library);
+  reader.get(tables);
+  reader.get(table_names);
+  if (!reader.done()) return false;
+
+  // Children come first, so every node is hashed after its subtrees.
+  vector<unsigned long> digests;
+  digests.reserve(nodes.size());
+  for (auto ir : nodes) digests.push_back(ir->update_hash());
+
+  for (size_t type = 0; type < kNodeTypeCount; ++type) {
+    ir_libary_2D_[type].clear();
+    ir_libary_2D_hash_[type].clear();
+    for (auto i : indices_2D[type]) {
+      ir_libary_2D_[type].push_back(nodes[i]);
+      ir_libary_2D_hash_[type].insert(digests[i]);
+    }
+    left_lib[type].clear();
+    for (auto i : indices_left[type]) left_lib[type].push_back(nodes[i]);
+    right_lib[type].clear();
+    for (auto i : indices_right[type]) right_lib[type].push_back(nodes[i]);
+  }
+  ir_libary_3D_.clear();
+  ir_libary_3D_hash_.clear();
+  for (auto &cell : cells) {
+    auto &irs = ir_libary_3D_(cell.left_type, cell.right_type);
+    auto &hashes = ir_libary_3D_hash_(cell.left_type, cell.right_type);
+    for (auto i : cell.indices) {
+      irs.push_back(nodes[i]);
+      hashes.insert(digests[i]);
+    }
+  }
+
+  string_libary = std::move(string_library);
+  string_libary_hash_.clear();
+  string_libary_hash_.insert(string_hashes.begin(), string_hashes.end());
+  relationmap = std::move(relations);
+  cross_map = std::move(cross);
+  cmds_ = std::move(cmds);
+  m_cmd_value_lib_ = std::move(cmd_value_lib);
+  common_string_libary = std::move(common_string_library);
+  value_libary = std::move(value_library);
+  m_tables = std::move(tables);
+  v_table_names = std::move(table_names);
+  return true;
+}
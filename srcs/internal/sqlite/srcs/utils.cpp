@@ -20,33 +20,33 @@ void print_v_ir(vector<IR *> &v_ir_collector) {
   for (auto ir : v_ir_collector) {
     if (ir->operand_num_ == 0) {
       if (ir->type_ == kconst_int)
-        cout << ir->name_ << " = .int." << ir->int_val_ << endl;
+        cout << ir->name() << " = .int." << ir->int_val_ << endl;
       else if (ir->type_ == kconst_float)
-        cout << ir->name_ << " = .float." << ir->f_val_ << endl;
+        cout << ir->name() << " = .float." << ir->f_val_ << endl;
       else if (ir->type_ == kBoolLiteral)
-        cout << ir->name_ << " = .bool." << ir->b_val_ << endl;
+        cout << ir->name() << " = .bool." << ir->b_val_ << endl;
       else
-        cout << ir->name_ << " = .str." << ir->str_val_ << endl;
+        cout << ir->name() << " = .str." << ir->str_val_ << endl;
 
     } else if (ir->operand_num_ == 1) {
       string res = "";
       if (ir->op_ != NULL) {
         res += ir->op_->prefix_ + " ";
-        res += ir->left_->name_ + " ";
+        res += ir->left_->name() + " ";
         res += ir->op_->middle_ + " ";
         res += ir->op_->suffix_ + " ";
       }
-      cout << ir->name_ << " = " << res << endl;
+      cout << ir->name() << " = " << res << endl;
     } else if (ir->operand_num_ == 2) {
       string res = "";
       if (ir->op_ != NULL) {
         res += ir->op_->prefix_ + " ";
-        res += ir->left_->name_ + " ";
+        res += ir->left_->name() + " ";
         res += ir->op_->middle_ + " ";
-        res += ir->right_->name_ + " ";
+        res += ir->right_->name() + " ";
         res += ir->op_->suffix_ + " ";
       }
-      cout << ir->name_ << " = " << res << endl;
+      cout << ir->name() << " = " << res << endl;
     }
   }
 
@@ -59,32 +59,32 @@ void print_ir(IR *ir) {
 
   if (ir->operand_num_ == 0) {
     if (ir->type_ == kconst_int)
-      cout << ir->name_ << " = .int." << ir->int_val_ << endl;
+      cout << ir->name() << " = .int." << ir->int_val_ << endl;
     else if (ir->type_ == kconst_float)
-      cout << ir->name_ << " = .float." << ir->f_val_ << endl;
+      cout << ir->name() << " = .float." << ir->f_val_ << endl;
     else if (ir->type_ == kBoolLiteral)
-      cout << ir->name_ << " = .bool." << ir->b_val_ << endl;
+      cout << ir->name() << " = .bool." << ir->b_val_ << endl;
     else
-      cout << ir->name_ << " = .str." << ir->str_val_ << endl;
+      cout << ir->name() << " = .str." << ir->str_val_ << endl;
   } else if (ir->operand_num_ == 1) {
     string res = "";
     if (ir->op_ != NULL) {
       res += ir->op_->prefix_ + " ";
-      res += ir->left_->name_ + " ";
+      res += ir->left_->name() + " ";
       res += ir->op_->middle_ + " ";
       res += ir->op_->suffix_ + " ";
     }
-    cout << ir->name_ << " = " << res << endl;
+    cout << ir->name() << " = " << res << endl;
   } else if (ir->operand_num_ == 2) {
     string res = "";
     if (ir->op_ != NULL) {
       res += ir->op_->prefix_ + " ";
-      res += ir->left_->name_ + " ";
+      res += ir->left_->name() + " ";
       res += ir->op_->middle_ + " ";
-      res += ir->right_->name_ + " ";
+      res += ir->right_->name() + " ";
       res += ir->op_->suffix_ + " ";
     }
-    cout << ir->name_ << " = " << res << endl;
+    cout << ir->name() << " = " << res << endl;
   }
 
   return;
@@ -233,14 +233,8 @@ IR *deep_copy(const IR *root) {
   if (root->right_)
     right = deep_copy(root->right_);  // no I forget to update here
 
-  if (root->op_ != NULL)
-    copy_res = new IR(
-        root->type_,
-        OP3(root->op_->prefix_, root->op_->middle_, root->op_->suffix_), left,
-        right, root->f_val_, root->str_val_, root->name_, root->mutated_times_);
-  else
-    copy_res = new IR(root->type_, NULL, left, right, root->f_val_,
-                      root->str_val_, root->name_, root->mutated_times_);
+  copy_res = new IR(root->type_, root->op_, left, right, root->f_val_,
+                    root->str_val_, root->node_id_, root->mutated_times_);
 
   copy_res->id_type_ = root->id_type_;
 
@@ -251,7 +245,5 @@ void deep_delete(IR *root) {
   if (root->left_) deep_delete(root->left_);
   if (root->right_) deep_delete(root->right_);
 
-  if (root->op_) delete root->op_;
-
   delete root;
 }
@@ -0,0 +1,37 @@
+// Builds the mutator libraries from the `init_lib` of a config and writes
+// them to a snapshot, which `lib_snapshot` in the config then loads at
+// startup instead of parsing the seeds again.
+//
+// Usage: <dbms>_lib_dump <config.yml> <snapshot>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "db.h"
+#include "yaml-cpp/yaml.h"
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <config.yml> <snapshot>"
+              << std::endl;
+    return 1;
+  }
+  YAML::Node config = YAML::LoadFile(argv[1]);
+  // Always start from the seeds, never from an older snapshot.
+  config.remove("lib_snapshot");
+
+  auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<DataBase> db(create_database(config));
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  std::cerr << "Parsed init_lib in "
+            << std::chrono::duration<double>(elapsed).count() << " s"
+            << std::endl;
+
+  if (!db->save_library(argv[2])) {
+    std::cerr << "Cannot write " << argv[2] << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,37 @@
+// Loads a snapshot written by <dbms>_lib_dump and reports how long it takes.
+// With a third argument the loaded libraries are written out again, so that
+// `cmp` can check that a snapshot survives a round trip unchanged.
+//
+// Usage: <dbms>_lib_load <db> <snapshot> [output_snapshot]
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "db.h"
+
+int main(int argc, char **argv) {
+  if (argc != 3 && argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " <db> <snapshot> [output_snapshot]"
+              << std::endl;
+    return 1;
+  }
+  std::unique_ptr<DataBase> db(new_database(argv[1]));
+
+  auto start = std::chrono::steady_clock::now();
+  if (!db->load_library(argv[2])) {
+    std::cerr << "Cannot load " << argv[2] << std::endl;
+    return 1;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  std::cerr << "Loaded " << argv[2] << " in "
+            << std::chrono::duration<double>(elapsed).count() << " s"
+            << std::endl;
+
+  if (argc == 4 && !db->save_library(argv[3])) {
+    std::cerr << "Cannot write " << argv[3] << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,160 @@
+#include "mutant_pipeline.h"
+
+#include <chrono>
+
+#include "absl/strings/str_format.h"
+
+namespace {
+void update_max(std::atomic<uint64_t> &max, uint64_t value) {
+  if (value > max.load(std::memory_order_relaxed)) {
+    max.store(value, std::memory_order_relaxed);
+  }
+}
+};  // namespace
+
+MutantPipeline::MutantPipeline(DataBase *db, size_t capacity)
+    : db_(db), ring_(capacity) {
+  producer_ = std::thread([this] { produce(); });
+}
+
+MutantPipeline::~MutantPipeline() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  stopping_.store(true, std::memory_order_relaxed);
+  work_.notify_one();
+  space_.ring();
+  producer_.join();
+}
+
+size_t MutantPipeline::submit(const std::string &seed) {
+  uint64_t id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = ++submitted_;
+    seeds_.emplace_back(id, seed);
+    if (seeds_.size() > kMaxPendingSeeds) {
+      seeds_.pop_front();
+      seeds_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  work_.notify_one();
+
+  size_t available = ring_.size();
+  occupancy_samples_.fetch_add(1, std::memory_order_relaxed);
+  occupancy_sum_.fetch_add(available, std::memory_order_relaxed);
+  update_max(occupancy_max_, available);
+  if (available != 0) return available;
+
+  // Nothing to hand out yet, e.g. right after start-up.
+  consumer_waits_.fetch_add(1, std::memory_order_relaxed);
+  mutants_.wait([&] {
+    return !ring_.empty() || finished_.load(std::memory_order_acquire) >= id;
+  });
+  return ring_.size();
+}
+
+bool MutantPipeline::next(std::string &mutant) {
+  if (!ring_.try_pop(mutant)) return false;
+  space_.ring();
+  consumed_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void MutantPipeline::save_interesting_query(std::string query) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queries_.push_back(std::move(query));
+  }
+  work_.notify_one();
+}
+
+void MutantPipeline::produce() {
+  std::string seed;
+  uint64_t seed_id = 0;
+  // Whether the last round on `seed` yielded nothing, in which case the
+  // producer waits for a new seed instead of trying it again.
+  bool exhausted = true;
+  while (true) {
+    std::vector<std::string> queries;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_.wait(lock, [&] {
+        return stop_ || !queries_.empty() || !seeds_.empty() || !exhausted;
+      });
+      if (stop_) return;
+      queries.swap(queries_);
+      if (!seeds_.empty()) {
+        seed_id = seeds_.front().first;
+        seed = std::move(seeds_.front().second);
+        seeds_.pop_front();
+        exhausted = false;
+      }
+    }
+    for (auto &query : queries) db_->save_interesting_query(query);
+    if (exhausted) continue;
+
+    // Without a new seed, the current one is mutated again to keep the ring
+    // filled.
+    db_->mutate(seed);
+    seeds_mutated_.fetch_add(1, std::memory_order_relaxed);
+    size_t count = 0;
+    while (db_->has_mutated_test_cases()) {
+      std::string mutant = db_->get_next_mutated_query();
+      if (!push(mutant)) return;
+      ++count;
+    }
+    finished_.store(seed_id, std::memory_order_release);
+    mutants_.ring();
+    exhausted = count == 0;
+  }
+}
+
+bool MutantPipeline::push(std::string &mutant) {
+  if (!ring_.try_push(mutant)) {
+    producer_stalls_.fetch_add(1, std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    do {
+      space_.wait([&] {
+        return stopping_.load(std::memory_order_relaxed) ||
+               ring_.size() < ring_.capacity();
+      });
+      if (stopping_.load(std::memory_order_relaxed)) return false;
+    } while (!ring_.try_push(mutant));
+    auto stalled = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    producer_stall_us_.fetch_add(stalled.count(), std::memory_order_relaxed);
+  }
+  produced_.fetch_add(1, std::memory_order_relaxed);
+  mutants_.ring();
+  return true;
+}
+
+MutantPipeline::Stats MutantPipeline::stats() const {
+  Stats stats;
+  stats.produced = produced_.load(std::memory_order_relaxed);
+  stats.consumed = consumed_.load(std::memory_order_relaxed);
+  stats.seeds_mutated = seeds_mutated_.load(std::memory_order_relaxed);
+  stats.seeds_dropped = seeds_dropped_.load(std::memory_order_relaxed);
+  stats.producer_stalls = producer_stalls_.load(std::memory_order_relaxed);
+  stats.producer_stall_us = producer_stall_us_.load(std::memory_order_relaxed);
+  stats.consumer_waits = consumer_waits_.load(std::memory_order_relaxed);
+  stats.occupancy_samples = occupancy_samples_.load(std::memory_order_relaxed);
+  stats.occupancy_sum = occupancy_sum_.load(std::memory_order_relaxed);
+  stats.occupancy_max = occupancy_max_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+std::string MutantPipeline::describe() const {
+  Stats s = stats();
+  double mean_occupancy =
+      s.occupancy_samples ? double(s.occupancy_sum) / s.occupancy_samples : 0;
+  return absl::StrFormat(
+      "pipeline: produced %d consumed %d seeds %d (dropped %d) "
+      "occupancy mean %.1f max %d of %d producer stalls %d (%d ms) "
+      "consumer waits %d",
+      s.produced, s.consumed, s.seeds_mutated, s.seeds_dropped,
+      mean_occupancy, s.occupancy_max, ring_.capacity(), s.producer_stalls,
+      s.producer_stall_us / 1000, s.consumer_waits);
+}
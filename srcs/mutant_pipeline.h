@@ -0,0 +1,110 @@
+#ifndef __MUTANT_PIPELINE_H__
+#define __MUTANT_PIPELINE_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "db.h"
+#include "utils/doorbell.h"
+#include "utils/spsc_ring.h"
+
+// Mutates seeds on a background thread, ahead of AFL++. The producer thread
+// owns the database: it mutates the seeds handed to it and pushes the
+// validated mutants into a ring, from which the fuzzer takes them in O(1).
+// While the fuzzer runs mutant N, the producer is already building the
+// following ones. Interesting queries are forwarded to the producer, so the
+// libraries are only ever touched by one thread.
+//
+// Mutants are not tied to the seed that was submitted last: the ring holds
+// whatever the producer made from the seeds it received most recently.
+class MutantPipeline {
+ public:
+  struct Stats {
+    uint64_t produced = 0;
+    uint64_t consumed = 0;
+    // Seeds the producer mutated, and those it dropped because newer ones
+    // were waiting.
+    uint64_t seeds_mutated = 0;
+    uint64_t seeds_dropped = 0;
+    // Times the producer found the ring full, and how long it waited.
+    uint64_t producer_stalls = 0;
+    uint64_t producer_stall_us = 0;
+    // Times `submit` found the ring empty and had to wait.
+    uint64_t consumer_waits = 0;
+    // Ring occupancy, sampled at every `submit`.
+    uint64_t occupancy_samples = 0;
+    uint64_t occupancy_sum = 0;
+    uint64_t occupancy_max = 0;
+  };
+
+  // `db` must outlive the pipeline and must not be used by anyone else while
+  // it runs.
+  MutantPipeline(DataBase *db, size_t capacity);
+  MutantPipeline(const MutantPipeline &) = delete;
+  MutantPipeline &operator=(const MutantPipeline &) = delete;
+  ~MutantPipeline();
+
+  // Hands `seed` to the producer and returns how many mutants `next` can
+  // return right away. If there are none, waits until the producer has gone
+  // through `seed`, which may still leave the ring empty.
+  size_t submit(const std::string &seed);
+  // Takes the oldest mutant. Never waits; returns false if the ring is
+  // empty.
+  bool next(std::string &mutant);
+  // Queues `query` for the producer to add to the libraries.
+  void save_interesting_query(std::string query);
+
+  Stats stats() const;
+  // The stats as one line of text.
+  std::string describe() const;
+
+ private:
+  // At most this many seeds wait for the producer; older ones are dropped.
+  static constexpr size_t kMaxPendingSeeds = 8;
+
+  void produce();
+  // Pushes `mutant`, waiting while the ring is full. Returns false if the
+  // pipeline stops meanwhile.
+  bool push(std::string &mutant);
+
+  DataBase *db_;
+  utils::SpscRing<std::string> ring_;
+  // Wake the producer when the ring has room, and `submit` when it has
+  // mutants or the producer is done with a seed.
+  utils::Doorbell space_;
+  utils::Doorbell mutants_;
+  std::thread producer_;
+
+  // Work for the producer, guarded by `mutex_`.
+  mutable std::mutex mutex_;
+  std::condition_variable work_;
+  std::deque<std::pair<uint64_t, std::string>> seeds_;
+  std::vector<std::string> queries_;
+  uint64_t submitted_ = 0;
+  bool stop_ = false;
+  std::atomic<bool> stopping_{false};
+  // The number of the last seed the producer is done with, seeds being
+  // numbered from 1 in the order they are submitted.
+  std::atomic<uint64_t> finished_{0};
+
+  // Updated by the producer only.
+  std::atomic<uint64_t> produced_{0};
+  std::atomic<uint64_t> seeds_mutated_{0};
+  std::atomic<uint64_t> seeds_dropped_{0};
+  std::atomic<uint64_t> producer_stalls_{0};
+  std::atomic<uint64_t> producer_stall_us_{0};
+  // Updated by the consumer only.
+  std::atomic<uint64_t> consumed_{0};
+  std::atomic<uint64_t> consumer_waits_{0};
+  std::atomic<uint64_t> occupancy_samples_{0};
+  std::atomic<uint64_t> occupancy_sum_{0};
+  std::atomic<uint64_t> occupancy_max_{0};
+};
+
+#endif  // __MUTANT_PIPELINE_H__
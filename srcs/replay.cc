@@ -0,0 +1,110 @@
+// Makes again the mutants of a test case saved by AFL++ with
+// `mutation_trace` on, from the trace each one carries and its seed, and
+// tells whether they come out the same. The seed is looked up by its hash in
+// the given directories, e.g. the queue of the run.
+//
+// Usage: <dbms>_replay <config.yml> <test_case> <seed_dir>...
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "absl/strings/str_format.h"
+#include "db.h"
+#include "utils/batch.h"
+#include "utils/mutation_trace.h"
+#include "yaml-cpp/yaml.h"
+
+namespace {
+
+bool read_file(const std::string &path, std::string *content) {
+  std::ifstream input(path, std::ios::binary);
+  if (!input) return false;
+  content->assign(std::istreambuf_iterator<char>(input),
+                  std::istreambuf_iterator<char>());
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " <config.yml> <test_case> <seed_dir>..." << std::endl;
+    return 1;
+  }
+  YAML::Node config = YAML::LoadFile(argv[1]);
+  std::string test_case;
+  if (!read_file(argv[2], &test_case)) {
+    std::cerr << "Cannot read " << argv[2] << std::endl;
+    return 1;
+  }
+
+  // Every test case of every seed, batches included, by hash.
+  std::unordered_map<uint64_t, std::string> seeds;
+  for (int i = 3; i < argc; ++i) {
+    std::error_code error;
+    for (const auto &entry :
+         std::filesystem::directory_iterator(argv[i], error)) {
+      std::string content;
+      if (!entry.is_regular_file() || !read_file(entry.path(), &content)) {
+        continue;
+      }
+      for (std::string_view part : utils::split_batch(content)) {
+        seeds.emplace(utils::seed_hash(part), std::string(part));
+      }
+    }
+    if (error) {
+      std::cerr << "Cannot list " << argv[i] << ": " << error.message()
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::unique_ptr<DataBase> db(create_database(config));
+  int differing = 0;
+  int index = 0;
+  for (std::string_view part : utils::split_batch(test_case)) {
+    std::string_view trace_text;
+    std::string_view mutant = utils::strip_trace(part, &trace_text);
+    std::cout << absl::StrFormat("test case %d: ", index++);
+    utils::MutationTrace trace;
+    if (!utils::MutationTrace::decode(trace_text, &trace)) {
+      std::cout << "no trace" << std::endl;
+      continue;
+    }
+    auto seed = seeds.find(trace.seed_hash);
+    if (seed == seeds.end()) {
+      std::cout << absl::StrFormat("no seed with hash %016x", trace.seed_hash)
+                << std::endl;
+      ++differing;
+      continue;
+    }
+
+    std::string replayed;
+    auto start = std::chrono::steady_clock::now();
+    bool replayed_ok =
+        db->replay(seed->second, std::string(trace_text), &replayed);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (!replayed_ok) {
+      std::cout << "cannot replay" << std::endl;
+      ++differing;
+    } else if (replayed != mutant) {
+      std::cout << absl::StrFormat("differs, replayed in %d us\n",
+                                   elapsed.count())
+                << replayed << std::endl;
+      ++differing;
+    } else {
+      std::cout << absl::StrFormat("identical, replayed in %d us",
+                                   elapsed.count())
+                << std::endl;
+    }
+  }
+  return differing == 0 ? 0 : 2;
+}
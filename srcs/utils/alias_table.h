@@ -0,0 +1,81 @@
+#ifndef __UTILS_ALIAS_TABLE__
+#define __UTILS_ALIAS_TABLE__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils {
+
+// Draws index i of [0, n) with probability weights[i] / sum(weights) in
+// O(1), by Vose's alias method. Building the table takes O(n): every
+// column holds the probability of its own index and the index that makes
+// up the rest of it, its alias.
+class AliasTable {
+ public:
+  AliasTable() = default;
+  explicit AliasTable(const std::vector<double>& weights) { build(weights); }
+
+  // Weights must not be negative. With a sum of 0, the draws are uniform.
+  void build(const std::vector<double>& weights) {
+    size_t n = weights.size();
+    columns_.assign(n, Column());
+    total_ = 0;
+    for (double weight : weights) total_ += weight;
+    if (n == 0) return;
+    if (total_ <= 0) {
+      for (size_t i = 0; i < n; ++i) columns_[i] = {1.0, uint32_t(i)};
+      return;
+    }
+
+    // Scaled so that the mean is 1: the columns under it are filled up by
+    // the ones over it.
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < n; ++i) {
+      scaled[i] = weights[i] * n / total_;
+      (scaled[i] < 1 ? small : large).push_back(uint32_t(i));
+    }
+    while (!small.empty() && !large.empty()) {
+      uint32_t less = small.back();
+      small.pop_back();
+      uint32_t more = large.back();
+      columns_[less] = {scaled[less], more};
+      scaled[more] -= 1 - scaled[less];
+      if (scaled[more] < 1) {
+        large.pop_back();
+        small.push_back(more);
+      }
+    }
+    // What is left is 1 up to rounding errors.
+    for (uint32_t i : large) columns_[i] = {1.0, i};
+    for (uint32_t i : small) columns_[i] = {1.0, i};
+  }
+
+  size_t size() const { return columns_.size(); }
+  double total() const { return total_; }
+
+  // The index drawn by `u`, uniform in [0, 1). A single draw per sample
+  // lets callers keep the number of draws fixed. The table must not be
+  // empty.
+  size_t sample(double u) const {
+    double x = u * columns_.size();
+    size_t column = std::min(size_t(x), columns_.size() - 1);
+    const Column& c = columns_[column];
+    return x - column < c.probability ? column : c.alias;
+  }
+
+ private:
+  struct Column {
+    double probability = 1;
+    uint32_t alias = 0;
+  };
+
+  std::vector<Column> columns_;
+  double total_ = 0;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_ALIAS_TABLE__
@@ -0,0 +1,165 @@
+#ifndef __UTILS_APPEND_LOG__
+#define __UTILS_APPEND_LOG__
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace utils {
+
+// An append-only log of byte records in a file mapped by several processes,
+// e.g. every fuzzer instance on a machine. Appending never takes a lock: a
+// writer reserves space by bumping the shared tail, copies its record in and
+// then publishes the record's size. Readers follow the log with their own
+// cursor and stop at the first record that is not published yet. A writer
+// that dies between the two steps leaves a hole that stops every reader
+// there, but the window is a single memcpy.
+//
+// The file is created sparse with a fixed capacity. Once it is full, appends
+// fail and the log only serves what it already holds.
+class AppendLog {
+ public:
+  static constexpr size_t kDefaultCapacity = size_t(256) << 20;
+
+  struct Header {
+    static constexpr char kMagic[8] = {'S', 'Q', 'R', 'L', 'L', 'O', 'G', '\0'};
+    static constexpr uint32_t kVersion = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t node_type_count;
+    char dialect[16];
+    uint64_t capacity;
+    // Offset past the last reserved record, relative to the end of the
+    // header. It can run past `capacity` when appends fail.
+    std::atomic<uint64_t> tail;
+  };
+  static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                std::atomic<uint32_t>::is_always_lock_free);
+
+  AppendLog() = default;
+  AppendLog(const AppendLog&) = delete;
+  AppendLog& operator=(const AppendLog&) = delete;
+  ~AppendLog() {
+    if (header_ != nullptr) munmap(header_, sizeof(Header) + capacity_);
+  }
+
+  // Maps the log at `path`, creating it with room for `capacity` bytes of
+  // records if it does not exist. An existing log keeps its own capacity,
+  // but must have been created for the same dialect and grammar.
+  bool open(const std::string& path, std::string_view dialect,
+            uint32_t node_type_count, size_t capacity = kDefaultCapacity) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+    // Only the creation of the file is serialized, so that no instance maps
+    // it before the header is in place.
+    flock(fd, LOCK_EX);
+    bool ok = init(fd, dialect, node_type_count, capacity);
+    flock(fd, LOCK_UN);
+    close(fd);
+    return ok;
+  }
+
+  // Appends a record of `size` bytes. Returns false if the log is full.
+  bool append(const void* data, uint32_t size) {
+    if (header_ == nullptr || size == 0) return false;
+    uint64_t length = record_length(size);
+    uint64_t offset = header_->tail.fetch_add(length, std::memory_order_relaxed);
+    if (offset + length > capacity_) return false;
+    char* record = records() + offset;
+    std::memcpy(record + sizeof(uint64_t), data, size);
+    record_size(record)->store(size, std::memory_order_release);
+    return true;
+  }
+
+  // Calls `f(data, size)` for every record published after `cursor`, in log
+  // order, and moves `cursor` past them. Returns the number of records read.
+  template <typename F>
+  size_t read(uint64_t& cursor, F&& f) const {
+    if (header_ == nullptr) return 0;
+    uint64_t end = header_->tail.load(std::memory_order_acquire);
+    if (end > capacity_) end = capacity_;
+    size_t count = 0;
+    while (cursor + sizeof(uint64_t) <= end) {
+      const char* record = records() + cursor;
+      uint32_t size = record_size(record)->load(std::memory_order_acquire);
+      // Reserved, but still being written.
+      if (size == 0) break;
+      f(record + sizeof(uint64_t), size);
+      cursor += record_length(size);
+      ++count;
+    }
+    return count;
+  }
+
+  size_t capacity() const { return capacity_; }
+  bool is_open() const { return header_ != nullptr; }
+
+ private:
+  // A record is its size, padded to 8 bytes, and its data, also padded.
+  static uint64_t record_length(uint32_t size) {
+    return sizeof(uint64_t) + ((uint64_t(size) + 7) & ~uint64_t(7));
+  }
+  static std::atomic<uint32_t>* record_size(const char* record) {
+    return reinterpret_cast<std::atomic<uint32_t>*>(const_cast<char*>(record));
+  }
+  char* records() const { return reinterpret_cast<char*>(header_ + 1); }
+
+  bool init(int fd, std::string_view dialect, uint32_t node_type_count,
+            size_t capacity) {
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) return false;
+    bool create = sb.st_size == 0;
+    if (create) {
+      capacity = (capacity + 7) & ~size_t(7);
+      if (ftruncate(fd, sizeof(Header) + capacity) != 0) return false;
+    } else if (size_t(sb.st_size) < sizeof(Header)) {
+      return false;
+    } else {
+      capacity = sb.st_size - sizeof(Header);
+    }
+
+    void* base = mmap(nullptr, sizeof(Header) + capacity,
+                      PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) return false;
+    Header* header = static_cast<Header*>(base);
+    if (create) {
+      std::memcpy(header->magic, Header::kMagic, sizeof(header->magic));
+      header->version = Header::kVersion;
+      header->node_type_count = node_type_count;
+      dialect.copy(header->dialect, sizeof(header->dialect) - 1);
+      header->capacity = capacity;
+    }
+    bool ok =
+        std::memcmp(header->magic, Header::kMagic, sizeof(header->magic)) ==
+            0 &&
+        header->version == Header::kVersion &&
+        header->node_type_count == node_type_count &&
+        dialect == std::string_view(header->dialect,
+                                    strnlen(header->dialect,
+                                            sizeof(header->dialect))) &&
+        header->capacity == capacity;
+    if (!ok) {
+      munmap(base, sizeof(Header) + capacity);
+      return false;
+    }
+    header_ = header;
+    capacity_ = capacity;
+    return true;
+  }
+
+  Header* header_ = nullptr;
+  size_t capacity_ = 0;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_APPEND_LOG__
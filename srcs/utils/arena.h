@@ -0,0 +1,153 @@
+#ifndef __UTILS_ARENA__
+#define __UTILS_ARENA__
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace utils {
+
+// A bump allocator for objects that die together, e.g. every IR tree built
+// while mutating one seed. Individual deallocations are no-ops; `reset()`
+// rewinds the arena in O(1) and keeps its chunks for the next round.
+class Arena {
+ public:
+  static constexpr size_t kDefaultChunkSize = 1 << 20;
+
+  explicit Arena(size_t chunk_size = kDefaultChunkSize)
+      : chunk_size_(chunk_size) {}
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena() { release(); }
+
+  void* allocate(size_t size) {
+    size = align_up(size);
+    if (current_ == nullptr || cursor_ + size > current_->size) {
+      next_chunk(size);
+    }
+    void* result = current_->data() + cursor_;
+    cursor_ += size;
+    ++allocations_;
+    bytes_allocated_ += size;
+    return result;
+  }
+
+  // Forget every allocation. Objects living in the arena must not be touched
+  // afterwards; their destructors are not run.
+  void reset() {
+    current_ = head_;
+    cursor_ = 0;
+    allocations_ = 0;
+    bytes_allocated_ = 0;
+  }
+
+  // Like `reset()`, but also hands the chunks back to the system.
+  void release() {
+    while (head_ != nullptr) {
+      Chunk* next = head_->next;
+      ::operator delete(head_);
+      head_ = next;
+    }
+    current_ = nullptr;
+    cursor_ = 0;
+    allocations_ = 0;
+    bytes_allocated_ = 0;
+    bytes_reserved_ = 0;
+  }
+
+  size_t allocations() const { return allocations_; }
+  size_t bytes_allocated() const { return bytes_allocated_; }
+  size_t bytes_reserved() const { return bytes_reserved_; }
+
+ private:
+  struct alignas(alignof(std::max_align_t)) Chunk {
+    Chunk* next;
+    size_t size;
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+  };
+
+  static size_t align_up(size_t size) {
+    constexpr size_t kAlign = alignof(std::max_align_t);
+    return (size + kAlign - 1) & ~(kAlign - 1);
+  }
+
+  void next_chunk(size_t size) {
+    // Reuse the chunks kept by `reset()` before asking for a new one.
+    Chunk* prev = current_;
+    Chunk* next = current_ ? current_->next : head_;
+    while (next != nullptr && next->size < size) {
+      prev = next;
+      next = next->next;
+    }
+    if (next == nullptr) {
+      size_t chunk_size = size > chunk_size_ ? size : chunk_size_;
+      next = static_cast<Chunk*>(::operator new(sizeof(Chunk) + chunk_size));
+      next->next = nullptr;
+      next->size = chunk_size;
+      bytes_reserved_ += chunk_size;
+      if (prev == nullptr) {
+        head_ = next;
+      } else {
+        prev->next = next;
+      }
+    }
+    current_ = next;
+    cursor_ = 0;
+  }
+
+  size_t chunk_size_;
+  Chunk* head_ = nullptr;
+  Chunk* current_ = nullptr;
+  size_t cursor_ = 0;
+  size_t allocations_ = 0;
+  size_t bytes_allocated_ = 0;
+  size_t bytes_reserved_ = 0;
+};
+
+// The arena that arena-aware classes allocate from on this thread, or
+// nullptr for the heap.
+inline thread_local Arena* g_current_arena = nullptr;
+
+// Makes `arena` the current arena until the scope ends. Pass nullptr to force
+// heap allocation, e.g. for objects that must outlive the current round.
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena* arena) : saved_(g_current_arena) {
+    g_current_arena = arena;
+  }
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+  ~ArenaScope() { g_current_arena = saved_; }
+
+ private:
+  Arena* saved_;
+};
+
+// Every block handed out by `arena_aware_new` is preceded by this header so
+// that `arena_aware_delete` knows whether the block belongs to an arena.
+struct alignas(alignof(std::max_align_t)) ArenaBlockHeader {
+  Arena* owner;
+};
+
+// Backing for `operator new`/`operator delete` of classes that can live in
+// the current arena.
+inline void* arena_aware_new(size_t size) {
+  size_t total = sizeof(ArenaBlockHeader) + size;
+  Arena* arena = g_current_arena;
+  void* block = arena ? arena->allocate(total) : ::operator new(total);
+  auto* header = static_cast<ArenaBlockHeader*>(block);
+  header->owner = arena;
+  return header + 1;
+}
+
+inline void arena_aware_delete(void* ptr) {
+  if (ptr == nullptr) return;
+  auto* header = static_cast<ArenaBlockHeader*>(ptr) - 1;
+  if (header->owner == nullptr) {
+    ::operator delete(header);
+  }
+}
+
+};  // namespace utils
+
+#endif  // __UTILS_ARENA__
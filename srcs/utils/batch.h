@@ -0,0 +1,96 @@
+#ifndef __UTILS_BATCH__
+#define __UTILS_BATCH__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+// Several test cases packed into one AFL++ input, so that db_driver runs
+// them in a row on one connection and one forkserver round trip. The
+// separator holds NUL bytes, which SQL test cases never do.
+inline constexpr char kBatchSeparatorBytes[] = "\n\0-- squirrel batch\0\n";
+inline constexpr std::string_view kBatchSeparator(
+    kBatchSeparatorBytes, sizeof(kBatchSeparatorBytes) - 1);
+
+inline std::string join_batch(const std::vector<std::string>& test_cases) {
+  std::string result;
+  for (size_t i = 0; i < test_cases.size(); ++i) {
+    if (i != 0) result.append(kBatchSeparator);
+    result.append(test_cases[i]);
+  }
+  return result;
+}
+
+// Splits an input into its test cases. An input without a separator is one
+// test case.
+inline std::vector<std::string_view> split_batch(std::string_view input) {
+  std::vector<std::string_view> result;
+  size_t start = 0;
+  while (true) {
+    size_t end = input.find(kBatchSeparator, start);
+    if (end == std::string_view::npos) break;
+    result.push_back(input.substr(start, end - start));
+    start = end + kBatchSeparator.size();
+  }
+  result.push_back(input.substr(start));
+  return result;
+}
+
+// Tells which test cases of a batch found new coverage. AFL++ sees a single
+// map per input, so the driver clears the map before each test case, takes
+// the bits it set, and puts the union back for AFL++ at the end. The test
+// cases that hit a new edge or hit count bucket, judged against all the
+// previous ones like AFL++ does against its virgin map, are worth handing to
+// AFL++ on their own.
+class BatchCoverage {
+ public:
+  explicit BatchCoverage(size_t map_size)
+      : virgin_(map_size, 0xff), batch_(map_size) {}
+
+  // Starts a batch.
+  void begin() { std::fill(batch_.begin(), batch_.end(), 0); }
+  // Adds the map of one test case and returns true if it has new bits.
+  bool add(const uint8_t* map) {
+    bool found = false;
+    for (size_t i = 0; i < batch_.size(); ++i) {
+      if (map[i] == 0) continue;
+      batch_[i] = std::max(batch_[i], map[i]);
+      uint8_t bucket = count_class(map[i]);
+      if (virgin_[i] & bucket) {
+        virgin_[i] &= ~bucket;
+        found = true;
+      }
+    }
+    return found;
+  }
+  // Writes the union of the batch into `map`. Hit counts are merged by
+  // their maximum, which AFL++ buckets the same way as the largest one.
+  void finish(uint8_t* map) const {
+    std::memcpy(map, batch_.data(), batch_.size());
+  }
+
+  // The hit count buckets of AFL++, one bit each.
+  static uint8_t count_class(uint8_t count) {
+    if (count <= 2) return count;
+    if (count == 3) return 4;
+    if (count <= 7) return 8;
+    if (count <= 15) return 16;
+    if (count <= 31) return 32;
+    if (count <= 127) return 64;
+    return 128;
+  }
+
+ private:
+  std::vector<uint8_t> virgin_;
+  std::vector<uint8_t> batch_;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_BATCH__
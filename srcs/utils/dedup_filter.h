@@ -0,0 +1,152 @@
+#ifndef __UTILS_DEDUP_FILTER__
+#define __UTILS_DEDUP_FILTER__
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "hash.h"
+
+namespace utils {
+
+// Remembers the 64-bit hashes it was given, approximately and in a fixed
+// amount of memory, to drop the mutants that were already tried.
+//
+// It is a blocked Bloom filter: every hash sets kBitsPerHash bits in a
+// single 64-byte block, so a lookup touches one cache line. The memory is
+// split into two generations. New hashes go into the current one; once it
+// holds as many as it can at the target error rate, it becomes the previous
+// one and the old previous one is cleared. A hash is thus forgotten after
+// one to two generations, unless it shows up again meanwhile, which copies
+// it into the current generation.
+//
+// False positives, i.e. new hashes taken for duplicates, are measured on a
+// sample of the hashes, which are also kept exactly.
+class DedupFilter {
+ public:
+  static constexpr size_t kDefaultBytes = size_t(16) << 20;
+
+  struct Stats {
+    // Hashes seen for the first time, and those taken for duplicates.
+    uint64_t inserted = 0;
+    uint64_t duplicates = 0;
+    // Times the current generation was retired.
+    uint64_t agings = 0;
+    // New hashes among the sampled ones, and how many of them were taken
+    // for duplicates.
+    uint64_t sampled_new = 0;
+    uint64_t sampled_false_positives = 0;
+
+    double false_positive_rate() const {
+      return sampled_new ? double(sampled_false_positives) / sampled_new : 0;
+    }
+  };
+
+  // The memory is allocated on the first insert.
+  explicit DedupFilter(size_t bytes = kDefaultBytes) {
+    blocks_ = bytes / 2 / sizeof(Block);
+    if (blocks_ == 0) blocks_ = 1;
+    capacity_ = blocks_ * kBlockBits / kBitsPerEntry;
+  }
+
+  // Remembers `hash` and returns true if it (probably) did already.
+  bool insert(uint64_t hash) {
+    if (generations_[0].blocks.empty()) {
+      for (auto& generation : generations_) generation.blocks.resize(blocks_);
+    }
+    uint64_t x = hash_mix(hash);
+    size_t block = ((x >> 32) * blocks_) >> 32;
+    uint64_t bits = hash_mix(x ^ 0x9e3779b97f4a7c15ULL);
+
+    Generation& current = generations_[current_];
+    Generation& previous = generations_[current_ ^ 1];
+    bool in_current = current.test(block, bits);
+    bool seen = in_current || previous.test(block, bits);
+
+    bool sampled = (x & kSampleMask) == 0;
+    if (sampled && !current.sample.count(hash) &&
+        !previous.sample.count(hash)) {
+      ++stats_.sampled_new;
+      if (seen) ++stats_.sampled_false_positives;
+    }
+    if (seen) {
+      ++stats_.duplicates;
+    } else {
+      ++stats_.inserted;
+    }
+
+    if (!in_current) {
+      if (current.size == capacity_) age();
+      Generation& target = generations_[current_];
+      target.set(block, bits);
+      ++target.size;
+    }
+    if (sampled) generations_[current_].sample.insert(hash);
+    return seen;
+  }
+
+  const Stats& stats() const { return stats_; }
+  // The number of hashes one generation holds.
+  size_t generation_capacity() const { return capacity_; }
+  size_t memory() const { return 2 * blocks_ * sizeof(Block); }
+
+ private:
+  static constexpr size_t kBlockBits = 512;
+  static constexpr size_t kBitsPerHash = 7;
+  // About 0.5% false positives with two full generations.
+  static constexpr size_t kBitsPerEntry = 12;
+  // One hash in 1024 is sampled.
+  static constexpr uint64_t kSampleMask = 1023;
+
+  struct alignas(64) Block {
+    std::array<uint64_t, kBlockBits / 64> words{};
+  };
+
+  struct Generation {
+    std::vector<Block> blocks;
+    size_t size = 0;
+    std::unordered_set<uint64_t> sample;
+
+    // `bits` holds kBitsPerHash positions of 9 bits each.
+    bool test(size_t block, uint64_t bits) const {
+      auto& words = blocks[block].words;
+      for (size_t i = 0; i < kBitsPerHash; ++i, bits >>= 9) {
+        size_t bit = bits & (kBlockBits - 1);
+        if (!(words[bit / 64] >> (bit % 64) & 1)) return false;
+      }
+      return true;
+    }
+    void set(size_t block, uint64_t bits) {
+      auto& words = blocks[block].words;
+      for (size_t i = 0; i < kBitsPerHash; ++i, bits >>= 9) {
+        size_t bit = bits & (kBlockBits - 1);
+        words[bit / 64] |= uint64_t(1) << (bit % 64);
+      }
+    }
+    void clear() {
+      std::fill(blocks.begin(), blocks.end(), Block());
+      size = 0;
+      sample.clear();
+    }
+  };
+
+  void age() {
+    current_ ^= 1;
+    generations_[current_].clear();
+    ++stats_.agings;
+  }
+
+  std::array<Generation, 2> generations_;
+  size_t current_ = 0;
+  // Blocks per generation.
+  size_t blocks_;
+  size_t capacity_;
+  Stats stats_;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_DEDUP_FILTER__
@@ -0,0 +1,52 @@
+#ifndef __UTILS_DOORBELL__
+#define __UTILS_DOORBELL__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace utils {
+
+// Lets a thread sleep until another one changes some lock-free state, e.g.
+// the indices of an SpscRing. The side that changes the state only pays for
+// a fence and a load while nobody sleeps; the mutex is only taken to wake a
+// sleeper.
+//
+// The sleeper announces itself before it checks the state, and the other
+// side changes the state before it looks for sleepers, both behind a
+// sequentially consistent fence: one of them is bound to see the other, so
+// a wake-up is never lost.
+class Doorbell {
+ public:
+  // Blocks until `ready()` holds. `ready` reads the state `ring` is called
+  // after.
+  template <typename Ready>
+  void wait(const Ready& ready) {
+    if (ready()) return;
+    std::unique_lock<std::mutex> lock(mutex_);
+    sleepers_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    condition_.wait(lock, ready);
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // Wakes the threads in `wait`, once the state they wait on has changed.
+  void ring() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) == 0) return;
+    // A sleeper checks the state under the mutex, so it either sees the
+    // change or is asleep by the time the mutex is free.
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    condition_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::atomic<uint32_t> sleepers_{0};
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_DOORBELL__
@@ -0,0 +1,41 @@
+#ifndef __UTILS_ENUM_SET__
+#define __UTILS_ENUM_SET__
+
+#include <bitset>
+#include <cstddef>
+#include <initializer_list>
+
+namespace utils {
+
+// A set of values of a dense enum whose enumerators all lie in [0, N).
+// Membership is a single bit test, unlike std::set which walks a tree.
+// The interface follows std::set where it makes sense.
+template <typename Enum, size_t N>
+class DenseEnumSet {
+ public:
+  DenseEnumSet() = default;
+  DenseEnumSet(std::initializer_list<Enum> values) { insert(values); }
+
+  void insert(Enum value) { bits_.set(index(value)); }
+  void insert(std::initializer_list<Enum> values) {
+    for (Enum value : values) insert(value);
+  }
+  void erase(Enum value) { bits_.reset(index(value)); }
+  void clear() { bits_.reset(); }
+
+  size_t count(Enum value) const { return bits_.test(index(value)); }
+  bool contains(Enum value) const { return bits_.test(index(value)); }
+
+  size_t size() const { return bits_.count(); }
+  bool empty() const { return bits_.none(); }
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  static size_t index(Enum value) { return static_cast<size_t>(value); }
+
+  std::bitset<N> bits_;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_ENUM_SET__
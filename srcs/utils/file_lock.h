@@ -0,0 +1,39 @@
+#ifndef __UTILS_FILE_LOCK__
+#define __UTILS_FILE_LOCK__
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace utils {
+
+// Holds an exclusive flock(2) on `path`, created if needed, until the object
+// goes away. Used to let one of several processes starting together do a
+// piece of set-up while the others wait for it. The kernel drops the lock if
+// the holder dies.
+class FileLock {
+ public:
+  explicit FileLock(const std::string& path)
+      : fd_(::open(path.c_str(), O_RDWR | O_CREAT, 0644)) {
+    if (fd_ >= 0 && flock(fd_, LOCK_EX) != 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+  FileLock(const FileLock&) = delete;
+  FileLock& operator=(const FileLock&) = delete;
+  ~FileLock() {
+    if (fd_ >= 0) close(fd_);
+  }
+
+  bool locked() const { return fd_ >= 0; }
+
+ private:
+  int fd_;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_FILE_LOCK__
@@ -0,0 +1,162 @@
+#ifndef __UTILS_GENERATE__
+#define __UTILS_GENERATE__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "rng.h"
+
+namespace utils {
+
+// When a mutator builds a subtree from the grammar, with the `generate()` of
+// the AST classes, rather than take one from its IR library.
+enum class GenerateMode {
+  // Never: a type missing from the library gets an empty node.
+  kOff,
+  // Only for the types missing from the library.
+  kEmpty,
+  // For the types missing from the library, and instead of a library entry
+  // with `GenerateOptions::probability`.
+  kMixed,
+};
+
+// Parses the `generate` option. Returns false for an unknown name.
+inline bool parse_generate_mode(const std::string& name, GenerateMode* mode) {
+  if (name == "off" || name == "false") {
+    *mode = GenerateMode::kOff;
+  } else if (name == "empty") {
+    *mode = GenerateMode::kEmpty;
+  } else if (name == "mixed") {
+    *mode = GenerateMode::kMixed;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+struct GenerateOptions {
+  GenerateMode mode = GenerateMode::kOff;
+  // Chance that a library pick is generated instead, in GenerateMode::kMixed,
+  // before the weight of the type. The former USEGENERATE took 1 in 400.
+  double probability = 1.0 / 400;
+  // Bounds of a generated tree, counted in grammar rules: past either one,
+  // every rule takes its shortest alternative, see GenerateRule.
+  uint32_t max_depth = 12;
+  uint32_t max_nodes = 200;
+  // Generated trees kept per type. Once a type has that many, most of its
+  // generated picks reuse one of them rather than generate another.
+  uint32_t memo_size = 32;
+  // Weights of the types, by the name of their rule, e.g. {"Expr", 4}: the
+  // probability of a type is `probability` times its weight, 1 by default.
+  // A weight of 0 keeps a type out of GenerateMode::kMixed.
+  std::vector<std::pair<std::string, double>> weights;
+};
+
+// The bounds of the tree being generated on this thread, if any.
+class GenerateBudget {
+ public:
+  explicit GenerateBudget(const GenerateOptions& options)
+      : max_depth_(options.max_depth), max_nodes_(options.max_nodes) {}
+
+  bool exhausted() const { return depth_ > max_depth_ || rules_ > max_nodes_; }
+  void enter() {
+    ++depth_;
+    ++rules_;
+  }
+  void leave() { --depth_; }
+  uint32_t rules() const { return rules_; }
+
+ private:
+  uint32_t max_depth_;
+  uint32_t max_nodes_;
+  uint32_t depth_ = 0;
+  uint32_t rules_ = 0;
+};
+
+inline thread_local GenerateBudget* g_generate_budget = nullptr;
+
+// Makes `budget` the one of the calling thread until the end of the scope.
+class GenerateScope {
+ public:
+  explicit GenerateScope(GenerateBudget* budget) : saved_(g_generate_budget) {
+    g_generate_budget = budget;
+  }
+  GenerateScope(const GenerateScope&) = delete;
+  GenerateScope& operator=(const GenerateScope&) = delete;
+  ~GenerateScope() { g_generate_budget = saved_; }
+
+ private:
+  GenerateBudget* saved_;
+};
+
+// One grammar rule being generated, declared by GENERATESTART. Many rules
+// only reach a terminal through others, e.g. Expr through Operand, so
+// uniform choices alone make trees that never end. Each rule is told its
+// alternative with the shortest derivation, which it takes once the budget
+// is spent.
+class GenerateRule {
+ public:
+  GenerateRule() : budget_(g_generate_budget) {
+    if (budget_ != nullptr) budget_->enter();
+  }
+  GenerateRule(const GenerateRule&) = delete;
+  GenerateRule& operator=(const GenerateRule&) = delete;
+  ~GenerateRule() {
+    if (budget_ != nullptr) budget_->leave();
+  }
+
+  // One of the `choices` alternatives, the last ones of which may stand for
+  // the `default:` of the rule, or `shortest` past the budget.
+  unsigned pick(unsigned choices, unsigned shortest) const {
+    if (budget_ != nullptr && budget_->exhausted()) return shortest;
+    return rand_below(choices);
+  }
+
+ private:
+  GenerateBudget* budget_;
+};
+
+// Counters of the generated picks. The valid mutants are counted by
+// `validate`, which runs on several threads at once.
+struct GenerateStats {
+  // Trees generated, their rules, and the time it took.
+  std::atomic<uint64_t> trees{0};
+  std::atomic<uint64_t> rules{0};
+  std::atomic<uint64_t> generate_ns{0};
+  // Picks of a type missing from the library, and picks served by a
+  // memoized tree.
+  std::atomic<uint64_t> empty_filled{0};
+  std::atomic<uint64_t> memo_hits{0};
+  // Validated mutants with a generated subtree.
+  std::atomic<uint64_t> valid_mutants{0};
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  void count(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+    counter.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  std::string describe() const {
+    double generating = generate_ns.load() / 1e9;
+    double running = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    uint64_t generated = trees.load();
+    return absl::StrFormat(
+        "generate: %d trees of %.1f rules, %.0f trees/s, %d empty types "
+        "filled, %d memo hits, %d valid mutants %.1f/s",
+        generated, generated != 0 ? double(rules.load()) / generated : 0.0,
+        generating > 0 ? generated / generating : 0.0, empty_filled.load(),
+        memo_hits.load(), valid_mutants.load(),
+        running > 0 ? valid_mutants.load() / running : 0.0);
+  }
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_GENERATE__
@@ -0,0 +1,97 @@
+#ifndef __UTILS_GRAMMAR_CHECK__
+#define __UTILS_GRAMMAR_CHECK__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_format.h"
+#include "hash.h"
+
+namespace utils {
+
+// How a mutator decides that a mutant is still valid SQL before fixing it.
+enum class ValidateMode {
+  // Print the mutant and run the parser on it.
+  kReparse,
+  // Check the tree against the productions of parsed trees, and only reparse
+  // the mutants that fail the check. The check is not exact: a few mutants
+  // pass it that the parser rejects, or that parse to other attributes, so
+  // it is opt-in.
+  kGrammar,
+  // Reparse every mutant like kReparse, and count how often the check agrees
+  // with the parser.
+  kCompare,
+};
+
+// Parses the `validate_mode` option. Returns false for an unknown name.
+inline bool parse_validate_mode(const std::string& name, ValidateMode* mode) {
+  if (name == "reparse") {
+    *mode = ValidateMode::kReparse;
+  } else if (name == "grammar") {
+    *mode = ValidateMode::kGrammar;
+  } else if (name == "compare") {
+    *mode = ValidateMode::kCompare;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// The productions the parser is known to build. An IR node stands for one
+// production: its type and operator, plus what it has below, i.e. its
+// children and their attributes. The dialects describe a node by the hash of
+// those, see `production_key`, and learn them from every tree the parser
+// returns. Mutants are made of parsed subtrees, so one whose every node is a
+// known production almost always parses again, to the same tree.
+class ProductionSet {
+ public:
+  // Starts a production key.
+  static uint64_t key(uint64_t type, uint64_t op) {
+    return hash_combine(type, op);
+  }
+  // Adds a child to a production key; `present` is false for a missing one.
+  static uint64_t add_child(uint64_t key, bool present, uint64_t attributes) {
+    return hash_combine(key, present ? hash_mix(attributes) + 1 : 0);
+  }
+
+  bool insert(uint64_t key) { return keys_.insert(key).second; }
+  bool contains(uint64_t key) const { return keys_.count(key) != 0; }
+  size_t size() const { return keys_.size(); }
+
+ private:
+  absl::flat_hash_set<uint64_t> keys_;
+};
+
+// Counters of `validate`, which runs on several threads at once.
+struct GrammarCheckStats {
+  // Mutants that passed the check and skipped the parser.
+  std::atomic<uint64_t> accepted{0};
+  // Mutants that failed the check and were reparsed.
+  std::atomic<uint64_t> fallbacks{0};
+  // In ValidateMode::kCompare, mutants checked both ways, those the check
+  // took for valid but the parser rejected, and those it rejected but the
+  // parser accepted.
+  std::atomic<uint64_t> compared{0};
+  std::atomic<uint64_t> false_accepts{0};
+  std::atomic<uint64_t> false_rejects{0};
+  // Mutants both accepted, whose reparsed tree differs from the mutant.
+  std::atomic<uint64_t> tree_mismatches{0};
+
+  void count(std::atomic<uint64_t>& counter) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::string describe(size_t productions) const {
+    return absl::StrFormat(
+        "grammar check: %d productions, %d accepted %d reparsed, "
+        "%d compared: %d false accepts %d false rejects %d tree mismatches",
+        productions, accepted.load(), fallbacks.load(), compared.load(),
+        false_accepts.load(), false_rejects.load(), tree_mismatches.load());
+  }
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_GRAMMAR_CHECK__
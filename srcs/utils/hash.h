@@ -0,0 +1,113 @@
+#ifndef __UTILS_HASH__
+#define __UTILS_HASH__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace utils {
+
+// Finalizer of SplitMix64; every input bit affects every output bit.
+inline uint64_t hash_mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// Folds `value` into `seed`. The result depends on the order of the calls.
+inline uint64_t hash_combine(uint64_t seed, uint64_t value) {
+  return hash_mix(seed + 0x9e3779b97f4a7c15ULL + hash_mix(value));
+}
+
+// 64-bit FNV-1a.
+inline uint64_t hash_bytes(const void* data, size_t size) {
+  auto* bytes = static_cast<const unsigned char*>(data);
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < size; ++i) {
+    h ^= bytes[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+// Hash of a large buffer, eight bytes at a time. Several times faster than
+// `hash_bytes` but with a weaker mix per step; meant for checksums.
+inline uint64_t hash_words(const void* data, size_t size) {
+  auto* bytes = static_cast<const unsigned char*>(data);
+  uint64_t h = 0xcbf29ce484222325ULL ^ size;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, 8);
+    h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 29;
+  }
+  return hash_mix(h ^ hash_bytes(bytes + i, size - i));
+}
+
+// Hash of a text up to the length of its runs of spaces, i.e. of the
+// sequence of space-separated tokens plus whether a space follows the last
+// token. It is composable: the hash of `a + " " + b` is derived from the
+// hashes of `a` and `b` in O(1), so a tree of text pieces can be hashed
+// bottom-up with every subtree hashed exactly once. Consecutive pieces must
+// be separated by a space, or their tokens would merge.
+class TokenHash {
+ public:
+  // Appends the tokens of `text`.
+  void append(const char* text, size_t size) {
+    size_t i = 0;
+    while (i < size) {
+      if (text[i] == ' ') {
+        trailing_space_ = true;
+        ++i;
+        continue;
+      }
+      size_t start = i;
+      while (i < size && text[i] != ' ') ++i;
+      append_token(hash_bytes(text + start, i - start));
+    }
+  }
+  void append(const std::string& text) { append(text.data(), text.size()); }
+
+  // Appends a text hashed earlier.
+  void append(const TokenHash& other) {
+    value_ = value_ * other.scale_ + other.value_;
+    scale_ *= other.scale_;
+    if (other.has_tokens_) {
+      has_tokens_ = true;
+      trailing_space_ = other.trailing_space_;
+    } else {
+      trailing_space_ |= other.trailing_space_;
+    }
+  }
+
+  void append_space() { trailing_space_ = true; }
+
+  uint64_t digest() const {
+    return hash_combine(value_, has_tokens_ && trailing_space_);
+  }
+
+ private:
+  // Any odd multiplier keeps `scale_` invertible modulo 2^64.
+  static constexpr uint64_t kBase = 0x9e3779b97f4a7c15ULL;
+
+  void append_token(uint64_t token) {
+    value_ = value_ * kBase + hash_mix(token);
+    scale_ *= kBase;
+    has_tokens_ = true;
+    trailing_space_ = false;
+  }
+
+  uint64_t value_ = 0;
+  uint64_t scale_ = 1;
+  bool has_tokens_ = false;
+  bool trailing_space_ = false;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_HASH__
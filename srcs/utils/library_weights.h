@@ -0,0 +1,154 @@
+#ifndef __UTILS_LIBRARY_WEIGHTS__
+#define __UTILS_LIBRARY_WEIGHTS__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "alias_table.h"
+
+namespace utils {
+
+struct LibraryWeightOptions {
+  // Entries that seldom ran weigh up to 1 + rare_boost times more, so that
+  // new and rare ones get tried.
+  double rare_boost = 1.0;
+  // Bounds of the weight of an entry, before the boost, relative to one
+  // that makes queue entries at the rate of the whole library.
+  double min_weight = 0.1;
+  double max_weight = 10;
+};
+
+// Scores the entries of an IR library by the queue entries made by the
+// mutants that took them, and draws them by score in O(1).
+//
+// The entries of a type are known by their index in the type's list, as
+// `get_ir_from_library` counts them. Lists only grow at the end, so a table
+// built over the first entries stays right for them, while the entries
+// added since are drawn with the weight of a new entry. A type's table is
+// rebuilt once the changes to its entries, new ones included, reach a
+// quarter of it, which keeps the cost of the rebuilds O(1) per change.
+class LibraryWeights {
+ public:
+  LibraryWeights(size_t types, const LibraryWeightOptions& options)
+      : options_(options), types_(types) {}
+
+  // Entry `index` of `type` went into a mutant that was handed to the
+  // fuzzer.
+  void ran(uint32_t type, uint32_t index) {
+    if (Score* score = find(type, index)) {
+      ++score->runs;
+      ++runs_;
+    }
+  }
+  // The mutant became a queue entry.
+  void found(uint32_t type, uint32_t index) {
+    if (Score* score = find(type, index)) {
+      ++score->finds;
+      ++finds_;
+    }
+  }
+
+  // Rebuilds the tables that changed enough. `size(type)` is the number of
+  // entries the type has now. Not to be called while others `sample`.
+  template <typename Size>
+  void refresh(const Size& size) {
+    for (uint32_t type = 0; type < types_.size(); ++type) {
+      TypeWeights& t = types_[type];
+      size_t n = size(type);
+      size_t built = t.table.size();
+      if (n >= built) {
+        size_t changes = t.changes + (n - built);
+        if (changes == 0 || changes < std::max(kMinChanges, built / 4)) {
+          continue;
+        }
+      }
+      rebuild(type, n);
+    }
+  }
+
+  // An index of [0, size) for `u` uniform in [0, 1).
+  size_t sample(uint32_t type, size_t size, double u) const {
+    const AliasTable& table = types_[type].table;
+    size_t built = table.size();
+    if (built == 0 || built > size) {
+      return std::min(size_t(u * size), size - 1);
+    }
+    size_t added = size - built;
+    if (added != 0) {
+      double added_weight = added * weight(Score());
+      double p = added_weight / (added_weight + table.total());
+      if (u < p) return built + std::min(size_t(u / p * added), added - 1);
+      u = (u - p) / (1 - p);
+    }
+    return table.sample(u);
+  }
+
+  // The weight `sample` gives to entry `index` of `type` once its table is
+  // rebuilt.
+  double weight(uint32_t type, size_t index) const {
+    const auto& scores = types_[type].scores;
+    return weight(index < scores.size() ? scores[index] : Score());
+  }
+
+  std::string describe() const {
+    return absl::StrFormat(
+        "library weights: %d entries ran, %d made queue entries, %d tables "
+        "rebuilt",
+        runs_, finds_, rebuilds_);
+  }
+
+ private:
+  struct Score {
+    uint32_t runs = 0;
+    uint32_t finds = 0;
+  };
+  struct TypeWeights {
+    std::vector<Score> scores;
+    AliasTable table;
+    // Runs and finds of the entries since `table` was built.
+    size_t changes = 0;
+  };
+
+  // Types with fewer entries rebuild after this many changes.
+  static constexpr size_t kMinChanges = 16;
+
+  Score* find(uint32_t type, uint32_t index) {
+    if (type >= types_.size()) return nullptr;
+    TypeWeights& t = types_[type];
+    if (index >= t.scores.size()) t.scores.resize(size_t(index) + 1);
+    ++t.changes;
+    return &t.scores[index];
+  }
+
+  // The finds of an entry over those expected at the rate of the library,
+  // both plus one so that an entry needs evidence to move off 1.
+  double weight(const Score& score) const {
+    double rate = (finds_ + 1.0) / (runs_ + 100.0);
+    double yield = (score.finds + 1.0) / (score.runs * rate + 1.0);
+    double boost = 1 + options_.rare_boost / (score.runs + 1.0);
+    return std::clamp(yield, options_.min_weight, options_.max_weight) * boost;
+  }
+
+  void rebuild(uint32_t type, size_t size) {
+    TypeWeights& t = types_[type];
+    std::vector<double> weights(size);
+    for (size_t i = 0; i < size; ++i) weights[i] = weight(type, i);
+    t.table.build(weights);
+    t.changes = 0;
+    ++rebuilds_;
+  }
+
+  LibraryWeightOptions options_;
+  std::vector<TypeWeights> types_;
+  uint64_t runs_ = 0;
+  uint64_t finds_ = 0;
+  uint64_t rebuilds_ = 0;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_LIBRARY_WEIGHTS__
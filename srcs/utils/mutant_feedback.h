@@ -0,0 +1,66 @@
+#ifndef __UTILS_MUTANT_FEEDBACK__
+#define __UTILS_MUTANT_FEEDBACK__
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "mutation_trace.h"
+#include "operator_schedule.h"
+
+namespace utils {
+
+// What made a mutant, for what AFL++ tells of it: the operator and the type
+// of the node it mutated, and the library entries it took.
+struct MutantOrigin {
+  uint32_t node_type = 0;
+  MutationOperator op = MutationOperator::kInsert;
+  std::vector<LibraryPick> library;
+
+  static MutantOrigin of(const MutationTrace& trace) {
+    return {trace.node_type, mutation_operator(trace), trace.library};
+  }
+};
+
+// The origins of the last mutants handed to the fuzzer, by the hash of
+// their text. AFL++ reports a queue entry right after running it, but the
+// mutants of a batch or of `mutant_pipeline` are handed out ahead of their
+// run, so more than the last one are kept.
+class RecentMutants {
+ public:
+  static constexpr size_t kDefaultCapacity = 4096;
+
+  explicit RecentMutants(size_t capacity = kDefaultCapacity)
+      : entries_(capacity) {}
+
+  void add(uint64_t mutant, MutantOrigin origin) {
+    entries_[next_] = {mutant, std::move(origin)};
+    next_ = (next_ + 1) % entries_.size();
+  }
+
+  // Moves the origin of `mutant` to `origin` if it is still remembered. A
+  // mutant is only taken once, since AFL++ keeps a test case once.
+  bool take(uint64_t mutant, MutantOrigin* origin) {
+    for (auto& entry : entries_) {
+      if (entry.mutant == 0 || entry.mutant != mutant) continue;
+      *origin = std::move(entry.origin);
+      entry.mutant = 0;
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  struct Entry {
+    uint64_t mutant = 0;
+    MutantOrigin origin;
+  };
+
+  std::vector<Entry> entries_;
+  size_t next_ = 0;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_MUTANT_FEEDBACK__
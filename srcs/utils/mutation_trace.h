@@ -0,0 +1,287 @@
+#ifndef __UTILS_MUTATION_TRACE__
+#define __UTILS_MUTATION_TRACE__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "hash.h"
+
+namespace utils {
+
+// The strategies of `make_variants`, in the order it tries them.
+enum class MutationStrategy : uint8_t { kDelete, kInsert, kReplace };
+
+// How `validate` checked a mutant: by the productions alone, or by parsing
+// it again, which may change the tree.
+enum class CheckPath : uint8_t { kUnknown, kGrammar, kReparse };
+
+// An entry taken from the IR library for a type, and the number of entries
+// the type had, which decides the draw of the index.
+struct LibraryPick {
+  // The index of an entry generated on the spot, and of one served by the
+  // generated trees memoized for the type, see utils::GenerateOptions.
+  static constexpr uint32_t kGenerated = UINT32_MAX;
+  static constexpr uint32_t kMemoized = UINT32_MAX - 1;
+
+  uint32_t type = 0;
+  uint32_t index = 0;
+  uint32_t size = 0;
+  // For a generated entry, the seed it was generated from.
+  uint64_t tree_seed = 0;
+  // For an entry of the library, the digest of its subtree, which tells
+  // whether the library still holds it at `index`.
+  uint64_t hash = 0;
+
+  bool generated() const { return index == kGenerated || index == kMemoized; }
+  // Whether both took the same subtree, even if the library has grown in
+  // between.
+  bool same_entry(const LibraryPick& other) const {
+    return type == other.type && index == other.index &&
+           tree_seed == other.tree_seed && hash == other.hash;
+  }
+  bool operator==(const LibraryPick& other) const {
+    return same_entry(other) && size == other.size;
+  }
+  bool operator!=(const LibraryPick& other) const { return !(*this == other); }
+};
+
+// How one mutant was made. The draws that mutate node `node` of a seed come
+// from a generator of their own, seeded by `round` and `node`, and those that
+// validate one of its variants from one seeded by the strategy as well. Given
+// the seed and the same library, a mutant is thus made again on its own,
+// without the rest of the round, see DataBase::replay.
+struct MutationTrace {
+  // utils::hash_bytes of the seed, without its own trace.
+  uint64_t seed_hash = 0;
+  // Drawn from the Mutator's generator for each seed mutated.
+  uint64_t round = 0;
+  // The index of the mutated node in the IR collector of the seed.
+  uint32_t node = 0;
+  MutationStrategy strategy = MutationStrategy::kDelete;
+  CheckPath check = CheckPath::kUnknown;
+  // The library entries the strategy took, in order.
+  std::vector<LibraryPick> library;
+  // Not encoded, since `replay` makes them again: the type of the mutated
+  // node, and the children MUTATESTART changed, 0 left, 1 right or 2 both.
+  uint32_t node_type = 0;
+  uint8_t side = 0;
+
+  static uint64_t node_seed(uint64_t round, uint32_t node) {
+    return hash_combine(round, node);
+  }
+  uint64_t node_seed() const { return node_seed(round, node); }
+  uint64_t validate_seed() const {
+    return hash_combine(node_seed(), 1 + static_cast<uint64_t>(strategy));
+  }
+  // Whether the mutant holds a generated subtree.
+  bool generated() const {
+    return std::any_of(library.begin(), library.end(),
+                       [](const LibraryPick& pick) { return pick.generated(); });
+  }
+  // Whether `library` took the subtrees of this trace, so that the mutant
+  // made with it is the same.
+  bool same_entries(const std::vector<LibraryPick>& other) const {
+    return std::equal(library.begin(), library.end(), other.begin(),
+                      other.end(),
+                      [](const LibraryPick& a, const LibraryPick& b) {
+                        return a.same_entry(b);
+                      });
+  }
+
+  // One line, e.g. "seed=1f.. round=9a.. node=12 strategy=replace
+  // check=grammar library=84:3/40@c1..,84:g5e../0,84:m07../0".
+  std::string encode() const {
+    std::string result = absl::StrFormat(
+        "seed=%016x round=%016x node=%d strategy=%s check=%s library=",
+        seed_hash, round, node, strategy_name(strategy), check_name(check));
+    for (size_t i = 0; i < library.size(); ++i) {
+      const LibraryPick& pick = library[i];
+      if (i != 0) result += ',';
+      if (pick.generated()) {
+        absl::StrAppendFormat(
+            &result, "%d:%c%016x/%d", pick.type,
+            pick.index == LibraryPick::kGenerated ? 'g' : 'm', pick.tree_seed,
+            pick.size);
+      } else {
+        absl::StrAppendFormat(&result, "%d:%d/%d@%016x", pick.type,
+                              pick.index, pick.size, pick.hash);
+      }
+    }
+    return result;
+  }
+
+  // Parses the output of `encode`. Returns false if it is malformed.
+  static bool decode(std::string_view text, MutationTrace* trace) {
+    *trace = MutationTrace();
+    int fields = 0;
+    for (std::string_view field : split(text, ' ')) {
+      size_t equal = field.find('=');
+      if (equal == std::string_view::npos) return false;
+      std::string_view key = field.substr(0, equal);
+      std::string value(field.substr(equal + 1));
+      if (key == "seed") {
+        if (!parse_number(value, 16, &trace->seed_hash)) return false;
+      } else if (key == "round") {
+        if (!parse_number(value, 16, &trace->round)) return false;
+      } else if (key == "node") {
+        uint64_t node;
+        if (!parse_number(value, 10, &node)) return false;
+        trace->node = node;
+      } else if (key == "strategy") {
+        if (!parse_strategy(value, &trace->strategy)) return false;
+      } else if (key == "check") {
+        if (!parse_check(value, &trace->check)) return false;
+      } else if (key == "library") {
+        if (!parse_library(value, &trace->library)) return false;
+      } else {
+        return false;
+      }
+      ++fields;
+    }
+    return fields == 6;
+  }
+
+  static const char* strategy_name(MutationStrategy strategy) {
+    switch (strategy) {
+      case MutationStrategy::kDelete:
+        return "delete";
+      case MutationStrategy::kInsert:
+        return "insert";
+      case MutationStrategy::kReplace:
+        return "replace";
+    }
+    return "?";
+  }
+  static const char* check_name(CheckPath check) {
+    switch (check) {
+      case CheckPath::kUnknown:
+        return "unknown";
+      case CheckPath::kGrammar:
+        return "grammar";
+      case CheckPath::kReparse:
+        return "reparse";
+    }
+    return "?";
+  }
+
+ private:
+  // The non-empty pieces of `text` between `separator`s.
+  static std::vector<std::string_view> split(std::string_view text,
+                                             char separator) {
+    std::vector<std::string_view> result;
+    while (!text.empty()) {
+      size_t end = std::min(text.find(separator), text.size());
+      if (end != 0) result.push_back(text.substr(0, end));
+      text.remove_prefix(std::min(end + 1, text.size()));
+    }
+    return result;
+  }
+  static bool parse_number(const std::string& text, int base,
+                           uint64_t* value) {
+    if (text.empty()) return false;
+    char* end;
+    *value = std::strtoull(text.c_str(), &end, base);
+    return *end == '\0';
+  }
+  static bool parse_strategy(const std::string& text,
+                             MutationStrategy* strategy) {
+    for (auto candidate : {MutationStrategy::kDelete, MutationStrategy::kInsert,
+                           MutationStrategy::kReplace}) {
+      if (text == strategy_name(candidate)) {
+        *strategy = candidate;
+        return true;
+      }
+    }
+    return false;
+  }
+  static bool parse_check(const std::string& text, CheckPath* check) {
+    for (auto candidate :
+         {CheckPath::kUnknown, CheckPath::kGrammar, CheckPath::kReparse}) {
+      if (text == check_name(candidate)) {
+        *check = candidate;
+        return true;
+      }
+    }
+    return false;
+  }
+  static bool parse_library(const std::string& text,
+                            std::vector<LibraryPick>* library) {
+    for (std::string_view item : split(text, ',')) {
+      size_t colon = item.find(':');
+      size_t slash = item.find('/');
+      if (colon == std::string_view::npos || slash == std::string_view::npos ||
+          slash < colon) {
+        return false;
+      }
+      // Only an entry of the library has a hash, after the size.
+      size_t at = item.find('@', slash);
+      uint64_t type, index, size, tree_seed = 0, hash = 0;
+      std::string index_text(item.substr(colon + 1, slash - colon - 1));
+      std::string size_text(item.substr(slash + 1, at - slash - 1));
+      if (!parse_number(std::string(item.substr(0, colon)), 10, &type) ||
+          !parse_number(size_text, 10, &size)) {
+        return false;
+      }
+      char kind = index_text.empty() ? '\0' : index_text[0];
+      if (kind == 'g' || kind == 'm') {
+        index = kind == 'g' ? LibraryPick::kGenerated : LibraryPick::kMemoized;
+        if (!parse_number(index_text.substr(1), 16, &tree_seed) ||
+            at != std::string_view::npos) {
+          return false;
+        }
+      } else if (!parse_number(index_text, 10, &index) ||
+                 at == std::string_view::npos ||
+                 !parse_number(std::string(item.substr(at + 1)), 16, &hash)) {
+        return false;
+      }
+      library->push_back({uint32_t(type), uint32_t(index), uint32_t(size),
+                          tree_seed, hash});
+    }
+    return true;
+  }
+};
+
+// With `mutation_trace`, every mutant starts with its trace in a comment,
+// so that the queue and crash entries saved by AFL++ carry it. The parsers
+// do not take comments, so it is stripped before parsing.
+inline constexpr std::string_view kTraceBegin = "/* squirrel trace: ";
+inline constexpr std::string_view kTraceEnd = " */\n";
+
+inline std::string add_trace(const MutationTrace& trace,
+                             std::string_view mutant) {
+  std::string result(kTraceBegin);
+  result += trace.encode();
+  result += kTraceEnd;
+  result += mutant;
+  return result;
+}
+
+// Returns `test_case` without its trace, and the trace in `trace`, or an
+// empty one if there is none.
+inline std::string_view strip_trace(std::string_view test_case,
+                                    std::string_view* trace = nullptr) {
+  if (trace != nullptr) *trace = std::string_view();
+  if (test_case.substr(0, kTraceBegin.size()) != kTraceBegin) {
+    return test_case;
+  }
+  size_t end = test_case.find(kTraceEnd, kTraceBegin.size());
+  if (end == std::string_view::npos) return test_case;
+  if (trace != nullptr) {
+    *trace = test_case.substr(kTraceBegin.size(), end - kTraceBegin.size());
+  }
+  return test_case.substr(end + kTraceEnd.size());
+}
+
+inline uint64_t seed_hash(std::string_view seed) {
+  seed = strip_trace(seed);
+  return hash_bytes(seed.data(), seed.size());
+}
+
+};  // namespace utils
+
+#endif  // __UTILS_MUTATION_TRACE__
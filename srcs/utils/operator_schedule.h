@@ -0,0 +1,281 @@
+#ifndef __UTILS_OPERATOR_SCHEDULE__
+#define __UTILS_OPERATOR_SCHEDULE__
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "mutation_trace.h"
+#include "rng.h"
+
+namespace utils {
+
+// The mutation operators the scheduler tells apart: the strategies of
+// `make_variants`, with the children MUTATESTART changed for the two that
+// pick them.
+enum class MutationOperator : uint8_t {
+  kDeleteLeft,
+  kDeleteRight,
+  kDeleteBoth,
+  kInsert,
+  kReplaceLeft,
+  kReplaceRight,
+  kReplaceBoth,
+};
+inline constexpr size_t kMutationOperators = 7;
+
+inline MutationOperator mutation_operator(MutationStrategy strategy,
+                                          uint8_t side) {
+  switch (strategy) {
+    case MutationStrategy::kDelete:
+      return MutationOperator(side);
+    case MutationStrategy::kInsert:
+      return MutationOperator::kInsert;
+    case MutationStrategy::kReplace:
+      return MutationOperator(4 + side);
+  }
+  return MutationOperator::kInsert;
+}
+
+inline MutationOperator mutation_operator(const MutationTrace& trace) {
+  return mutation_operator(trace.strategy, trace.side);
+}
+
+inline const char* operator_name(MutationOperator op) {
+  static constexpr const char* kNames[kMutationOperators] = {
+      "delete-left",  "delete-right",  "delete-both", "insert",
+      "replace-left", "replace-right", "replace-both"};
+  return kNames[size_t(op)];
+}
+
+struct ScheduleOptions {
+  // Mutants run between two updates of the probabilities.
+  uint32_t period = 5000;
+  // Bounds of the probability of an operator, so that none starves.
+  double min_probability = 0.02;
+  double max_probability = 0.6;
+  // How many runs of an operator on a node type weigh as much as its rate
+  // on all types, when estimating its rate on that type.
+  double prior_runs = 64;
+};
+
+// Learns which operators make mutants that AFL++ keeps, and samples them
+// accordingly, in the manner of MOpt (Lyu et al., USENIX Security 2019).
+//
+// `make_variants` tries its strategies in turn, with uniform children. It
+// draws the operator of each before building the variant, and `keep` tells
+// whether to build it, with a probability that turns that mix into the
+// learned one, `probability`, adjusted by the rate of the operator on the
+// type of the mutated node. The learned mix starts as the nominal one, so
+// nothing is skipped until there is evidence.
+//
+// Every `period` runs, the mix moves like a particle of MOpt's swarm:
+// towards the mix under which each operator did best over a period, and
+// towards the rates of the operators over the whole run.
+class OperatorScheduler {
+ public:
+  OperatorScheduler(size_t node_types, const ScheduleOptions& options,
+                    uint64_t seed)
+      : options_(options), by_type_(node_types), rng_(seed) {
+    probability_ = kNominal;
+    local_best_ = kNominal;
+  }
+
+  void seed(uint64_t seed) { rng_.seed(seed); }
+
+  // Whether to make a mutant with `op` on a node of type `type`, given
+  // `uniform`, drawn from [0, 1) by the caller. The mutator calls it from
+  // several threads at once, which is safe as long as `ran` and `found`
+  // are not called meanwhile.
+  bool keep(uint32_t type, MutationOperator op, double uniform) {
+    double best = 0;
+    for (size_t o = 0; o < kMutationOperators; ++o) {
+      best = std::max(best, weight(type, o));
+    }
+    if (best <= 0 || uniform * best < weight(type, size_t(op))) {
+      return true;
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // A mutant that `op` made on a node of type `type` is handed to the
+  // fuzzer. Returns true if the probabilities were updated.
+  bool ran(uint32_t type, MutationOperator op) {
+    size_t o = size_t(op);
+    ++total_[o].runs;
+    ++period_[o].runs;
+    if (type < by_type_.size()) ++by_type_[type][o].runs;
+    if (++period_runs_ < options_.period) return false;
+    update();
+    return true;
+  }
+
+  // That mutant became a queue entry.
+  void found(uint32_t type, MutationOperator op) {
+    size_t o = size_t(op);
+    ++total_[o].finds;
+    ++period_[o].finds;
+    if (type < by_type_.size()) ++by_type_[type][o].finds;
+  }
+
+  double probability(MutationOperator op) const {
+    return probability_[size_t(op)];
+  }
+  uint64_t updates() const { return updates_; }
+  uint64_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  // The learned mix, as one line of text.
+  std::string describe() const {
+    std::string result = absl::StrFormat(
+        "operators (%d updates, %d mutants skipped):", updates_, dropped());
+    for (size_t o = 0; o < kMutationOperators; ++o) {
+      absl::StrAppendFormat(&result, " %s %.3f %d/%d",
+                            operator_name(MutationOperator(o)),
+                            probability_[o], total_[o].finds, total_[o].runs);
+    }
+    return result;
+  }
+
+  // The learned mix and the finds and runs of every operator, overall and
+  // by node type, one line each.
+  std::string dump(
+      const std::function<std::string(uint32_t)>& type_name) const {
+    std::string result = absl::StrFormat("# updates %d\n# operator", updates_);
+    for (size_t o = 0; o < kMutationOperators; ++o) {
+      absl::StrAppendFormat(&result, " %s", operator_name(MutationOperator(o)));
+    }
+    result += "\nprobability";
+    for (double p : probability_) absl::StrAppendFormat(&result, " %.4f", p);
+    result += "\nall";
+    for (const Counts& counts : total_) {
+      absl::StrAppendFormat(&result, " %d/%d", counts.finds, counts.runs);
+    }
+    result += '\n';
+    for (size_t type = 0; type < by_type_.size(); ++type) {
+      const auto& counts = by_type_[type];
+      if (std::all_of(counts.begin(), counts.end(),
+                      [](const Counts& c) { return c.runs == 0; })) {
+        continue;
+      }
+      result += type_name(type);
+      for (const Counts& c : counts) {
+        absl::StrAppendFormat(&result, " %d/%d", c.finds, c.runs);
+      }
+      result += '\n';
+    }
+    return result;
+  }
+
+  // Writes `dump` to `path`, through a temporary file so that readers never
+  // see half of it.
+  bool save(const std::string& path,
+            const std::function<std::string(uint32_t)>& type_name) const {
+    std::string temporary = path + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "w");
+    if (file == nullptr) return false;
+    std::string text = dump(type_name);
+    bool written =
+        std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    written = std::fclose(file) == 0 && written;
+    return written && std::rename(temporary.c_str(), path.c_str()) == 0;
+  }
+
+ private:
+  struct Counts {
+    uint64_t runs = 0;
+    uint64_t finds = 0;
+  };
+  using Mix = std::array<double, kMutationOperators>;
+
+  // The mix of uniform children: MUTATESTART picks one of three for delete
+  // and replace, while insert has none.
+  static constexpr Mix kNominal = {1.0 / 9, 1.0 / 9, 1.0 / 9, 1.0 / 3,
+                                   1.0 / 9, 1.0 / 9, 1.0 / 9};
+  // Updates over which the inertia of the mix decays, as in MOpt.
+  static constexpr double kInertiaUpdates = 50;
+
+  // The rate of `o` over the run, with one find spread over the operators
+  // so that it is never 0.
+  double rate(size_t o) const {
+    return (total_[o].finds + 1.0 / kMutationOperators) / (total_[o].runs + 1);
+  }
+
+  // The relative chance to keep a mutant of `o` on `type`.
+  double weight(uint32_t type, size_t o) const {
+    double w = probability_[o] / kNominal[o];
+    if (type >= by_type_.size()) return w;
+    const Counts& counts = by_type_[type][o];
+    if (counts.runs == 0 || total_[o].finds == 0) return w;
+    double overall = double(total_[o].finds) / total_[o].runs;
+    double on_type = (counts.finds + options_.prior_runs * overall) /
+                     (counts.runs + options_.prior_runs);
+    return w * on_type / overall;
+  }
+
+  void update() {
+    period_runs_ = 0;
+    ++updates_;
+    // Without a single find, there is nothing to learn from yet.
+    if (std::all_of(total_.begin(), total_.end(),
+                    [](const Counts& c) { return c.finds == 0; })) {
+      period_ = {};
+      return;
+    }
+    Mix global;
+    double rates = 0;
+    for (size_t o = 0; o < kMutationOperators; ++o) {
+      global[o] = rate(o);
+      rates += global[o];
+    }
+    double inertia =
+        0.9 - 0.6 * std::min(1.0, (updates_ - 1) / kInertiaUpdates);
+    for (size_t o = 0; o < kMutationOperators; ++o) {
+      global[o] /= rates;
+      if (period_[o].runs != 0) {
+        double efficiency = double(period_[o].finds) / period_[o].runs;
+        if (efficiency > best_efficiency_[o]) {
+          best_efficiency_[o] = efficiency;
+          local_best_[o] = probability_[o];
+        }
+      }
+      velocity_[o] = inertia * velocity_[o] +
+                     rng_.uniform() * (local_best_[o] - probability_[o]) +
+                     rng_.uniform() * (global[o] - probability_[o]);
+      probability_[o] =
+          std::clamp(probability_[o] + velocity_[o], options_.min_probability,
+                     options_.max_probability);
+    }
+    double sum = 0;
+    for (double p : probability_) sum += p;
+    for (double& p : probability_) p /= sum;
+
+    period_ = {};
+  }
+
+  ScheduleOptions options_;
+  Mix probability_;
+  Mix velocity_ = {};
+  Mix local_best_;
+  Mix best_efficiency_ = {};
+  std::array<Counts, kMutationOperators> total_ = {};
+  std::array<Counts, kMutationOperators> period_ = {};
+  uint64_t period_runs_ = 0;
+  uint64_t updates_ = 0;
+  std::atomic<uint64_t> dropped_{0};
+  std::vector<std::array<Counts, kMutationOperators>> by_type_;
+  Rng rng_;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_OPERATOR_SCHEDULE__
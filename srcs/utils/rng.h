@@ -0,0 +1,103 @@
+#ifndef __UTILS_RNG__
+#define __UTILS_RNG__
+
+#include <cstdint>
+#include <random>
+#include <type_traits>
+
+namespace utils {
+
+// A xoshiro256** generator, which is much faster than rand(), takes no lock
+// and, unlike rand(), can be given to one owner: each Mutator has its own,
+// seeded from AFL++, so that a run with a fixed `-s` makes the same mutants.
+class Rng {
+ public:
+  // Seeded at random, like rand() after srand(time(nullptr)).
+  Rng() {
+    std::random_device device;
+    seed(uint64_t(device()) << 32 ^ device());
+  }
+  explicit Rng(uint64_t seed) { this->seed(seed); }
+
+  // The state is filled by splitmix64, so that similar seeds, e.g. those
+  // of the workers of a ThreadPool, still give unrelated sequences.
+  void seed(uint64_t seed) {
+    for (uint64_t& word : state_) {
+      uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      word = z ^ (z >> 31);
+    }
+  }
+
+  uint64_t next() {
+    uint64_t result = rotl(state_[1] * 5, 7) * 9;
+    uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = rotl(state_[3], 45);
+    return result;
+  }
+
+  // A uniform draw from [0, range), or 0 if `range` is 0. Lemire's
+  // multiply-and-shift, which rejects the few draws that would make the
+  // low values more likely, as `next() % range` does.
+  uint64_t below(uint64_t range) {
+    __uint128_t product = __uint128_t(next()) * range;
+    uint64_t low = uint64_t(product);
+    if (low < range) {
+      uint64_t threshold = -range % range;
+      while (low < threshold) {
+        product = __uint128_t(next()) * range;
+        low = uint64_t(product);
+      }
+    }
+    return uint64_t(product >> 64);
+  }
+
+  // A uniform draw from [0, 1), from the top 53 bits of `next()`.
+  double uniform() { return (next() >> 11) * 0x1.0p-53; }
+
+ private:
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  uint64_t state_[4];
+};
+
+// The generator the calling thread draws from, or nullptr for the default
+// one of the thread. A dialect sets its Mutator's for the duration of a call
+// with RngScope, and worker threads of a ThreadPool have their own.
+inline thread_local Rng* g_current_rng = nullptr;
+
+inline Rng& current_rng() {
+  if (g_current_rng != nullptr) return *g_current_rng;
+  thread_local Rng default_rng;
+  return default_rng;
+}
+
+// Makes `rng` the one of the calling thread until the end of the scope.
+class RngScope {
+ public:
+  explicit RngScope(Rng* rng) : saved_(g_current_rng) { g_current_rng = rng; }
+  RngScope(const RngScope&) = delete;
+  RngScope& operator=(const RngScope&) = delete;
+  ~RngScope() { g_current_rng = saved_; }
+
+ private:
+  Rng* saved_;
+};
+
+// A uniform draw from [0, range) of the current generator, of the type of
+// `range`, like `rand() % range` was.
+template <typename T>
+inline T rand_below(T range) {
+  static_assert(std::is_integral_v<T>, "range must be an integer");
+  return static_cast<T>(current_rng().below(static_cast<uint64_t>(range)));
+}
+
+};  // namespace utils
+
+#endif  // __UTILS_RNG__
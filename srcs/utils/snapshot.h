@@ -0,0 +1,273 @@
+#ifndef __UTILS_SNAPSHOT__
+#define __UTILS_SNAPSHOT__
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "hash.h"
+
+namespace utils {
+
+// Binary snapshots of the mutator state. A snapshot is a fixed header
+// followed by a payload of little-endian fields written back to back:
+// scalars as their raw bytes, strings and containers as a 32-bit length
+// followed by their elements. The header names the dialect and the number of
+// node types it was written with, so a snapshot from another grammar is
+// rejected instead of being misread.
+struct SnapshotHeader {
+  static constexpr char kMagic[8] = {'S', 'Q', 'R', 'L', 'L', 'I', 'B', '\0'};
+  static constexpr uint32_t kVersion = 2;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t node_type_count;
+  char dialect[16];
+  uint64_t payload_size;
+  uint64_t payload_hash;
+};
+
+// `count` fixed-size records stored back to back inside a payload, read in
+// place. The payload is not aligned, so records are copied out one at a time.
+template <typename T>
+class RecordView {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>);
+
+  RecordView() = default;
+  RecordView(const char* data, size_t count) : data_(data), count_(count) {}
+
+  T operator[](size_t i) const {
+    T record;
+    std::memcpy(&record, data_ + i * sizeof(T), sizeof(T));
+    return record;
+  }
+  size_t size() const { return count_; }
+  bool empty() const { return count_ == 0; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t count_ = 0;
+};
+
+class SnapshotWriter {
+ public:
+  template <typename T>
+  std::enable_if_t<std::is_trivially_copyable_v<T>> put(const T& value) {
+    buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  void put(const std::string& value) {
+    put(static_cast<uint32_t>(value.size()));
+    buffer_.append(value);
+  }
+  template <typename T>
+  void put(const std::vector<T>& values) {
+    put(static_cast<uint32_t>(values.size()));
+    for (auto& value : values) put(value);
+  }
+  template <typename T>
+  void put(const std::set<T>& values) {
+    put(static_cast<uint32_t>(values.size()));
+    for (auto& value : values) put(value);
+  }
+  template <typename K, typename V>
+  void put(const std::map<K, V>& values) {
+    put(static_cast<uint32_t>(values.size()));
+    for (auto& [key, value] : values) {
+      put(key);
+      put(value);
+    }
+  }
+  // Same layout as `put(values)`, in one copy; read back as a RecordView.
+  template <typename T>
+  void put_records(const std::vector<T>& values) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    put(static_cast<uint32_t>(values.size()));
+    buffer_.append(reinterpret_cast<const char*>(values.data()),
+                   values.size() * sizeof(T));
+  }
+
+  // Writes the header and the payload to `path`. The file is written under a
+  // temporary name and renamed into place, so readers never see half of it.
+  bool write_file(const std::string& path, std::string_view dialect,
+                  uint32_t node_type_count) const {
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SnapshotHeader::kMagic, sizeof(header.magic));
+    header.version = SnapshotHeader::kVersion;
+    header.node_type_count = node_type_count;
+    dialect.copy(header.dialect, sizeof(header.dialect) - 1);
+    header.payload_size = buffer_.size();
+    header.payload_hash = hash_words(buffer_.data(), buffer_.size());
+
+    std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+    FILE* file = std::fopen(tmp_path.c_str(), "wb");
+    if (file == nullptr) return false;
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(buffer_.data(), 1, buffer_.size(), file) ==
+                  buffer_.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (ok) ok = std::rename(tmp_path.c_str(), path.c_str()) == 0;
+    if (!ok) std::remove(tmp_path.c_str());
+    return ok;
+  }
+
+  size_t size() const { return buffer_.size(); }
+  // The payload written so far, e.g. to embed it in another file.
+  const std::string& payload() const { return buffer_; }
+
+ private:
+  std::string buffer_;
+};
+
+// Reads a snapshot straight from a read-only mapping of the file. Every
+// `get` checks the bounds of the payload; after the first failure `ok()`
+// turns false and the remaining reads return nothing.
+class SnapshotReader {
+ public:
+  SnapshotReader() = default;
+  SnapshotReader(const SnapshotReader&) = delete;
+  SnapshotReader& operator=(const SnapshotReader&) = delete;
+  ~SnapshotReader() {
+    if (base_ != nullptr) munmap(base_, mapped_size_);
+  }
+
+  // Maps `path` and validates its header and checksum.
+  bool open(const std::string& path, std::string_view dialect,
+            uint32_t node_type_count) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || size_t(sb.st_size) < sizeof(SnapshotHeader)) {
+      close(fd);
+      return false;
+    }
+    mapped_size_ = sb.st_size;
+    void* base = mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return false;
+    base_ = base;
+
+    SnapshotHeader header;
+    std::memcpy(&header, base_, sizeof(header));
+    cursor_ = static_cast<const char*>(base_) + sizeof(header);
+    end_ = static_cast<const char*>(base_) + mapped_size_;
+    ok_ = std::memcmp(header.magic, SnapshotHeader::kMagic,
+                      sizeof(header.magic)) == 0 &&
+          header.version == SnapshotHeader::kVersion &&
+          header.node_type_count == node_type_count &&
+          dialect == std::string_view(header.dialect,
+                                      strnlen(header.dialect,
+                                              sizeof(header.dialect))) &&
+          header.payload_size == size_t(end_ - cursor_) &&
+          header.payload_hash == hash_words(cursor_, header.payload_size);
+    return ok_;
+  }
+
+  // Reads a bare payload, without header, that lives in memory owned by the
+  // caller.
+  void open_payload(const char* data, size_t size) {
+    cursor_ = data;
+    end_ = data + size;
+    ok_ = true;
+  }
+
+  template <typename T>
+  std::enable_if_t<std::is_trivially_copyable_v<T>, bool> get(T& value) {
+    if (!take(sizeof(value))) return false;
+    std::memcpy(&value, cursor_ - sizeof(value), sizeof(value));
+    return true;
+  }
+  bool get(std::string& value) {
+    uint32_t size;
+    if (!get(size) || !take(size)) return false;
+    value.assign(cursor_ - size, size);
+    return true;
+  }
+  template <typename T>
+  bool get(std::vector<T>& values) {
+    uint32_t size;
+    if (!get(size) || !fits(size)) return false;
+    values.resize(size);
+    for (auto& value : values) {
+      if (!get(value)) return false;
+    }
+    return true;
+  }
+  template <typename T>
+  bool get(std::set<T>& values) {
+    uint32_t size;
+    if (!get(size) || !fits(size)) return false;
+    values.clear();
+    for (uint32_t i = 0; i < size; ++i) {
+      T value;
+      if (!get(value)) return false;
+      values.insert(std::move(value));
+    }
+    return true;
+  }
+  template <typename K, typename V>
+  bool get(std::map<K, V>& values) {
+    uint32_t size;
+    if (!get(size) || !fits(size)) return false;
+    values.clear();
+    for (uint32_t i = 0; i < size; ++i) {
+      K key;
+      if (!get(key) || !get(values[key])) return false;
+    }
+    return true;
+  }
+
+  // Views of the payload stay valid as long as the reader.
+  bool get(std::string_view& value) {
+    uint32_t size;
+    if (!get(size) || !take(size)) return false;
+    value = std::string_view(cursor_ - size, size);
+    return true;
+  }
+  template <typename T>
+  bool get(RecordView<T>& values) {
+    uint32_t count;
+    if (!get(count)) return false;
+    if (size_t(end_ - cursor_) / sizeof(T) < count) return ok_ = false;
+    values = RecordView<T>(cursor_, count);
+    cursor_ += count * sizeof(T);
+    return true;
+  }
+
+  bool ok() const { return ok_; }
+  // Whether the whole payload was consumed without errors.
+  bool done() const { return ok_ && cursor_ == end_; }
+
+ private:
+  bool take(size_t size) {
+    if (!ok_ || size_t(end_ - cursor_) < size) return ok_ = false;
+    cursor_ += size;
+    return true;
+  }
+  // Every element takes at least one byte, which bounds a sane length.
+  bool fits(uint32_t count) {
+    if (!ok_ || size_t(end_ - cursor_) < count) return ok_ = false;
+    return true;
+  }
+
+  void* base_ = nullptr;
+  size_t mapped_size_ = 0;
+  const char* cursor_ = nullptr;
+  const char* end_ = nullptr;
+  bool ok_ = false;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_SNAPSHOT__
@@ -0,0 +1,54 @@
+#ifndef __UTILS_SPARSE_TABLE__
+#define __UTILS_SPARSE_TABLE__
+
+#include <array>
+#include <cstddef>
+#include <memory>
+
+namespace utils {
+
+// An N x N table indexed by a pair of dense enum values, for the many
+// combinations of which only a few are ever used. Rows are allocated on the
+// first write, so a lookup is two array indexings and never allocates.
+template <typename T, size_t N>
+class SparseTable {
+ public:
+  using Row = std::array<T, N>;
+
+  // The cell at (`row`, `col`), created along with its row if needed.
+  T& operator()(size_t row, size_t col) {
+    auto& r = rows_[row];
+    if (r == nullptr) r.reset(new Row());
+    return (*r)[col];
+  }
+
+  // The cell at (`row`, `col`), or nullptr if its row was never written.
+  T* find(size_t row, size_t col) {
+    auto& r = rows_[row];
+    return r ? &(*r)[col] : nullptr;
+  }
+  const T* find(size_t row, size_t col) const {
+    auto& r = rows_[row];
+    return r ? &(*r)[col] : nullptr;
+  }
+
+  // Calls `f(cell)` for every cell of every allocated row.
+  template <typename F>
+  void for_each(F&& f) {
+    for (auto& r : rows_) {
+      if (r == nullptr) continue;
+      for (auto& cell : *r) f(cell);
+    }
+  }
+
+  void clear() {
+    for (auto& r : rows_) r.reset();
+  }
+
+ private:
+  std::array<std::unique_ptr<Row>, N> rows_;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_SPARSE_TABLE__
@@ -0,0 +1,78 @@
+#ifndef __UTILS_SPSC_RING__
+#define __UTILS_SPSC_RING__
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+// A bounded lock-free queue between exactly one producer thread and one
+// consumer thread. Each side owns one index and only reads the other's when
+// its cached copy says the ring is full or empty, so an uncontended push or
+// pop touches no shared cache line but the slot itself.
+template <typename T>
+class SpscRing {
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit SpscRing(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    slots_.resize(size);
+    mask_ = size - 1;
+  }
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  // Producer side. Moves `value` in, unless the ring is full, in which case
+  // `value` is left untouched and false is returned.
+  bool try_push(T& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ == slots_.size()) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ == slots_.size()) return false;
+    }
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Moves the oldest element into `value`, unless the ring is
+  // empty.
+  bool try_pop(T& value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) return false;
+    }
+    value = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // The number of elements in the ring. Exact on the consumer side as a
+  // lower bound, on the producer side as an upper bound.
+  size_t size() const {
+    size_t head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+  }
+  bool empty() const { return size() == 0; }
+  size_t capacity() const { return slots_.size(); }
+
+ private:
+  static constexpr size_t kCacheLine = 64;
+
+  std::vector<T> slots_;
+  size_t mask_ = 0;
+  // Written by the consumer.
+  alignas(kCacheLine) std::atomic<size_t> head_{0};
+  size_t tail_cache_ = 0;
+  // Written by the producer.
+  alignas(kCacheLine) std::atomic<size_t> tail_{0};
+  size_t head_cache_ = 0;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_SPSC_RING__
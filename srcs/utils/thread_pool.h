@@ -0,0 +1,140 @@
+#ifndef __UTILS_THREAD_POOL__
+#define __UTILS_THREAD_POOL__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "arena.h"
+#include "rng.h"
+
+namespace utils {
+
+// A fixed set of threads that runs batches of independent tasks, e.g. one
+// batch per seed mutated. The thread that calls `run` works on the batch as
+// well, so a pool of size 1 has no threads of its own and runs every task
+// inline, in order.
+//
+// Each worker thread has an Arena of its own. While the caller of `run` has a
+// current arena, workers allocate from theirs, which keeps what the tasks
+// build alive until `reset_arenas()`; otherwise they use the heap like the
+// caller. Each worker also draws from its own generator, see `current_rng`,
+// seeded by the caller's at the start of every batch.
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t size) {
+    size_t workers = size > 1 ? size - 1 : 0;
+    arenas_.reserve(workers);
+    rngs_.resize(workers);
+    for (size_t i = 0; i < workers; ++i) {
+      arenas_.push_back(std::make_unique<Arena>());
+    }
+    threads_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+      threads_.emplace_back([this, i] { work(i); });
+    }
+  }
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    start_.notify_all();
+    for (auto& thread : threads_) thread.join();
+  }
+
+  // The number of threads that run tasks, the caller of `run` included.
+  size_t size() const { return threads_.size() + 1; }
+
+  // Calls `f(i)` for every i in [0, count), on any thread of the pool, and
+  // returns once every call is done. Tasks must not call `run` themselves.
+  void run(size_t count, const std::function<void(size_t)>& f) {
+    if (threads_.empty() || count <= 1) {
+      for (size_t i = 0; i < count; ++i) f(i);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &f;
+      count_ = count;
+      next_.store(0, std::memory_order_relaxed);
+      use_arenas_ = g_current_arena != nullptr;
+      // So that the caller's seed still decides every draw.
+      for (WorkerRng& worker : rngs_) worker.rng.seed(current_rng().next());
+      busy_ = threads_.size();
+      ++generation_;
+    }
+    start_.notify_all();
+    drain();
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return busy_ == 0; });
+    task_ = nullptr;
+  }
+
+  // Forgets everything the workers allocated in their arenas.
+  void reset_arenas() {
+    for (auto& arena : arenas_) arena->reset();
+  }
+
+ private:
+  void work(size_t worker) {
+    g_current_rng = &rngs_[worker].rng;
+    uint64_t seen = 0;
+    while (true) {
+      bool use_arena;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) return;
+        seen = generation_;
+        use_arena = use_arenas_;
+      }
+      {
+        ArenaScope scope(use_arena ? arenas_[worker].get() : nullptr);
+        drain();
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--busy_ == 0) done_.notify_one();
+    }
+  }
+
+  // Takes tasks of the current batch until there are none left.
+  void drain() {
+    size_t i;
+    while ((i = next_.fetch_add(1, std::memory_order_relaxed)) < count_) {
+      (*task_)(i);
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::vector<std::unique_ptr<Arena>> arenas_;
+  // A cache line each, as every draw writes the state.
+  struct alignas(64) WorkerRng {
+    Rng rng;
+  };
+  std::vector<WorkerRng> rngs_;
+
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  // The current batch, published to the workers under `mutex_`.
+  const std::function<void(size_t)>* task_ = nullptr;
+  size_t count_ = 0;
+  std::atomic<size_t> next_{0};
+  bool use_arenas_ = false;
+  size_t busy_ = 0;
+  uint64_t generation_ = 0;
+  bool stop_ = false;
+};
+
+};  // namespace utils
+
+#endif  // __UTILS_THREAD_POOL__
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "alias_table.h"
+#include "library_weights.h"
+#include "rng.h"
+
+namespace {
+
+// How often each index of [0, n) is drawn over `draws` uniform draws.
+template <typename Sample>
+std::vector<double> frequencies(size_t n, int draws, const Sample& sample) {
+  utils::Rng rng(7);
+  std::vector<double> counts(n);
+  for (int i = 0; i < draws; ++i) counts[sample(rng.uniform())] += 1;
+  for (double& count : counts) count /= draws;
+  return counts;
+}
+
+}  // namespace
+
+TEST(AliasTableTest, DrawsByWeight) {
+  std::vector<double> weights = {1, 2, 3, 4, 0, 10};
+  utils::AliasTable table(weights);
+  EXPECT_EQ(table.size(), 6u);
+  EXPECT_DOUBLE_EQ(table.total(), 20);
+  auto counts = frequencies(weights.size(), 200000,
+                            [&](double u) { return table.sample(u); });
+  for (size_t i = 0; i < weights.size(); ++i) {
+    EXPECT_NEAR(counts[i], weights[i] / 20, 0.01) << i;
+  }
+  EXPECT_EQ(counts[4], 0);
+}
+
+TEST(AliasTableTest, ZeroWeightsDrawUniformly) {
+  utils::AliasTable table(std::vector<double>(4, 0));
+  auto counts =
+      frequencies(4, 100000, [&](double u) { return table.sample(u); });
+  for (double count : counts) EXPECT_NEAR(count, 0.25, 0.01);
+}
+
+TEST(AliasTableTest, SameDrawSameIndex) {
+  utils::AliasTable table(std::vector<double>{5, 1, 1, 1});
+  EXPECT_EQ(table.sample(0.0), 0u);
+  EXPECT_LT(table.sample(0.999999), 4u);
+  for (double u = 0; u < 1; u += 0.01) {
+    EXPECT_EQ(table.sample(u), table.sample(u));
+  }
+}
+
+TEST(LibraryWeightsTest, UniformBeforeTheFirstBuild) {
+  utils::LibraryWeights weights(2, utils::LibraryWeightOptions());
+  auto counts = frequencies(
+      5, 100000, [&](double u) { return weights.sample(1, 5, u); });
+  for (double count : counts) EXPECT_NEAR(count, 0.2, 0.01);
+}
+
+TEST(LibraryWeightsTest, FavoursEntriesThatFind) {
+  utils::LibraryWeightOptions options;
+  options.rare_boost = 0;
+  utils::LibraryWeights weights(2, options);
+  for (int i = 0; i < 100; ++i) {
+    for (uint32_t index = 0; index < 8; ++index) weights.ran(1, index);
+    if (i % 4 == 0) weights.found(1, 3);
+  }
+  weights.refresh([](uint32_t) { return size_t(8); });
+  EXPECT_GT(weights.weight(1, 3), 2 * weights.weight(1, 0));
+  auto counts = frequencies(
+      8, 100000, [&](double u) { return weights.sample(1, 8, u); });
+  EXPECT_GT(counts[3], 2 * counts[0]);
+  EXPECT_GT(counts[0], 0);
+}
+
+TEST(LibraryWeightsTest, BoostsRareEntries) {
+  utils::LibraryWeightOptions options;
+  options.rare_boost = 3;
+  utils::LibraryWeights weights(1, options);
+  for (int i = 0; i < 50; ++i) weights.ran(0, 0);
+  EXPECT_GT(weights.weight(0, 1), 2 * weights.weight(0, 0));
+}
+
+TEST(LibraryWeightsTest, DrawsEntriesAddedSinceTheBuild) {
+  utils::LibraryWeights weights(1, utils::LibraryWeightOptions());
+  for (int i = 0; i < 20; ++i) weights.ran(0, i % 4);
+  weights.refresh([](uint32_t) { return size_t(4); });
+  // Two more entries, too few to rebuild the table.
+  weights.refresh([](uint32_t) { return size_t(6); });
+  auto counts = frequencies(
+      6, 100000, [&](double u) { return weights.sample(0, 6, u); });
+  EXPECT_GT(counts[4], 0.05);
+  EXPECT_GT(counts[5], 0.05);
+  // A shorter list than the table is drawn uniformly.
+  for (double u = 0; u < 1; u += 0.01) EXPECT_LT(weights.sample(0, 2, u), 2u);
+}
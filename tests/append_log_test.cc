@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "append_log.h"
+
+namespace {
+std::string temp_path(const char* name) {
+  return std::string("/tmp/append_log_test_") + name + "." +
+         std::to_string(getpid());
+}
+
+std::vector<std::string> read_all(const utils::AppendLog& log,
+                                  uint64_t& cursor) {
+  std::vector<std::string> records;
+  log.read(cursor, [&](const char* data, uint32_t size) {
+    records.emplace_back(data, size);
+  });
+  return records;
+}
+};  // namespace
+
+TEST(AppendLogTest, ReadersFollowTheLog) {
+  std::string path = temp_path("follow");
+  utils::AppendLog writer, reader;
+  ASSERT_TRUE(writer.open(path, "mysql", 42, 1024));
+  ASSERT_TRUE(reader.open(path, "mysql", 42));
+  EXPECT_EQ(reader.capacity(), 1024);
+
+  uint64_t cursor = 0;
+  EXPECT_TRUE(read_all(reader, cursor).empty());
+  EXPECT_TRUE(writer.append("select", 6));
+  EXPECT_TRUE(writer.append("x", 1));
+  EXPECT_EQ(read_all(reader, cursor),
+            (std::vector<std::string>{"select", "x"}));
+  EXPECT_TRUE(read_all(reader, cursor).empty());
+  EXPECT_TRUE(writer.append("insert", 6));
+  EXPECT_EQ(read_all(reader, cursor), (std::vector<std::string>{"insert"}));
+  std::remove(path.c_str());
+}
+
+TEST(AppendLogTest, RejectsOtherDialectsAndGrammars) {
+  std::string path = temp_path("header");
+  utils::AppendLog log, other_dialect, other_grammar;
+  ASSERT_TRUE(log.open(path, "mysql", 42, 1024));
+  EXPECT_FALSE(other_dialect.open(path, "postgresql", 42));
+  EXPECT_FALSE(other_grammar.open(path, "mysql", 43));
+  std::remove(path.c_str());
+}
+
+TEST(AppendLogTest, FullLogKeepsItsRecords) {
+  std::string path = temp_path("full");
+  utils::AppendLog log;
+  ASSERT_TRUE(log.open(path, "mysql", 42, 32));
+  // Each record takes 8 bytes of size and 8 of padded data.
+  EXPECT_TRUE(log.append("a", 1));
+  EXPECT_TRUE(log.append("b", 1));
+  EXPECT_FALSE(log.append("c", 1));
+  EXPECT_FALSE(log.append("d", 1));
+
+  uint64_t cursor = 0;
+  EXPECT_EQ(read_all(log, cursor), (std::vector<std::string>{"a", "b"}));
+  std::remove(path.c_str());
+}
+
+TEST(AppendLogTest, ConcurrentAppendsFromThreads) {
+  std::string path = temp_path("threads");
+  constexpr int kThreads = 8, kRecords = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      utils::AppendLog log;
+      ASSERT_TRUE(log.open(path, "mysql", 42, 1 << 20));
+      for (int i = 0; i < kRecords; ++i) {
+        std::string record = std::to_string(t) + ":" + std::to_string(i);
+        ASSERT_TRUE(log.append(record.data(), record.size()));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  utils::AppendLog log;
+  ASSERT_TRUE(log.open(path, "mysql", 42));
+  uint64_t cursor = 0;
+  auto records = read_all(log, cursor);
+  EXPECT_EQ(records.size(), kThreads * kRecords);
+  EXPECT_EQ(std::set<std::string>(records.begin(), records.end()).size(),
+            kThreads * kRecords);
+  std::remove(path.c_str());
+}
+
+TEST(AppendLogTest, ConcurrentAppendsFromProcesses) {
+  std::string path = temp_path("processes");
+  constexpr int kProcesses = 4, kRecords = 1000;
+  std::vector<pid_t> children;
+  for (int p = 0; p < kProcesses; ++p) {
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      utils::AppendLog log;
+      if (!log.open(path, "mysql", 42, 1 << 20)) _exit(1);
+      for (int i = 0; i < kRecords; ++i) {
+        std::string record = std::to_string(p) + ":" + std::to_string(i);
+        if (!log.append(record.data(), record.size())) _exit(1);
+      }
+      _exit(0);
+    }
+    children.push_back(pid);
+  }
+  for (auto pid : children) {
+    int status;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+
+  utils::AppendLog log;
+  ASSERT_TRUE(log.open(path, "mysql", 42));
+  uint64_t cursor = 0;
+  auto records = read_all(log, cursor);
+  EXPECT_EQ(std::set<std::string>(records.begin(), records.end()).size(),
+            kProcesses * kRecords);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include "arena.h"
+
+namespace {
+struct Node {
+  static void* operator new(size_t size) {
+    return utils::arena_aware_new(size);
+  }
+  static void operator delete(void* ptr) { utils::arena_aware_delete(ptr); }
+  long value = 0;
+};
+};  // namespace
+
+TEST(ArenaTest, AllocationsAreAligned) {
+  utils::Arena arena(64);
+  for (size_t size : {1, 7, 16, 33, 100}) {
+    void* ptr = arena.allocate(size);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignof(std::max_align_t), 0);
+  }
+  EXPECT_EQ(arena.allocations(), 5);
+}
+
+TEST(ArenaTest, ResetKeepsChunks) {
+  utils::Arena arena(256);
+  void* first = arena.allocate(200);
+  arena.allocate(200);
+  size_t reserved = arena.bytes_reserved();
+
+  arena.reset();
+  EXPECT_EQ(arena.allocations(), 0);
+  EXPECT_EQ(arena.allocate(200), first);
+  arena.allocate(200);
+  EXPECT_EQ(arena.bytes_reserved(), reserved);
+}
+
+TEST(ArenaTest, OversizedAllocationGetsItsOwnChunk) {
+  utils::Arena arena(64);
+  arena.allocate(1000);
+  EXPECT_GE(arena.bytes_reserved(), 1000);
+}
+
+TEST(ArenaTest, ScopeSelectsArena) {
+  utils::Arena arena;
+  EXPECT_EQ(utils::g_current_arena, nullptr);
+  {
+    utils::ArenaScope scope(&arena);
+    Node* node = new Node;
+    EXPECT_EQ(arena.allocations(), 1);
+    delete node;
+    {
+      utils::ArenaScope heap_scope(nullptr);
+      Node* heap_node = new Node;
+      EXPECT_EQ(arena.allocations(), 1);
+      delete heap_node;
+    }
+    EXPECT_EQ(utils::g_current_arena, &arena);
+  }
+  EXPECT_EQ(utils::g_current_arena, nullptr);
+}
@@ -0,0 +1,58 @@
+#include "batch.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using utils::BatchCoverage;
+
+TEST(BatchTest, SplitsWhatItJoins) {
+  std::vector<std::string> test_cases = {"SELECT 1;", "",
+                                         "CREATE TABLE t (a INT);"};
+  std::string input = utils::join_batch(test_cases);
+  std::vector<std::string_view> parts = utils::split_batch(input);
+  ASSERT_EQ(parts.size(), test_cases.size());
+  for (size_t i = 0; i < parts.size(); ++i) EXPECT_EQ(parts[i], test_cases[i]);
+}
+
+TEST(BatchTest, InputWithoutSeparatorIsOneTestCase) {
+  std::string input = "SELECT 1;\nSELECT 2;";
+  std::vector<std::string_view> parts = utils::split_batch(input);
+  ASSERT_EQ(parts.size(), 1u);
+  EXPECT_EQ(parts[0], input);
+}
+
+TEST(BatchTest, CoverageFindsNewEdgesAndBuckets) {
+  BatchCoverage coverage(4);
+  coverage.begin();
+  uint8_t first[4] = {1, 0, 0, 0};
+  EXPECT_TRUE(coverage.add(first));
+  // The same edge, in the same bucket.
+  EXPECT_FALSE(coverage.add(first));
+  // A new edge.
+  uint8_t second[4] = {1, 0, 1, 0};
+  EXPECT_TRUE(coverage.add(second));
+  // Known edges, one of them hit often enough for a new bucket.
+  uint8_t third[4] = {5, 0, 1, 0};
+  EXPECT_TRUE(coverage.add(third));
+  // 6 is in the same bucket as 5.
+  uint8_t fourth[4] = {6, 0, 0, 0};
+  EXPECT_FALSE(coverage.add(fourth));
+
+  uint8_t map[4] = {9, 9, 9, 9};
+  coverage.finish(map);
+  EXPECT_EQ(map[0], 6);
+  EXPECT_EQ(map[1], 0);
+  EXPECT_EQ(map[2], 1);
+  EXPECT_EQ(map[3], 0);
+
+  // A new batch starts from an empty union but remembers what was found.
+  coverage.begin();
+  EXPECT_FALSE(coverage.add(second));
+  coverage.finish(map);
+  EXPECT_EQ(map[0], 1);
+  EXPECT_EQ(map[2], 1);
+}
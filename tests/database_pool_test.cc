@@ -0,0 +1,101 @@
+#include "database_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using client::DatabasePool;
+using namespace std::chrono_literals;
+
+TEST(DatabasePoolTest, RecyclesEveryDatabaseBeforeHandingItOut) {
+  std::mutex mutex;
+  std::map<std::string, int> recycled;
+  DatabasePool pool({"db0", "db1", "db2"}, [&](const std::string &name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++recycled[name];
+    return true;
+  });
+
+  std::set<std::string> taken;
+  for (int i = 0; i < 3; ++i) {
+    auto name = pool.acquire(5s);
+    ASSERT_TRUE(name.has_value());
+    taken.insert(*name);
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(recycled[*name], 1);
+  }
+  EXPECT_EQ(taken, (std::set<std::string>{"db0", "db1", "db2"}));
+
+  // All are taken, so there is nothing to hand out.
+  EXPECT_FALSE(pool.acquire(10ms).has_value());
+
+  pool.release("db1");
+  auto name = pool.acquire(5s);
+  ASSERT_TRUE(name.has_value());
+  EXPECT_EQ(*name, "db1");
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(recycled["db1"], 2);
+  }
+
+  DatabasePool::Stats stats = pool.stats();
+  EXPECT_EQ(stats.acquired, 4u);
+  EXPECT_EQ(stats.timeouts, 1u);
+  EXPECT_EQ(stats.recycled, 4u);
+  EXPECT_EQ(stats.failures, 0u);
+  EXPECT_EQ(stats.backlog_max, 3u);
+  EXPECT_EQ(pool.ready(), 0u);
+  EXPECT_EQ(pool.backlog(), 0u);
+}
+
+TEST(DatabasePoolTest, CountsTheBacklog) {
+  std::mutex mutex;
+  std::unique_lock<std::mutex> blocked(mutex);
+  DatabasePool pool({"db0", "db1"}, [&](const std::string &) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return true;
+  });
+  // The thread is stuck on the first database until `blocked` is released.
+  EXPECT_FALSE(pool.acquire(10ms).has_value());
+  EXPECT_GE(pool.backlog(), 1u);
+  EXPECT_EQ(pool.stats().waits, 1u);
+  blocked.unlock();
+
+  auto first = pool.acquire(5s);
+  auto second = pool.acquire(5s);
+  ASSERT_TRUE(first.has_value() && second.has_value());
+  pool.release(*first);
+  pool.release(*second);
+  EXPECT_LE(pool.backlog(), 2u);
+  EXPECT_NE(pool.describe().find("2 acquired"), std::string::npos);
+}
+
+TEST(DatabasePoolTest, RetriesFailedRecycles) {
+  std::atomic<int> attempts{0};
+  DatabasePool pool({"db0"}, [&](const std::string &) {
+    // The server is down for the first two attempts.
+    return ++attempts > 2;
+  });
+
+  auto name = pool.acquire(5s);
+  ASSERT_TRUE(name.has_value());
+  EXPECT_EQ(*name, "db0");
+  EXPECT_EQ(attempts.load(), 3);
+}
+
+TEST(DatabasePoolTest, StopsWhileRetrying) {
+  // Destroying the pool must not wait for a recycle that never succeeds.
+  auto start = std::chrono::steady_clock::now();
+  {
+    DatabasePool pool({"db0"}, [](const std::string &) { return false; });
+    EXPECT_FALSE(pool.acquire(10ms).has_value());
+    EXPECT_EQ(pool.ready(), 0u);
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+}
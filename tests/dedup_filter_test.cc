@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "dedup_filter.h"
+#include "hash.h"
+
+TEST(DedupFilterTest, RemembersWhatItWasGiven) {
+  utils::DedupFilter filter(1 << 20);
+  for (uint64_t i = 0; i < 10000; ++i) EXPECT_FALSE(filter.insert(i * 7919));
+  for (uint64_t i = 0; i < 10000; ++i) EXPECT_TRUE(filter.insert(i * 7919));
+  EXPECT_EQ(filter.stats().inserted, 10000u);
+  EXPECT_EQ(filter.stats().duplicates, 10000u);
+  EXPECT_EQ(filter.stats().agings, 0u);
+}
+
+TEST(DedupFilterTest, StaysWithinItsErrorRate) {
+  utils::DedupFilter filter(1 << 20);
+  uint64_t false_positives = 0;
+  uint64_t count = filter.generation_capacity();
+  for (uint64_t i = 0; i < count; ++i) {
+    false_positives += filter.insert(utils::hash_mix(i));
+  }
+  // About 0.1% with one generation full.
+  EXPECT_LT(false_positives, count / 200);
+  EXPECT_EQ(filter.memory(), size_t(1) << 20);
+}
+
+TEST(DedupFilterTest, ForgetsTheOldestGeneration) {
+  utils::DedupFilter filter(1 << 16);
+  // Fills a first generation, then a second one, and starts a third one,
+  // which drops the first.
+  uint64_t i = 0;
+  while (filter.stats().agings < 2) filter.insert(i++);
+  uint64_t third = i - 1;
+
+  uint64_t remembered = 0;
+  for (uint64_t j = 0; j < 100; ++j) remembered += filter.insert(j);
+  EXPECT_LT(remembered, 10u);
+  for (uint64_t j = third - 100; j < third; ++j) {
+    EXPECT_TRUE(filter.insert(j));
+  }
+}
+
+TEST(DedupFilterTest, RepeatsStayRemembered) {
+  utils::DedupFilter filter(1 << 16);
+  uint64_t count = filter.generation_capacity();
+  for (uint64_t i = 0; i < 4 * count; ++i) {
+    filter.insert(i + 1);
+    // Seen again in every generation, so never forgotten.
+    EXPECT_TRUE(filter.insert(0) || i == 0);
+  }
+  EXPECT_GE(filter.stats().agings, 3u);
+}
+
+TEST(DedupFilterTest, MeasuresFalsePositivesOnASample) {
+  utils::DedupFilter filter(1 << 16);
+  uint64_t count = 64 * filter.generation_capacity();
+  for (uint64_t i = 0; i < count; ++i) filter.insert(utils::hash_mix(i));
+  auto &stats = filter.stats();
+  EXPECT_GT(stats.sampled_new, count / 2048);
+  EXPECT_LT(stats.sampled_new, count / 512);
+  EXPECT_LT(stats.false_positive_rate(), 0.02);
+  EXPECT_EQ(stats.inserted + stats.duplicates, count);
+}
@@ -0,0 +1,49 @@
+#include "doorbell.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+
+TEST(DoorbellTest, ReturnsAtOnceWhenReady) {
+  utils::Doorbell doorbell;
+  int checks = 0;
+  doorbell.wait([&] { return ++checks > 0; });
+  EXPECT_EQ(checks, 1);
+  // Nobody sleeps, so this only looks.
+  doorbell.ring();
+}
+
+TEST(DoorbellTest, WakesTheSleeper) {
+  utils::Doorbell doorbell;
+  std::atomic<bool> set{false};
+  std::thread sleeper([&] {
+    doorbell.wait([&] { return set.load(std::memory_order_relaxed); });
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  set.store(true, std::memory_order_relaxed);
+  doorbell.ring();
+  sleeper.join();
+}
+
+// Two threads hand a counter back and forth, each sleeping until the other
+// moved it. A single lost wake-up hangs the test.
+TEST(DoorbellTest, LosesNoWakeUps) {
+  constexpr uint64_t kRounds = 100000;
+  utils::Doorbell doorbell;
+  std::atomic<uint64_t> counter{0};
+  auto play = [&](uint64_t parity) {
+    for (uint64_t turn = parity; turn < 2 * kRounds; turn += 2) {
+      doorbell.wait(
+          [&] { return counter.load(std::memory_order_acquire) == turn; });
+      counter.store(turn + 1, std::memory_order_release);
+      doorbell.ring();
+    }
+  };
+  std::thread odd(play, 1);
+  play(0);
+  odd.join();
+  EXPECT_EQ(counter.load(), 2 * kRounds);
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include "generate.h"
+#include "rng.h"
+
+TEST(GenerateTest, ParseMode) {
+  utils::GenerateMode mode = utils::GenerateMode::kOff;
+  EXPECT_TRUE(utils::parse_generate_mode("mixed", &mode));
+  EXPECT_EQ(mode, utils::GenerateMode::kMixed);
+  EXPECT_TRUE(utils::parse_generate_mode("empty", &mode));
+  EXPECT_EQ(mode, utils::GenerateMode::kEmpty);
+  EXPECT_TRUE(utils::parse_generate_mode("false", &mode));
+  EXPECT_EQ(mode, utils::GenerateMode::kOff);
+  EXPECT_FALSE(utils::parse_generate_mode("always", &mode));
+  EXPECT_EQ(mode, utils::GenerateMode::kOff);
+}
+
+TEST(GenerateTest, RulesPickAtRandomWithoutBudget) {
+  utils::Rng rng(1);
+  utils::RngScope rng_scope(&rng);
+  bool picked[4] = {};
+  for (int i = 0; i < 200; ++i) {
+    utils::GenerateRule rule;
+    unsigned choice = rule.pick(4, 0);
+    ASSERT_LT(choice, 4u);
+    picked[choice] = true;
+  }
+  for (bool p : picked) EXPECT_TRUE(p);
+}
+
+TEST(GenerateTest, DepthBoundForcesTheShortestAlternative) {
+  utils::GenerateOptions options;
+  options.max_depth = 3;
+  utils::GenerateBudget budget(options);
+  utils::GenerateScope scope(&budget);
+  utils::GenerateRule first, second, third;
+  EXPECT_FALSE(budget.exhausted());
+  {
+    utils::GenerateRule fourth;
+    EXPECT_TRUE(budget.exhausted());
+    for (int i = 0; i < 20; ++i) EXPECT_EQ(fourth.pick(5, 2), 2u);
+  }
+  // Leaving a rule gives the depth back, not the rules.
+  EXPECT_FALSE(budget.exhausted());
+  EXPECT_EQ(budget.rules(), 4u);
+}
+
+TEST(GenerateTest, SizeBoundForcesTheShortestAlternative) {
+  utils::GenerateOptions options;
+  options.max_nodes = 10;
+  utils::GenerateBudget budget(options);
+  utils::GenerateScope scope(&budget);
+  for (int i = 0; i < 10; ++i) utils::GenerateRule sibling;
+  EXPECT_FALSE(budget.exhausted());
+  utils::GenerateRule last;
+  EXPECT_TRUE(budget.exhausted());
+  EXPECT_EQ(last.pick(3, 1), 1u);
+}
+
+TEST(GenerateTest, ScopeRestoresThePreviousBudget) {
+  utils::GenerateOptions options;
+  utils::GenerateBudget outer(options), inner(options);
+  {
+    utils::GenerateScope outer_scope(&outer);
+    {
+      utils::GenerateScope inner_scope(&inner);
+      utils::GenerateRule rule;
+    }
+    utils::GenerateRule rule;
+  }
+  EXPECT_EQ(utils::g_generate_budget, nullptr);
+  EXPECT_EQ(inner.rules(), 1u);
+  EXPECT_EQ(outer.rules(), 1u);
+}
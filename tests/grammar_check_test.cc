@@ -0,0 +1,43 @@
+#include "grammar_check.h"
+
+#include <gtest/gtest.h>
+
+TEST(GrammarCheckTest, ParsesValidateModes) {
+  utils::ValidateMode mode = utils::ValidateMode::kGrammar;
+  EXPECT_TRUE(utils::parse_validate_mode("reparse", &mode));
+  EXPECT_EQ(mode, utils::ValidateMode::kReparse);
+  EXPECT_TRUE(utils::parse_validate_mode("compare", &mode));
+  EXPECT_EQ(mode, utils::ValidateMode::kCompare);
+  EXPECT_TRUE(utils::parse_validate_mode("grammar", &mode));
+  EXPECT_EQ(mode, utils::ValidateMode::kGrammar);
+
+  EXPECT_FALSE(utils::parse_validate_mode("none", &mode));
+  EXPECT_EQ(mode, utils::ValidateMode::kGrammar);
+}
+
+TEST(GrammarCheckTest, KeysTellChildrenApart) {
+  using utils::ProductionSet;
+  uint64_t parent = ProductionSet::key(3, 7);
+  EXPECT_NE(parent, ProductionSet::key(7, 3));
+  EXPECT_NE(parent, ProductionSet::key(3, 8));
+
+  uint64_t left_only = ProductionSet::add_child(
+      ProductionSet::add_child(parent, true, 5), false, 0);
+  uint64_t right_only = ProductionSet::add_child(
+      ProductionSet::add_child(parent, false, 0), true, 5);
+  uint64_t none = ProductionSet::add_child(
+      ProductionSet::add_child(parent, false, 0), false, 0);
+  // A child with no attributes is still not a missing one.
+  uint64_t zero = ProductionSet::add_child(
+      ProductionSet::add_child(parent, true, 0), false, 0);
+  EXPECT_NE(left_only, right_only);
+  EXPECT_NE(left_only, none);
+  EXPECT_NE(zero, none);
+
+  ProductionSet productions;
+  EXPECT_TRUE(productions.insert(left_only));
+  EXPECT_FALSE(productions.insert(left_only));
+  EXPECT_TRUE(productions.contains(left_only));
+  EXPECT_FALSE(productions.contains(right_only));
+  EXPECT_EQ(productions.size(), 1u);
+}
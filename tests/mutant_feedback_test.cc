@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "mutant_feedback.h"
+#include "mutation_trace.h"
+
+using utils::MutantOrigin;
+using utils::MutationOperator;
+using utils::RecentMutants;
+
+TEST(MutantFeedbackTest, OriginOfTrace) {
+  utils::MutationTrace trace;
+  trace.strategy = utils::MutationStrategy::kReplace;
+  trace.side = 0;
+  trace.node_type = 7;
+  utils::LibraryPick pick;
+  pick.type = 7;
+  pick.index = 3;
+  pick.size = 10;
+  trace.library.push_back(pick);
+  MutantOrigin origin = MutantOrigin::of(trace);
+  EXPECT_EQ(origin.node_type, 7u);
+  EXPECT_EQ(origin.op, MutationOperator::kReplaceLeft);
+  ASSERT_EQ(origin.library.size(), 1u);
+  EXPECT_EQ(origin.library[0].index, 3u);
+}
+
+TEST(MutantFeedbackTest, TakesRecentMutantsOnce) {
+  RecentMutants recent;
+  MutantOrigin origin;
+  origin.node_type = 2;
+  origin.op = MutationOperator::kInsert;
+  recent.add(42, origin);
+  MutantOrigin taken;
+  EXPECT_FALSE(recent.take(43, &taken));
+  EXPECT_TRUE(recent.take(42, &taken));
+  EXPECT_EQ(taken.node_type, 2u);
+  EXPECT_EQ(taken.op, MutationOperator::kInsert);
+  EXPECT_FALSE(recent.take(42, &taken));
+}
+
+TEST(MutantFeedbackTest, ForgetsTheOldest) {
+  RecentMutants recent(4);
+  for (uint64_t mutant = 1; mutant <= 6; ++mutant) {
+    recent.add(mutant, MutantOrigin());
+  }
+  MutantOrigin taken;
+  EXPECT_FALSE(recent.take(1, &taken));
+  EXPECT_FALSE(recent.take(2, &taken));
+  for (uint64_t mutant = 3; mutant <= 6; ++mutant) {
+    EXPECT_TRUE(recent.take(mutant, &taken));
+  }
+}
@@ -0,0 +1,100 @@
+#include "mutant_pipeline.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <stack>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+// Turns every seed into `fanout` numbered mutants, and records what the
+// producer asks of it.
+class FakeDataBase : public DataBase {
+ public:
+  explicit FakeDataBase(size_t fanout) : fanout_(fanout) {}
+
+  bool initialize(YAML::Node) override { return true; }
+  size_t mutate(const std::string &seed) override {
+    for (size_t i = 0; i < fanout_; ++i) {
+      mutants_.push(seed + "#" + std::to_string(rounds_) + "." +
+                    std::to_string(i));
+    }
+    ++rounds_;
+    return mutants_.size();
+  }
+  std::string get_next_mutated_query() override {
+    auto result = mutants_.top();
+    mutants_.pop();
+    return result;
+  }
+  bool has_mutated_test_cases() override { return !mutants_.empty(); }
+  bool save_interesting_query(const std::string &query) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    saved_.push_back(query);
+    return true;
+  }
+
+  std::vector<std::string> saved() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return saved_;
+  }
+
+ private:
+  size_t fanout_;
+  size_t rounds_ = 0;
+  std::stack<std::string> mutants_;
+  std::mutex mutex_;
+  std::vector<std::string> saved_;
+};
+};  // namespace
+
+TEST(MutantPipelineTest, HandsOutMutantsOfTheSubmittedSeed) {
+  FakeDataBase db(4);
+  MutantPipeline pipeline(&db, 64);
+  size_t count = pipeline.submit("seed");
+  ASSERT_GT(count, 0u);
+  std::string mutant;
+  for (size_t i = 0; i < count; ++i) {
+    ASSERT_TRUE(pipeline.next(mutant));
+    EXPECT_EQ(mutant.rfind("seed#", 0), 0u);
+  }
+  EXPECT_EQ(pipeline.stats().consumed, count);
+}
+
+TEST(MutantPipelineTest, StaysAheadOfTheConsumer) {
+  FakeDataBase db(4);
+  MutantPipeline pipeline(&db, 16);
+  pipeline.submit("seed");
+  // With nothing taken out, the producer fills the ring and then stalls.
+  while (pipeline.stats().producer_stalls == 0) std::this_thread::yield();
+  EXPECT_EQ(pipeline.submit("seed"), 16u);
+
+  auto stats = pipeline.stats();
+  EXPECT_EQ(stats.occupancy_max, 16u);
+  EXPECT_GE(stats.produced, 16u);
+}
+
+TEST(MutantPipelineTest, EmptySeedsDoNotBlock) {
+  FakeDataBase db(0);
+  MutantPipeline pipeline(&db, 16);
+  EXPECT_EQ(pipeline.submit("seed"), 0u);
+  std::string mutant;
+  EXPECT_FALSE(pipeline.next(mutant));
+  EXPECT_EQ(pipeline.stats().consumer_waits, 1u);
+}
+
+TEST(MutantPipelineTest, ForwardsInterestingQueries) {
+  FakeDataBase db(1);
+  {
+    MutantPipeline pipeline(&db, 16);
+    pipeline.save_interesting_query("a");
+    pipeline.save_interesting_query("b");
+    // Submitting makes the producer go through the queued queries first.
+    pipeline.submit("seed");
+    while (db.saved().size() < 2) std::this_thread::yield();
+  }
+  EXPECT_EQ(db.saved(), std::vector<std::string>({"a", "b"}));
+}
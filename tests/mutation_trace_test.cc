@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mutation_trace.h"
+
+namespace {
+
+utils::MutationTrace sample_trace() {
+  utils::MutationTrace trace;
+  trace.seed_hash = 0x1f2e3d4c5b6a7988ULL;
+  trace.round = 0x9abcdef012345678ULL;
+  trace.node = 12;
+  trace.strategy = utils::MutationStrategy::kReplace;
+  trace.check = utils::CheckPath::kReparse;
+  trace.library = {{84, 3, 40, 0, 0xc1d2e3f405162738ULL},
+                   {84, utils::LibraryPick::kGenerated, 0, 0x5e},
+                   {84, utils::LibraryPick::kMemoized, 0, 0x07000001ULL << 32},
+                   {7, 0, 1, 0, 0x2a}};
+  return trace;
+}
+
+}  // namespace
+
+TEST(MutationTraceTest, EncodeDecodeRoundTrip) {
+  utils::MutationTrace trace = sample_trace();
+  std::string text = trace.encode();
+  EXPECT_EQ(text,
+            "seed=1f2e3d4c5b6a7988 round=9abcdef012345678 node=12 "
+            "strategy=replace check=reparse "
+            "library=84:3/40@c1d2e3f405162738,84:g000000000000005e/0,"
+            "84:m0700000100000000/0,7:0/1@000000000000002a");
+
+  utils::MutationTrace decoded;
+  ASSERT_TRUE(utils::MutationTrace::decode(text, &decoded));
+  EXPECT_EQ(decoded.seed_hash, trace.seed_hash);
+  EXPECT_EQ(decoded.round, trace.round);
+  EXPECT_EQ(decoded.node, trace.node);
+  EXPECT_EQ(decoded.strategy, trace.strategy);
+  EXPECT_EQ(decoded.check, trace.check);
+  EXPECT_EQ(decoded.library, trace.library);
+  EXPECT_EQ(decoded.validate_seed(), trace.validate_seed());
+  EXPECT_TRUE(decoded.generated());
+}
+
+TEST(MutationTraceTest, EmptyLibraryRoundTrip) {
+  utils::MutationTrace trace = sample_trace();
+  trace.strategy = utils::MutationStrategy::kDelete;
+  trace.check = utils::CheckPath::kGrammar;
+  trace.library.clear();
+
+  utils::MutationTrace decoded;
+  ASSERT_TRUE(utils::MutationTrace::decode(trace.encode(), &decoded));
+  EXPECT_TRUE(decoded.library.empty());
+  EXPECT_FALSE(decoded.generated());
+  EXPECT_EQ(decoded.strategy, utils::MutationStrategy::kDelete);
+  EXPECT_EQ(decoded.check, utils::CheckPath::kGrammar);
+}
+
+TEST(MutationTraceTest, DecodeRejectsMalformed) {
+  utils::MutationTrace trace;
+  std::string text = sample_trace().encode();
+  EXPECT_FALSE(utils::MutationTrace::decode("", &trace));
+  // A field missing.
+  EXPECT_FALSE(utils::MutationTrace::decode(
+      text.substr(0, text.find(" library=")), &trace));
+  EXPECT_FALSE(utils::MutationTrace::decode(text + " extra=1", &trace));
+  EXPECT_FALSE(utils::MutationTrace::decode(
+      "seed=xyz round=0 node=0 strategy=delete check=unknown library=",
+      &trace));
+  EXPECT_FALSE(utils::MutationTrace::decode(
+      "seed=0 round=0 node=0 strategy=swap check=unknown library=", &trace));
+  EXPECT_FALSE(utils::MutationTrace::decode(
+      "seed=0 round=0 node=0 strategy=delete check=unknown library=84:3",
+      &trace));
+  // An entry of the library without its hash, and a generated one with one.
+  EXPECT_FALSE(utils::MutationTrace::decode(
+      "seed=0 round=0 node=0 strategy=delete check=unknown library=84:3/40",
+      &trace));
+  EXPECT_FALSE(utils::MutationTrace::decode(
+      "seed=0 round=0 node=0 strategy=delete check=unknown "
+      "library=84:g5e/0@1",
+      &trace));
+}
+
+TEST(MutationTraceTest, SameEntriesIgnoreTheLibrarySize) {
+  utils::MutationTrace trace = sample_trace();
+  std::vector<utils::LibraryPick> library = trace.library;
+  EXPECT_TRUE(trace.same_entries(library));
+  // The library has grown since, but still holds the entry at its index.
+  library[0].size++;
+  EXPECT_TRUE(trace.same_entries(library));
+  EXPECT_NE(library, trace.library);
+  // Another entry is at that index now.
+  library[0].hash++;
+  EXPECT_FALSE(trace.same_entries(library));
+  library = trace.library;
+  library[1].tree_seed++;
+  EXPECT_FALSE(trace.same_entries(library));
+  library = trace.library;
+  library.pop_back();
+  EXPECT_FALSE(trace.same_entries(library));
+}
+
+TEST(MutationTraceTest, SeedsDependOnNodeAndStrategy) {
+  utils::MutationTrace a = sample_trace(), b = sample_trace();
+  EXPECT_EQ(a.node_seed(), utils::MutationTrace::node_seed(a.round, a.node));
+  b.node++;
+  EXPECT_NE(a.node_seed(), b.node_seed());
+  b = a;
+  b.strategy = utils::MutationStrategy::kInsert;
+  EXPECT_EQ(a.node_seed(), b.node_seed());
+  EXPECT_NE(a.validate_seed(), b.validate_seed());
+  EXPECT_NE(a.validate_seed(), a.node_seed());
+}
+
+TEST(MutationTraceTest, StripTrace) {
+  utils::MutationTrace trace = sample_trace();
+  std::string mutant = "SELECT 1;";
+  std::string test_case = utils::add_trace(trace, mutant);
+  EXPECT_EQ(test_case.rfind(utils::kTraceBegin, 0), 0u);
+
+  std::string_view text;
+  EXPECT_EQ(utils::strip_trace(test_case, &text), mutant);
+  EXPECT_EQ(text, trace.encode());
+
+  // A test case without a trace, or with a comment that is not closed,
+  // stays as it is.
+  EXPECT_EQ(utils::strip_trace(mutant, &text), mutant);
+  EXPECT_TRUE(text.empty());
+  std::string unclosed = std::string(utils::kTraceBegin) + "SELECT 1;";
+  EXPECT_EQ(utils::strip_trace(unclosed, &text), unclosed);
+  EXPECT_TRUE(text.empty());
+}
+
+TEST(MutationTraceTest, SeedHashIgnoresTheTrace) {
+  std::string seed = "SELECT a FROM t;";
+  utils::MutationTrace trace = sample_trace();
+  EXPECT_EQ(utils::seed_hash(utils::add_trace(trace, seed)),
+            utils::seed_hash(seed));
+  trace.node++;
+  EXPECT_EQ(utils::seed_hash(utils::add_trace(trace, seed)),
+            utils::seed_hash(seed));
+  EXPECT_NE(utils::seed_hash("SELECT b FROM t;"), utils::seed_hash(seed));
+}
@@ -0,0 +1,55 @@
+#include "mysql_status.h"
+
+#include "gtest/gtest.h"
+
+using namespace client;
+
+TEST(MySQLStatusTest, ErrorsOfTheStatements) {
+  EXPECT_EQ(mysql_error_status(0), kNormal);
+  EXPECT_EQ(mysql_error_status(kMySQLServerLost), kServerCrash);
+  EXPECT_EQ(mysql_error_status(kMySQLServerGoneError), kServerCrash);
+  EXPECT_EQ(mysql_error_status(kMySQLQueryInterrupted), kTimeout);
+  EXPECT_EQ(mysql_error_status(kMySQLQueryTimeout), kTimeout);
+  EXPECT_EQ(mysql_error_status(kMariaDBStatementTimeout), kTimeout);
+  EXPECT_EQ(mysql_error_status(kMySQLParseError), kSyntaxError);
+  // ER_NO_SUCH_TABLE
+  EXPECT_EQ(mysql_error_status(1146), kSemanticError);
+}
+
+TEST(MySQLStatusTest, LostConnectionIsACrash) {
+  // The server went away during the first statement.
+  EXPECT_EQ(mysql_test_case_status(kMySQLServerLost, kNormal, false),
+            kServerCrash);
+  EXPECT_EQ(mysql_test_case_status(kMySQLServerGoneError, kNormal, false),
+            kServerCrash);
+  // Or during a later one.
+  EXPECT_EQ(mysql_test_case_status(0, kServerCrash, false), kServerCrash);
+  // Even if the watchdog killed the query on the way.
+  EXPECT_EQ(mysql_test_case_status(kMySQLServerLost, kNormal, true),
+            kServerCrash);
+  EXPECT_EQ(mysql_test_case_status(0, kServerCrash, true), kServerCrash);
+}
+
+TEST(MySQLStatusTest, KilledOrTimedOutIsATimeout) {
+  // KILL QUERY from the watchdog, whatever the statements returned.
+  EXPECT_EQ(mysql_test_case_status(kMySQLQueryInterrupted, kNormal, true),
+            kTimeout);
+  EXPECT_EQ(mysql_test_case_status(0, kSemanticError, true), kTimeout);
+  // The server's own limit, without the watchdog.
+  EXPECT_EQ(mysql_test_case_status(kMySQLQueryTimeout, kNormal, false),
+            kTimeout);
+  EXPECT_EQ(mysql_test_case_status(0, kTimeout, false), kTimeout);
+}
+
+TEST(MySQLStatusTest, FailedFirstStatementDecides) {
+  // mysql_next_result finds nothing after a failed first statement.
+  EXPECT_EQ(mysql_test_case_status(kMySQLParseError, kNormal, false),
+            kSyntaxError);
+  EXPECT_EQ(mysql_test_case_status(1146, kNormal, false), kSemanticError);
+}
+
+TEST(MySQLStatusTest, OtherwiseTheStatusOfTheResults) {
+  EXPECT_EQ(mysql_test_case_status(0, kNormal, false), kNormal);
+  EXPECT_EQ(mysql_test_case_status(0, kSyntaxError, false), kSyntaxError);
+  EXPECT_EQ(mysql_test_case_status(0, kSemanticError, false), kSemanticError);
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+#include "mutation_trace.h"
+#include "operator_schedule.h"
+
+namespace {
+
+using utils::MutationOperator;
+
+utils::ScheduleOptions small_period() {
+  utils::ScheduleOptions options;
+  options.period = 900;
+  return options;
+}
+
+// Runs `period` mutants spread over the operators by the nominal mix, of
+// which those of `good` make a queue entry one time in ten.
+void run_period(utils::OperatorScheduler &scheduler, MutationOperator good,
+                uint64_t &next_mutant) {
+  for (int i = 0; i < 100; ++i) {
+    for (size_t o = 0; o < utils::kMutationOperators; ++o) {
+      int copies = MutationOperator(o) == MutationOperator::kInsert ? 3 : 1;
+      for (int c = 0; c < copies; ++c) {
+        uint64_t mutant = ++next_mutant;
+        scheduler.ran(1, MutationOperator(o));
+        if (MutationOperator(o) == good && mutant % 10 == 0) {
+          scheduler.found(1, MutationOperator(o));
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(OperatorScheduleTest, OperatorOfTrace) {
+  utils::MutationTrace trace;
+  trace.strategy = utils::MutationStrategy::kDelete;
+  trace.side = 2;
+  EXPECT_EQ(utils::mutation_operator(trace), MutationOperator::kDeleteBoth);
+  trace.strategy = utils::MutationStrategy::kReplace;
+  trace.side = 1;
+  EXPECT_EQ(utils::mutation_operator(trace), MutationOperator::kReplaceRight);
+  trace.strategy = utils::MutationStrategy::kInsert;
+  EXPECT_EQ(utils::mutation_operator(trace), MutationOperator::kInsert);
+  EXPECT_EQ(utils::mutation_operator(utils::MutationStrategy::kDelete, 1),
+            MutationOperator::kDeleteRight);
+  EXPECT_STREQ(utils::operator_name(MutationOperator::kReplaceRight),
+               "replace-right");
+}
+
+TEST(OperatorScheduleTest, KeepsEverythingBeforeLearning) {
+  utils::OperatorScheduler scheduler(4, small_period(), 1);
+  utils::Rng rng(1);
+  for (int i = 0; i < 1000; ++i) {
+    for (size_t o = 0; o < utils::kMutationOperators; ++o) {
+      EXPECT_TRUE(scheduler.keep(i % 4, MutationOperator(o), rng.uniform()));
+    }
+  }
+  EXPECT_EQ(scheduler.dropped(), 0u);
+}
+
+TEST(OperatorScheduleTest, LearnsTheOperatorThatFinds) {
+  utils::OperatorScheduler scheduler(4, small_period(), 1);
+  uint64_t next_mutant = 0;
+  for (int period = 0; period < 20; ++period) {
+    run_period(scheduler, MutationOperator::kReplaceLeft, next_mutant);
+  }
+  EXPECT_EQ(scheduler.updates(), 20u);
+  double sum = 0;
+  for (size_t o = 0; o < utils::kMutationOperators; ++o) {
+    double p = scheduler.probability(MutationOperator(o));
+    EXPECT_GT(p, 0.0);
+    sum += p;
+    if (MutationOperator(o) != MutationOperator::kReplaceLeft) {
+      EXPECT_GT(scheduler.probability(MutationOperator::kReplaceLeft), p);
+    }
+  }
+  EXPECT_NEAR(sum, 1.0, 1e-9);
+
+  int kept_good = 0, kept_bad = 0;
+  utils::Rng rng(1);
+  for (int i = 0; i < 10000; ++i) {
+    kept_good +=
+        scheduler.keep(1, MutationOperator::kReplaceLeft, rng.uniform());
+    kept_bad += scheduler.keep(1, MutationOperator::kDeleteLeft, rng.uniform());
+  }
+  EXPECT_GT(kept_good, 2 * kept_bad);
+  EXPECT_GT(kept_bad, 0);
+  EXPECT_GT(scheduler.dropped(), 0u);
+}
+
+TEST(OperatorScheduleTest, DumpNamesTheTypesThatRan) {
+  utils::OperatorScheduler scheduler(4, small_period(), 1);
+  scheduler.ran(3, MutationOperator::kDeleteRight);
+  scheduler.found(3, MutationOperator::kDeleteRight);
+  std::string dump = scheduler.dump(
+      [](uint32_t type) { return "type" + std::to_string(type); });
+  EXPECT_NE(dump.find("# operator delete-left delete-right"),
+            std::string::npos);
+  EXPECT_NE(dump.find("\ntype3 0/0 1/1 0/0"), std::string::npos);
+  EXPECT_EQ(dump.find("type2"), std::string::npos);
+}
+
+TEST(OperatorScheduleTest, NothingIsLearnedWithoutFinds) {
+  utils::OperatorScheduler scheduler(4, small_period(), 1);
+  for (int i = 0; i < 3 * 900; ++i) {
+    scheduler.ran(1, MutationOperator::kReplaceBoth);
+  }
+  EXPECT_EQ(scheduler.updates(), 3u);
+  EXPECT_DOUBLE_EQ(scheduler.probability(MutationOperator::kInsert), 1.0 / 3);
+  EXPECT_TRUE(scheduler.keep(1, MutationOperator::kDeleteLeft, 0.99));
+  EXPECT_EQ(scheduler.dropped(), 0u);
+}
@@ -0,0 +1,25 @@
+#include "postgresql_conninfo.h"
+
+#include "gtest/gtest.h"
+
+using namespace client;
+
+TEST(PostgreSQLConninfoTest, QuotesEveryValue) {
+  std::string conninfo;
+  append_conninfo(&conninfo, "host", "127.0.0.1");
+  append_conninfo(&conninfo, "port", "5432");
+  EXPECT_EQ(conninfo, "host='127.0.0.1' port='5432'");
+}
+
+TEST(PostgreSQLConninfoTest, KeepsSeparatorsInTheValue) {
+  std::string conninfo;
+  append_conninfo(&conninfo, "password", "a b=c");
+  append_conninfo(&conninfo, "user", "");
+  EXPECT_EQ(conninfo, "password='a b=c' user=''");
+}
+
+TEST(PostgreSQLConninfoTest, EscapesQuotesAndBackslashes) {
+  std::string conninfo;
+  append_conninfo(&conninfo, "password", R"(it's\x)");
+  EXPECT_EQ(conninfo, R"(password='it\'s\\x')");
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "rng.h"
+
+TEST(RngTest, SeedDecidesTheSequence) {
+  utils::Rng a(42), b(42), c(43);
+  std::vector<uint64_t> draws_a, draws_b, draws_c;
+  for (int i = 0; i < 100; ++i) {
+    draws_a.push_back(a.next());
+    draws_b.push_back(b.next());
+    draws_c.push_back(c.next());
+  }
+  EXPECT_EQ(draws_a, draws_b);
+  EXPECT_NE(draws_a, draws_c);
+
+  a.seed(43);
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(a.next(), draws_c[i]);
+}
+
+TEST(RngTest, BelowStaysInRange) {
+  utils::Rng rng(1);
+  for (uint64_t range : {uint64_t(1), uint64_t(2), uint64_t(7),
+                         uint64_t(1000), ~uint64_t(0)}) {
+    for (int i = 0; i < 1000; ++i) EXPECT_LT(rng.below(range), range);
+  }
+  EXPECT_EQ(rng.below(0), 0u);
+}
+
+TEST(RngTest, BelowIsUniform) {
+  utils::Rng rng(2);
+  constexpr int kDraws = 300000;
+  int counts[3] = {0, 0, 0};
+  for (int i = 0; i < kDraws; ++i) ++counts[rng.below(3)];
+  for (int count : counts) EXPECT_NEAR(count, kDraws / 3, kDraws / 100);
+
+  // With a range of 3 * 2^62, `next() % range` lands in the lower half 5
+  // times in 8.
+  const uint64_t range = uint64_t(3) << 62;
+  int lower = 0;
+  for (int i = 0; i < kDraws; ++i) lower += rng.below(range) < range / 2;
+  EXPECT_NEAR(lower, kDraws / 2, kDraws / 100);
+}
+
+TEST(RngTest, UniformStaysInTheUnitInterval) {
+  utils::Rng rng(3);
+  double sum = 0;
+  constexpr int kDraws = 100000;
+  for (int i = 0; i < kDraws; ++i) {
+    double draw = rng.uniform();
+    ASSERT_GE(draw, 0.0);
+    ASSERT_LT(draw, 1.0);
+    sum += draw;
+  }
+  EXPECT_NEAR(sum / kDraws, 0.5, 0.01);
+}
+
+TEST(RngTest, ScopeSetsTheCurrentGenerator) {
+  utils::Rng rng(3), copy(3);
+  {
+    utils::RngScope scope(&rng);
+    EXPECT_EQ(&utils::current_rng(), &rng);
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_EQ(utils::rand_below(1000), int(copy.below(1000)));
+    }
+  }
+  EXPECT_EQ(utils::g_current_rng, nullptr);
+  EXPECT_NE(&utils::current_rng(), &rng);
+}
+
+TEST(RngTest, RandBelowKeepsTheTypeOfTheRange) {
+  static_assert(std::is_same_v<decltype(utils::rand_below(3)), int>);
+  static_assert(
+      std::is_same_v<decltype(utils::rand_below(size_t(3))), size_t>);
+  EXPECT_LT(utils::rand_below(3), 3);
+}
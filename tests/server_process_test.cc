@@ -0,0 +1,123 @@
+#include "server_process.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+using client::ServerProcess;
+using namespace std::chrono_literals;
+
+namespace {
+
+// A server is up while its ready file exists.
+class ServerProcessTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ready_ = testing::TempDir() + "server_process_ready_" +
+             std::to_string(getpid());
+    std::remove(ready_.c_str());
+  }
+  void TearDown() override { std::remove(ready_.c_str()); }
+
+  ServerProcess::Probe probe() {
+    return [this] { return access(ready_.c_str(), F_OK) == 0; };
+  }
+  // Becomes ready after `delay` and exits after `lifetime`.
+  std::string command(const char *delay, const char *lifetime) {
+    return "sleep " + std::string(delay) + "; touch " + ready_ + "; sleep " +
+           lifetime + "; rm -f " + ready_ + " &";
+  }
+
+  std::string ready_;
+};
+
+TEST_F(ServerProcessTest, UsesTheServerThatIsUp) {
+  ServerProcess server("false", [] { return true; }, 1s);
+  EXPECT_TRUE(server.start());
+  EXPECT_EQ(server.pid(), -1);
+  EXPECT_EQ(server.stats().spawns, 0u);
+}
+
+TEST_F(ServerProcessTest, WaitsUntilTheServerIsUp) {
+  ServerProcess server(command("0.1", "10"), probe(), 5s);
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(server.start());
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+  EXPECT_NE(server.pid(), -1);
+  EXPECT_FALSE(server.exited());
+  kill(-server.pid(), SIGKILL);
+}
+
+TEST_F(ServerProcessTest, GivesUpOnAServerThatIsNeverUp) {
+  ServerProcess server("sleep 10", probe(), 200ms);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(server.start());
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 2s);
+  EXPECT_EQ(server.pid(), -1);
+}
+
+TEST_F(ServerProcessTest, ProbesTheServerACommandDaemonized) {
+  // Like pg_ctl start: the command exits with 0 before the server is up.
+  ServerProcess server("(sleep 0.2; touch " + ready_ + ") & exit 0", probe(),
+                       5s);
+  ASSERT_TRUE(server.start());
+  EXPECT_EQ(server.pid(), -1);
+  EXPECT_EQ(server.stats().spawns, 1u);
+}
+
+TEST_F(ServerProcessTest, WaitsOutADaemonizedServerThatIsNeverUp) {
+  ServerProcess server("true", probe(), 200ms);
+  EXPECT_FALSE(server.start());
+  EXPECT_EQ(server.stats().spawns, 1u);
+}
+
+TEST_F(ServerProcessTest, StartsAFailedCommandAgain) {
+  ServerProcess server("exit 1", probe(), 300ms);
+  EXPECT_FALSE(server.start());
+  EXPECT_GT(server.stats().spawns, 1u);
+}
+
+TEST_F(ServerProcessTest, RestartsTheServerAfterItExits) {
+  ServerProcess server(command("0", "0.2"), probe(), 5s);
+  ASSERT_TRUE(server.start());
+  pid_t first = server.pid();
+  while (!server.exited()) std::this_thread::sleep_for(10ms);
+
+  EXPECT_LT(server.recover(), 1s);
+  EXPECT_NE(server.pid(), -1);
+  EXPECT_NE(server.pid(), first);
+  EXPECT_EQ(server.stats().recoveries, 1u);
+  EXPECT_EQ(server.stats().spawns, 2u);
+  kill(-server.pid(), SIGKILL);
+}
+
+TEST_F(ServerProcessTest, NoticesTheExitWithoutWaitingTheTimeout) {
+  ServerProcess server(command("0", "0.2"), probe(), 30s);
+  ASSERT_TRUE(server.start());
+  // The server crashed but has not exited yet.
+  std::remove(ready_.c_str());
+  EXPECT_LT(server.recover(), 2s);
+  EXPECT_EQ(server.stats().spawns, 2u);
+  kill(-server.pid(), SIGKILL);
+}
+
+TEST_F(ServerProcessTest, KillsAServerThatDoesNotComeBack) {
+  ServerProcess server(command("0", "10"), probe(), 200ms);
+  ASSERT_TRUE(server.start());
+  pid_t wedged = server.pid();
+  std::remove(ready_.c_str());
+
+  server.recover();
+  EXPECT_NE(server.pid(), wedged);
+  EXPECT_NE(kill(wedged, 0), 0);
+  EXPECT_EQ(server.stats().spawns, 2u);
+  kill(-server.pid(), SIGKILL);
+}
+
+}  // namespace
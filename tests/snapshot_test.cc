@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "snapshot.h"
+
+namespace {
+enum Color { kRed, kGreen, kBlue };
+
+std::string temp_path(const char* name) {
+  return std::string("/tmp/snapshot_test_") + name + "." +
+         std::to_string(getpid());
+}
+
+void write_sample(const std::string& path) {
+  utils::SnapshotWriter writer;
+  writer.put(uint32_t(7));
+  writer.put(std::string("select"));
+  writer.put(std::vector<unsigned long>{1, 2, 3});
+  writer.put(std::map<Color, std::vector<std::string>>{{kGreen, {"a", ""}}});
+  writer.put(std::set<int>{-1, 4});
+  ASSERT_TRUE(writer.write_file(path, "sqlite", 42));
+}
+};  // namespace
+
+TEST(SnapshotTest, RoundTrip) {
+  std::string path = temp_path("round_trip");
+  write_sample(path);
+
+  utils::SnapshotReader reader;
+  ASSERT_TRUE(reader.open(path, "sqlite", 42));
+  uint32_t number;
+  std::string text;
+  std::vector<unsigned long> values;
+  std::map<Color, std::vector<std::string>> library;
+  std::set<int> ints;
+  EXPECT_TRUE(reader.get(number));
+  EXPECT_TRUE(reader.get(text));
+  EXPECT_TRUE(reader.get(values));
+  EXPECT_TRUE(reader.get(library));
+  EXPECT_TRUE(reader.get(ints));
+  EXPECT_TRUE(reader.done());
+
+  EXPECT_EQ(number, 7);
+  EXPECT_EQ(text, "select");
+  EXPECT_EQ(values, (std::vector<unsigned long>{1, 2, 3}));
+  EXPECT_EQ(library[kGreen], (std::vector<std::string>{"a", ""}));
+  EXPECT_EQ(ints, (std::set<int>{-1, 4}));
+  std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, RejectsOtherDialectsAndGrammars) {
+  std::string path = temp_path("header");
+  write_sample(path);
+
+  utils::SnapshotReader other_dialect, other_grammar;
+  EXPECT_FALSE(other_dialect.open(path, "mysql", 42));
+  EXPECT_FALSE(other_grammar.open(path, "sqlite", 43));
+  std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, RejectsCorruptedPayload) {
+  std::string path = temp_path("corrupted");
+  write_sample(path);
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(sizeof(utils::SnapshotHeader) + 6);
+    file.put('X');
+  }
+
+  utils::SnapshotReader reader;
+  EXPECT_FALSE(reader.open(path, "sqlite", 42));
+  std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, MisreadsFailInsteadOfOverrunning) {
+  std::string path = temp_path("past_end");
+  write_sample(path);
+
+  utils::SnapshotReader reader;
+  ASSERT_TRUE(reader.open(path, "sqlite", 42));
+  std::vector<std::string> wrong_type;
+  uint32_t number;
+  EXPECT_TRUE(reader.get(number));
+  // Read as a vector of strings, the bytes of "select" make up the length of
+  // the first element, which runs far off the end of the payload.
+  EXPECT_FALSE(reader.get(wrong_type));
+  EXPECT_FALSE(reader.ok());
+  EXPECT_FALSE(reader.done());
+  std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, MissingFile) {
+  utils::SnapshotReader reader;
+  EXPECT_FALSE(reader.open(temp_path("missing"), "sqlite", 42));
+}
+
+TEST(SnapshotTest, RecordsAreReadInPlace) {
+  struct Record {
+    uint32_t type;
+    uint64_t hash;
+  };
+  std::string path = temp_path("records");
+  {
+    utils::SnapshotWriter writer;
+    writer.put(uint8_t(1));
+    writer.put_records(std::vector<Record>{{3, 30}, {4, 40}});
+    writer.put(std::string("pool"));
+    ASSERT_TRUE(writer.write_file(path, "mysql", 42));
+  }
+
+  utils::SnapshotReader reader;
+  ASSERT_TRUE(reader.open(path, "mysql", 42));
+  uint8_t tag;
+  utils::RecordView<Record> records;
+  std::string_view pool;
+  EXPECT_TRUE(reader.get(tag));
+  // The records start at an odd offset, which RecordView copes with.
+  EXPECT_TRUE(reader.get(records));
+  EXPECT_TRUE(reader.get(pool));
+  EXPECT_TRUE(reader.done());
+  ASSERT_EQ(records.size(), 2);
+  EXPECT_EQ(records[1].type, 4);
+  EXPECT_EQ(records[1].hash, 40);
+  EXPECT_EQ(pool, "pool");
+  std::remove(path.c_str());
+}
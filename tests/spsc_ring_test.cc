@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+#include "spsc_ring.h"
+
+TEST(SpscRingTest, FillsUpToItsCapacity) {
+  utils::SpscRing<int> ring(3);
+  EXPECT_EQ(ring.capacity(), 4u);
+  for (int i = 0; i < 4; ++i) EXPECT_TRUE(ring.try_push(i));
+  int value = 42;
+  EXPECT_FALSE(ring.try_push(value));
+  EXPECT_EQ(value, 42);
+  EXPECT_EQ(ring.size(), 4u);
+
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(ring.try_pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(ring.try_pop(value));
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, WrapsAround) {
+  utils::SpscRing<std::string> ring(2);
+  std::string value;
+  for (int i = 0; i < 100; ++i) {
+    std::string in = std::to_string(i);
+    ASSERT_TRUE(ring.try_push(in));
+    ASSERT_TRUE(ring.try_pop(value));
+    EXPECT_EQ(value, std::to_string(i));
+  }
+}
+
+TEST(SpscRingTest, PassesEveryElementInOrderBetweenThreads) {
+  constexpr int kCount = 100000;
+  utils::SpscRing<std::string> ring(16);
+  std::thread producer([&] {
+    for (int i = 0; i < kCount; ++i) {
+      std::string value = std::to_string(i);
+      while (!ring.try_push(value)) std::this_thread::yield();
+    }
+  });
+  std::string value;
+  for (int i = 0; i < kCount; ++i) {
+    while (!ring.try_pop(value)) std::this_thread::yield();
+    ASSERT_EQ(value, std::to_string(i));
+  }
+  producer.join();
+  EXPECT_TRUE(ring.empty());
+}
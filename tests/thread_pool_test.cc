@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+TEST(ThreadPoolTest, RunsEveryTaskOnce) {
+  utils::ThreadPool pool(4);
+  EXPECT_EQ(pool.size(), 4u);
+  for (size_t count : {0, 1, 2, 7, 1000}) {
+    std::vector<std::atomic<int>> calls(count);
+    pool.run(count, [&](size_t i) { calls[i].fetch_add(1); });
+    for (auto &c : calls) EXPECT_EQ(c.load(), 1);
+  }
+}
+
+TEST(ThreadPoolTest, SingleThreadRunsInOrderInline) {
+  utils::ThreadPool pool(1);
+  EXPECT_EQ(pool.size(), 1u);
+  std::vector<size_t> order;
+  auto caller = std::this_thread::get_id();
+  pool.run(5, [&](size_t i) {
+    EXPECT_EQ(std::this_thread::get_id(), caller);
+    order.push_back(i);
+  });
+  EXPECT_EQ(order, std::vector<size_t>({0, 1, 2, 3, 4}));
+}
+
+TEST(ThreadPoolTest, WorkersFollowTheCallersArena) {
+  utils::ThreadPool pool(3);
+  auto caller = std::this_thread::get_id();
+
+  pool.run(200, [&](size_t) {
+    EXPECT_EQ(utils::g_current_arena, nullptr);
+  });
+
+  utils::Arena arena;
+  utils::ArenaScope scope(&arena);
+  pool.run(200, [&](size_t) {
+    // The caller keeps its arena; workers never share it.
+    if (std::this_thread::get_id() == caller) {
+      EXPECT_EQ(utils::g_current_arena, &arena);
+    } else {
+      EXPECT_NE(utils::g_current_arena, nullptr);
+      EXPECT_NE(utils::g_current_arena, &arena);
+    }
+  });
+  EXPECT_EQ(utils::g_current_arena, &arena);
+}
+
+TEST(ThreadPoolTest, WorkersDrawFromTheirOwnGenerator) {
+  utils::ThreadPool pool(3);
+  auto caller = std::this_thread::get_id();
+  pool.run(200, [&](size_t) {
+    bool own = utils::g_current_rng != nullptr;
+    EXPECT_EQ(own, std::this_thread::get_id() != caller);
+    utils::rand_below(10);
+  });
+  EXPECT_EQ(utils::g_current_rng, nullptr);
+}
+
+TEST(ThreadPoolTest, CallerSeedsTheWorkers) {
+  // The first draw of each worker thread.
+  auto first_draws = [](uint64_t seed) {
+    utils::ThreadPool pool(3);
+    utils::Rng rng(seed);
+    utils::RngScope scope(&rng);
+    std::vector<uint64_t> draws;
+    std::mutex mutex;
+    std::atomic<size_t> waiting{3};
+    pool.run(3, [&](size_t) {
+      uint64_t draw = utils::rand_below(uint64_t(1) << 62);
+      // Each of the three threads takes one task.
+      --waiting;
+      while (waiting != 0) std::this_thread::yield();
+      std::lock_guard<std::mutex> lock(mutex);
+      if (utils::g_current_rng != &rng) draws.push_back(draw);
+    });
+    std::sort(draws.begin(), draws.end());
+    return draws;
+  };
+  EXPECT_EQ(first_draws(1).size(), 2u);
+  EXPECT_EQ(first_draws(1), first_draws(1));
+  EXPECT_NE(first_draws(1), first_draws(2));
+}
+
+TEST(ThreadPoolTest, ReusedAcrossBatches) {
+  utils::ThreadPool pool(4);
+  std::atomic<size_t> sum{0};
+  for (int round = 0; round < 100; ++round) {
+    pool.run(10, [&](size_t i) { sum.fetch_add(i); });
+  }
+  EXPECT_EQ(sum.load(), 100u * 45);
+}
@@ -0,0 +1,52 @@
+#include "watchdog.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+using client::Watchdog;
+using namespace std::chrono_literals;
+
+TEST(WatchdogTest, FiresOncePastTheDeadline) {
+  std::atomic<int> fired{0};
+  Watchdog watchdog([&] { ++fired; });
+  watchdog.arm(10ms);
+  while (fired == 0) std::this_thread::sleep_for(1ms);
+  EXPECT_TRUE(watchdog.disarm());
+  std::this_thread::sleep_for(30ms);
+  EXPECT_EQ(fired.load(), 1);
+}
+
+TEST(WatchdogTest, StaysQuietWhenDisarmedInTime) {
+  std::atomic<int> fired{0};
+  Watchdog watchdog([&] { ++fired; });
+  for (int i = 0; i < 100; ++i) {
+    watchdog.arm(10s);
+    EXPECT_FALSE(watchdog.disarm());
+  }
+  EXPECT_EQ(fired.load(), 0);
+}
+
+TEST(WatchdogTest, RearmingMovesTheDeadline) {
+  std::atomic<int> fired{0};
+  Watchdog watchdog([&] { ++fired; });
+  watchdog.arm(10ms);
+  watchdog.arm(10s);
+  std::this_thread::sleep_for(50ms);
+  EXPECT_FALSE(watchdog.disarm());
+  EXPECT_EQ(fired.load(), 0);
+}
+
+TEST(WatchdogTest, DisarmWaitsForTheCallback) {
+  std::atomic<bool> done{false};
+  Watchdog watchdog([&] {
+    std::this_thread::sleep_for(50ms);
+    done = true;
+  });
+  watchdog.arm(1ms);
+  std::this_thread::sleep_for(20ms);
+  EXPECT_TRUE(watchdog.disarm());
+  EXPECT_TRUE(done.load());
+}